@@ -0,0 +1,102 @@
+/**
+ * \file bench_churn.c
+ *
+ * \brief Thread churn: many short-lived threads logging, and the arena memory they leave behind.
+ * \details
+ * `make bench-churn` builds this file at -O2 with Z_CHECK_HAS_ARENA and Z_CHECK_HAS_ASYNC, logging
+ * to the null sink. CHURN_THREADS threads are started CHURN_WIDTH at a time, each wave joined
+ * before the next. Most log a few records; every CHURN_HOT_EVERY-th logs CHURN_HOT_RECORDS, enough
+ * to grow its arena. Arenas go back to the free list as threads exit, so however many threads run
+ * in total, no more arenas are touched than run at once, and the bytes carved follow the hot
+ * threads rather than the thread count.
+ *
+ * The time per thread and the arena counters go to stderr; the exit status is 1 if more arenas
+ * were touched than threads ran at once.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define CHURN_THREADS       4096
+#define CHURN_WIDTH         8       /* threads running at once */
+#define CHURN_HOT_EVERY     16
+#define CHURN_COLD_RECORDS  4
+#define CHURN_HOT_RECORDS   2000
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowNs(void);
+static void * Churn(void *arg);
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    pthread_t threads[CHURN_WIDTH];
+    unsigned long ids[CHURN_WIDTH];
+    ZLogArenaStats_t stats;
+    ZLogAsyncStats_t async;
+    unsigned long started = 0;
+    double start;
+    double ns;
+    unsigned i;
+
+    start = NowNs();
+    while (started < CHURN_THREADS) {
+        for (i = 0; i < CHURN_WIDTH; i++) {
+            ids[i] = started++;
+            if (0 != pthread_create(&threads[i], NULL, Churn, &ids[i])) {
+                perror("pthread_create");
+                return 1;
+            }
+        }
+        for (i = 0; i < CHURN_WIDTH; i++) {
+            (void)pthread_join(threads[i], NULL);
+        }
+    }
+    ZLog_Flush();
+    ns = NowNs() - start;
+
+    ZLog_ArenaStatsGet(&stats);
+    ZLog_AsyncStatsGet(&async);
+    fprintf(stderr, "%d threads, %d at once: %.0f ns/thread\n", CHURN_THREADS, CHURN_WIDTH,
+            ns / CHURN_THREADS);
+    fprintf(stderr, "arenas touched %lu of %d, in use %lu; %lu bytes carved, %lu over budget\n",
+            stats.arenasTouched, Z_CHECK_ARENA_MAX_THREADS, stats.arenasInUse, stats.bytesCarved,
+            stats.overBudget);
+    fprintf(stderr, "records %lu written, %lu dropped; no arena %lu; 256 B high water %lu\n",
+            async.written, async.dropped, stats.noArena, stats.highWater[0]);
+    return (stats.arenasTouched > CHURN_WIDTH) ? 1 : 0;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowNs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+static void * Churn(void *arg) {
+    const unsigned long id = *(const unsigned long *)arg;
+    const unsigned records = (0 == (id % CHURN_HOT_EVERY)) ? CHURN_HOT_RECORDS : CHURN_COLD_RECORDS;
+    unsigned i;
+
+    for (i = 0; i < records; i++) {
+        Z_LOG(Z_INFO, "thread %lu record %u", id, i);
+    }
+    return NULL;
+}
@@ -0,0 +1,232 @@
+/**
+ * \file bench_file.c
+ *
+ * \brief High volume file logging: throughput, and what the log file does to the page cache.
+ * \details
+ * `make bench-file` builds this file at -O2 three times for the static Z_FILE target and runs them
+ * in the build directory: bench_file_buffered writes through the page cache, bench_file_direct
+ * past it with Z_CHECK_FILE_DIRECT, and bench_file_writeback through it, with the writer thread
+ * sending the file to disk and dropping it from the cache behind the sink, with
+ * Z_CHECK_FILE_WRITEBACK. Each first reads FILE_HOT_MB of a file of its own into the cache, the
+ * data an application would want to keep there, then logs FILE_LOG_MB of lines from one thread.
+ *
+ * The megabytes per second, then the log file's pages in the cache, the growth of Cached and Dirty
+ * in /proc/meminfo and the hot file's pages in the cache before and after go to stderr. Through
+ * the page cache the log stays resident, and on a machine short of memory pushes the hot file out;
+ * with O_DIRECT none of it should be in the cache, and with writeback little more than the last
+ * window and what was written since the last pass. The exit status is 1 if any line is missing
+ * from the file, or if the direct sink or the writeback failed a call.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define FILE_LOG_MB     256
+#define FILE_HOT_MB     64
+#define FILE_HOT_PATH   "bench_file.hot"
+#define FILE_PAYLOAD    160     /* characters of filler per line */
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowNs(void);
+static void MakeHot(void);
+static double Resident(const char *path);
+static long MemInfoKb(const char *field);
+static unsigned long CountLines(void);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static char m_payload[FILE_PAYLOAD + 1]; /* Flawfinder: ignore */
+    /* Warning: Statically-sized array
+       "Ignore" justification: filled with memset() to FILE_PAYLOAD, then terminated. */
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    const unsigned long long target = (unsigned long long)FILE_LOG_MB * 1024u * 1024u;
+    unsigned long long bytes = 0;
+    unsigned long lines = 0;
+    unsigned long found;
+    struct stat info;
+    long cached;
+    long dirty;
+    double hot;
+    double start;
+    double s;
+    int bad = 0;
+
+    memset(m_payload, 'x', FILE_PAYLOAD);
+    (void)unlink(Z_CHECK_LOG_FILE_PATH);
+    MakeHot();
+    hot = Resident(FILE_HOT_PATH);
+    cached = MemInfoKb("Cached:");
+    dirty = MemInfoKb("Dirty:");
+
+    start = NowNs();
+    while (bytes < target) {
+        Z_LOG(Z_INFO, "record %lu %s", lines, m_payload);
+        lines++;
+        bytes += FILE_PAYLOAD + 64u;    /* about the prefix and the line number */
+    }
+    ZLog_Flush();
+    s = (NowNs() - start) / 1e9;
+
+    if (0 != stat(Z_CHECK_LOG_FILE_PATH, &info)) {
+        info.st_size = 0;
+    }
+    fprintf(stderr, "%lu lines in %.2f s, %.0f MB/s\n", lines, s,
+            ((double)info.st_size / (1024.0 * 1024.0)) / s);
+    fprintf(stderr, "log file %.1f%% in the cache; Cached %+ld MB, Dirty %+ld MB; "
+            "hot file %.1f%% in the cache, was %.1f%%\n", Resident(Z_CHECK_LOG_FILE_PATH),
+            (MemInfoKb("Cached:") - cached) / 1024, (MemInfoKb("Dirty:") - dirty) / 1024,
+            Resident(FILE_HOT_PATH), hot);
+#ifdef Z_CHECK_FILE_DIRECT
+    {
+        ZLogFileDirectStats_t stats;
+
+        ZLog_FileDirectStatsGet(&stats);
+        fprintf(stderr, "%lu writes, %lu tails, %lu failures%s\n", stats.writes, stats.tails,
+                stats.failures, stats.buffered ? "; O_DIRECT refused, written buffered" : "");
+        bad = (0 != stats.failures);
+    }
+#endif
+#ifdef Z_CHECK_FILE_WRITEBACK
+    {
+        ZLogFileWritebackStats_t stats;
+
+        ZLog_FileWritebackStatsGet(&stats);
+        fprintf(stderr, "%lu passes, %lu MB sent to writeback, %lu MB dropped, %lu failures\n",
+                stats.passes, stats.started / (1024u * 1024u), stats.dropped / (1024u * 1024u),
+                stats.failures);
+        bad = (0 != stats.failures);
+    }
+#endif
+
+    found = CountLines();
+    if (found != lines) {
+        fprintf(stderr, "%lu lines logged, %lu found\n", lines, found);
+        bad = 1;
+    }
+    (void)unlink(FILE_HOT_PATH);
+    return bad;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowNs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+/* Write the hot file and read it back, so that it starts out in the cache */
+static void MakeHot(void) {
+    static char block[1024 * 1024]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: written and read by its size. */
+    FILE * const hot = fopen(FILE_HOT_PATH, "w+");
+    unsigned i;
+
+    if (NULL == hot) {
+        return;
+    }
+    memset(block, 'h', sizeof(block));
+    for (i = 0; i < FILE_HOT_MB; i++) {
+        (void)fwrite(block, 1, sizeof(block), hot);
+    }
+    (void)fflush(hot);
+    rewind(hot);
+    while (sizeof(block) == fread(block, 1, sizeof(block), hot)) {
+    }
+    (void)fclose(hot);
+}
+
+/* Percent of the file's pages in the page cache */
+static double Resident(const char *path) {
+    const long page = sysconf(_SC_PAGESIZE);
+    struct stat info;
+    unsigned char *vec;
+    void *map;
+    size_t pages;
+    size_t in = 0;
+    size_t i;
+    int fd;
+
+    fd = open(path, O_RDONLY); /* Flawfinder: ignore */
+    if ((-1 == fd) || (0 != fstat(fd, &info)) || (0 == info.st_size)) {
+        if (-1 != fd) {
+            (void)close(fd);
+        }
+        return 0.0;
+    }
+    pages = ((size_t)info.st_size + (size_t)page - 1u) / (size_t)page;
+    map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    vec = malloc(pages);
+    if ((MAP_FAILED != map) && (NULL != vec) && (0 == mincore(map, (size_t)info.st_size, vec))) {
+        for (i = 0; i < pages; i++) {
+            in += vec[i] & 1u;
+        }
+    }
+    free(vec);
+    if (MAP_FAILED != map) {
+        (void)munmap(map, (size_t)info.st_size);
+    }
+    (void)close(fd);
+    return (100.0 * (double)in) / (double)pages;
+}
+
+static long MemInfoKb(const char *field) {
+    char line[128]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: fgets() is bounded by sizeof(line). */
+    FILE * const info = fopen("/proc/meminfo", "r");
+    long kb = 0;
+
+    while ((NULL != info) && (NULL != fgets(line, sizeof(line), info))) {
+        if (0 == strncmp(line, field, strlen(field))) {
+            kb = strtol(&line[strlen(field)], NULL, 10);
+            break;
+        }
+    }
+    if (NULL != info) {
+        (void)fclose(info);
+    }
+    return kb;
+}
+
+/* Whole lines of the benchmark in the log file */
+static unsigned long CountLines(void) {
+    char line[1024]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: fgets() is bounded by sizeof(line). */
+    FILE * const log = fopen(Z_CHECK_LOG_FILE_PATH, "r");
+    unsigned long lines = 0;
+
+    while ((NULL != log) && (NULL != fgets(line, sizeof(line), log))) {
+        lines += ((NULL != strstr(line, "record ")) && (NULL != strchr(line, '\n'))) ? 1u : 0u;
+    }
+    if (NULL != log) {
+        (void)fclose(log);
+    }
+    return lines;
+}
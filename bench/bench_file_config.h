@@ -0,0 +1,24 @@
+/**
+ * \file bench_file_config.h
+ *
+ * \brief z_check configuration for the file benchmark.
+ * \details
+ * Selected by `make bench-file`, which runs from the build directory, so the log lands in
+ * build/bench_file.log. The direct build adds Z_CHECK_FILE_DIRECT on the command line, the
+ * writeback build Z_CHECK_FILE_WRITEBACK and the writer thread, with passes close enough together
+ * to see in a run of a second or two.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "file"
+#define Z_CHECK_LOG_FUNC        Z_FILE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_LOG_FILE_PATH   "bench_file.log"
+
+#ifdef Z_CHECK_FILE_WRITEBACK
+#define Z_CHECK_FILE_WRITEBACK_MS       100
+#endif
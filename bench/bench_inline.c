@@ -0,0 +1,83 @@
+/**
+ * \file bench_inline.c
+ *
+ * \brief Compare the cost of Z_LOG call sites with and without header-only mode.
+ * \details
+ * `make bench` builds this file twice at -O2: linked against a separately compiled z_check.o,
+ * and with Z_CHECK_HEADER_ONLY and Z_CHECK_IMPLEMENTATION, where the level check, constant
+ * messages and the sink inline into each call site. Output goes to /dev/null; results are
+ * printed to stderr in ns per call.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <time.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define ITERATIONS 2000000
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowNs(void);
+static void Report(const char * const name, const double startNs);
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    int status = 0;
+    double start;
+    int i;
+
+    if (NULL == freopen("/dev/null", "w", stdout)) {
+        perror("freopen");
+        return 1;
+    }
+#ifdef Z_CHECK_HEADER_ONLY
+    fprintf(stderr, "header-only:\n");
+#else
+    fprintf(stderr, "separate library:\n");
+#endif
+
+    start = NowNs();
+    for (i = 0; i < ITERATIONS; i++) {
+        Z_LOG(Z_DEBUG, "filtered %d", i);
+    }
+    Report("filtered by level", start);
+
+    start = NowNs();
+    for (i = 0; i < ITERATIONS; i++) {
+        Z_LOG(Z_INFO, "constant message");
+    }
+    Report("constant message", start);
+
+    start = NowNs();
+    for (i = 0; i < ITERATIONS; i++) {
+        Z_LOG(Z_INFO, "formatted %d of %s", i, "bench");
+    }
+    Report("formatted message", start);
+
+    return status;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowNs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+static void Report(const char * const name, const double startNs) {
+    fprintf(stderr, "    %-20s %8.2f ns/call\n", name, (NowNs() - startNs) / ITERATIONS);
+}
@@ -0,0 +1,414 @@
+/**
+ * \file bench_latency.c
+ *
+ * \brief Per-call latency percentiles of Z_LOG and Z_CHECK for each sink, under sink stalls.
+ * \details
+ * `make bench-latency` builds this file at -O2 with bench_latency_config.h once per sink, each
+ * synchronous and with Z_CHECK_HAS_ASYNC. Each binary runs with 1, 8 and 64 threads that read the
+ * cycle counter around every call, while a disturber thread stalls the sink for BENCH_STALL_US
+ * out of every BENCH_STALL_EVERY_US:
+ *
+ *      stdout, stderr  holds the stream's stdio lock (both point at /dev/null)
+ *      syslog          keeps calling syslog() itself, contending for its lock and socket
+ *      file            writes BENCH_STALL_BYTES beside the log file and fdatasync()s them
+ *      null            nothing: Z_CAPTURE with no buffer, so what is left is the formatting
+ *
+ * Percentiles go to stderr in ns. Histograms go to the file named by the only argument, one block
+ * per thread count and op, separated by blank lines as gnuplot's `index` expects.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <syslog.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define BENCH_STALL_US          2000
+#define BENCH_STALL_EVERY_US    50000
+#define BENCH_MAX_THREADS       64
+
+#if (Z_CHECK_LOG_FUNC == Z_STDOUT)
+    #define BENCH_SINK          "stdout"
+#elif (Z_CHECK_LOG_FUNC == Z_STDERR)
+    #define BENCH_SINK          "stderr"
+#elif (Z_CHECK_LOG_FUNC == Z_SYSLOG)
+    #define BENCH_SINK          "syslog"
+    #ifndef BENCH_CALLS
+    #define BENCH_CALLS         16000   /* each call is a round trip to the daemon */
+    #endif
+#elif (Z_CHECK_LOG_FUNC == Z_FILE)
+    #define BENCH_SINK          "file"
+    #define BENCH_STALL_BYTES   (1024 * 1024)
+    #define BENCH_STALL_PATH    Z_CHECK_LOG_FILE_PATH ".disturb"
+#elif (Z_CHECK_LOG_FUNC == Z_CAPTURE) && (0 == Z_CHECK_CAPTURE_SIZE)
+    #define BENCH_SINK          "null"
+#else
+    #error "bench_latency covers the stdout, stderr, syslog, file and null sinks"
+#endif
+
+#ifndef BENCH_CALLS
+#define BENCH_CALLS             128000  /* calls of each op per run, over all threads */
+#endif
+
+#ifdef Z_CHECK_HAS_ASYNC
+    #define BENCH_MODE          "async"
+#else
+    #define BENCH_MODE          "sync"
+#endif
+
+/* Log-linear histogram: values below HIST_SUB exactly, then HIST_SUB buckets per power of two */
+#define HIST_SUB_BITS           3
+#define HIST_SUB                (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS            ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+#define OP_LOG                  0
+#define OP_CHECK                1
+#define OPS                     2
+
+
+/******************************************************************************
+ *                                                                      Types */
+typedef struct Hist_s
+{
+    unsigned long long counts[HIST_BUCKETS];
+    unsigned long long total;
+    unsigned long long max;
+} Hist_t;
+
+typedef struct Worker_s
+{
+    pthread_t thread;
+    unsigned index;
+    unsigned long calls;
+    Hist_t hists[OPS];
+} Worker_t;
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static unsigned long long Cycles(void);
+static double CalibrateCyclesPerNs(void);
+static void SleepUs(const unsigned long us);
+static unsigned HistBucket(const unsigned long long cycles) __attribute__((const));
+static unsigned long long HistFloor(const unsigned idx) __attribute__((const));
+static void HistAdd(Hist_t * const hist, const unsigned long long cycles);
+static void HistMerge(Hist_t * const into, const Hist_t * const from);
+static unsigned long long HistPercentile(const Hist_t * const hist, const unsigned perTenThousand)
+    __attribute__((pure));
+static int BenchCheck(const unsigned long i);
+static void *Work(void *arg);
+static void *Disturb(void *arg);
+static void Run(const unsigned threads, FILE * const histFile);
+static void Report(const unsigned threads, const char * const op, const Hist_t * const hist,
+                   FILE * const histFile);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static const unsigned m_threadCounts[] = { 1, 8, BENCH_MAX_THREADS };
+static const char * const m_opNames[OPS] = { "Z_LOG", "Z_CHECK" };
+
+static FILE *m_report;
+static double m_cyclesPerNs;
+static pthread_barrier_t m_start;
+static int m_done;
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(const int argc, char ** const argv) {
+    FILE *histFile;
+    size_t t;
+
+    if (2 != argc) {
+        fprintf(stderr, "usage: %s HISTOGRAM_FILE\n", argv[0]);
+        return 1;
+    }
+    /* report on the original stderr; the sinks under test write to /dev/null */
+    m_report = fdopen(dup(STDERR_FILENO), "w");
+    histFile = fopen(argv[1], "w");
+    if ((NULL == m_report) || (NULL == histFile) ||
+        (NULL == freopen("/dev/null", "w", stdout)) ||
+        (NULL == freopen("/dev/null", "w", stderr))) {
+        perror("bench_latency");
+        return 1;
+    }
+    setvbuf(m_report, NULL, _IOLBF, 0);
+
+    m_cyclesPerNs = CalibrateCyclesPerNs();
+    fprintf(m_report, "%s %s, %.3f cycles/ns, %d calls of each op per run, "
+            "stall %d us every %d us:\n", BENCH_MODE, BENCH_SINK, m_cyclesPerNs, BENCH_CALLS,
+            BENCH_STALL_US, BENCH_STALL_EVERY_US);
+    fprintf(m_report, "    %-7s %-7s %9s %9s %9s %9s %9s\n", "threads", "op", "p50 ns", "p90",
+            "p99", "p99.9", "max");
+
+    for (t = 0; t < sizeof(m_threadCounts) / sizeof(m_threadCounts[0]); t++) {
+        Run(m_threadCounts[t], histFile);
+    }
+
+    (void)fclose(histFile);
+#if (Z_CHECK_LOG_FUNC == Z_FILE)
+    (void)remove(Z_CHECK_LOG_FILE_PATH);
+#endif
+    return 0;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static unsigned long long Cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((unsigned long long)now.tv_sec * 1000000000ull) + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+static double CalibrateCyclesPerNs(void) {
+    struct timespec before;
+    struct timespec after;
+    unsigned long long start;
+    double ns;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &before);
+    start = Cycles();
+    SleepUs(100000);
+    (void)clock_gettime(CLOCK_MONOTONIC, &after);
+    ns = ((double)(after.tv_sec - before.tv_sec) * 1e9) + (double)(after.tv_nsec - before.tv_nsec);
+    return (double)(Cycles() - start) / ns;
+}
+
+static void SleepUs(const unsigned long us) {
+    struct timespec delay;
+
+    delay.tv_sec = (time_t)(us / 1000000);
+    delay.tv_nsec = (long)((us % 1000000) * 1000);
+    while (0 != nanosleep(&delay, &delay)) {
+    }
+}
+
+static unsigned HistBucket(const unsigned long long cycles) {
+    unsigned exp;
+
+    if (cycles < HIST_SUB) {
+        return (unsigned)cycles;
+    }
+    exp = 63u - (unsigned)__builtin_clzll(cycles);
+    return ((exp - HIST_SUB_BITS + 1) * HIST_SUB) +
+           (unsigned)((cycles >> (exp - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static unsigned long long HistFloor(const unsigned idx) {
+    unsigned exp;
+
+    if (idx < HIST_SUB) {
+        return idx;
+    }
+    exp = (idx / HIST_SUB) + HIST_SUB_BITS - 1;
+    return (unsigned long long)(HIST_SUB + (idx % HIST_SUB)) << (exp - HIST_SUB_BITS);
+}
+
+static void HistAdd(Hist_t * const hist, const unsigned long long cycles) {
+    hist->counts[HistBucket(cycles)]++;
+    hist->total++;
+    if (cycles > hist->max) {
+        hist->max = cycles;
+    }
+}
+
+static void HistMerge(Hist_t * const into, const Hist_t * const from) {
+    unsigned i;
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+/* Highest value of the bucket holding the given rank, so a percentile is never understated */
+static unsigned long long HistPercentile(const Hist_t * const hist, const unsigned perTenThousand) {
+    unsigned long long rank = ((hist->total * perTenThousand) + 9999) / 10000;
+    unsigned long long seen = 0;
+    unsigned i;
+
+    if (0 == rank) {
+        rank = 1;
+    }
+    for (i = 0; i < HIST_BUCKETS - 1; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            const unsigned long long top = HistFloor(i + 1) - 1;
+            return (top < hist->max) ? top : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+static int BenchCheck(const unsigned long i) {
+    int status = 0;
+
+    Z_CHECK(i < BENCH_CALLS, -1, Z_WARN, "bench check %lu failed", i);
+
+cleanup:
+    return status;
+}
+
+static void *Work(void *arg) {
+    Worker_t * const worker = (Worker_t *)arg;
+    unsigned long long start;
+    unsigned long i;
+
+    (void)pthread_barrier_wait(&m_start);
+    for (i = 0; i < worker->calls; i++) {
+        start = Cycles();
+        Z_LOG(Z_INFO, "bench record %lu of thread %u, %s", i, worker->index, "and some padding");
+        HistAdd(&worker->hists[OP_LOG], Cycles() - start);
+
+        start = Cycles();
+        (void)BenchCheck(i);
+        HistAdd(&worker->hists[OP_CHECK], Cycles() - start);
+    }
+    return NULL;
+}
+
+static void *Disturb(void *arg) {
+#if (Z_CHECK_LOG_FUNC == Z_FILE)
+    char * const block = (char *)calloc(1, BENCH_STALL_BYTES);
+    const int fd = open(BENCH_STALL_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+
+    UNUSED_VARIABLE(arg);
+    while (!__atomic_load_n(&m_done, __ATOMIC_ACQUIRE)) {
+        SleepUs(BENCH_STALL_EVERY_US);
+#if (Z_CHECK_LOG_FUNC == Z_STDOUT) || (Z_CHECK_LOG_FUNC == Z_STDERR)
+        flockfile((Z_CHECK_LOG_FUNC == Z_STDOUT) ? stdout : stderr);
+        SleepUs(BENCH_STALL_US);
+        funlockfile((Z_CHECK_LOG_FUNC == Z_STDOUT) ? stdout : stderr);
+#elif (Z_CHECK_LOG_FUNC == Z_SYSLOG)
+        {
+            const double until = (double)Cycles() + (BENCH_STALL_US * 1000.0 * m_cyclesPerNs);
+            while ((double)Cycles() < until) {
+                syslog(LOG_DEBUG, "bench_latency disturber");
+            }
+        }
+#elif (Z_CHECK_LOG_FUNC == Z_FILE)
+        if ((NULL != block) && (fd >= 0) &&
+            (BENCH_STALL_BYTES == write(fd, block, BENCH_STALL_BYTES))) {
+            (void)fdatasync(fd);
+            (void)lseek(fd, 0, SEEK_SET);
+        }
+#endif
+    }
+#if (Z_CHECK_LOG_FUNC == Z_FILE)
+    if (fd >= 0) {
+        (void)close(fd);
+        (void)remove(BENCH_STALL_PATH);
+    }
+    free(block);
+#endif
+    return NULL;
+}
+
+static void Run(const unsigned threads, FILE * const histFile) {
+    Worker_t * const workers = (Worker_t *)calloc(threads, sizeof(*workers));
+    Hist_t * const merged = (Hist_t *)calloc(OPS, sizeof(*merged));
+    pthread_t disturber;
+    unsigned i;
+    unsigned op;
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLogAsyncStats_t before;
+    ZLogAsyncStats_t after;
+#endif
+
+    if ((NULL == workers) || (NULL == merged)) {
+        fprintf(m_report, "    out of memory for %u threads\n", threads);
+        free(workers);
+        free(merged);
+        return;
+    }
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncStatsGet(&before);
+#endif
+
+    __atomic_store_n(&m_done, 0, __ATOMIC_RELEASE);
+    (void)pthread_barrier_init(&m_start, NULL, threads);
+    (void)pthread_create(&disturber, NULL, Disturb, NULL);
+    for (i = 0; i < threads; i++) {
+        workers[i].index = i;
+        workers[i].calls = BENCH_CALLS / threads;
+        (void)pthread_create(&workers[i].thread, NULL, Work, &workers[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        (void)pthread_join(workers[i].thread, NULL);
+        for (op = 0; op < OPS; op++) {
+            HistMerge(&merged[op], &workers[i].hists[op]);
+        }
+    }
+    __atomic_store_n(&m_done, 1, __ATOMIC_RELEASE);
+    (void)pthread_join(disturber, NULL);
+    (void)pthread_barrier_destroy(&m_start);
+
+    ZLog_Flush();
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncStatsGet(&after);
+#endif
+
+    for (op = 0; op < OPS; op++) {
+        Report(threads, m_opNames[op], &merged[op], histFile);
+    }
+#ifdef Z_CHECK_HAS_ASYNC
+    if (after.dropped != before.dropped) {
+        fprintf(m_report, "    %-7u %lu records dropped\n", threads,
+                after.dropped - before.dropped);
+    }
+#endif
+    free(workers);
+    free(merged);
+}
+
+static void Report(const unsigned threads, const char * const op, const Hist_t * const hist,
+                   FILE * const histFile) {
+    static const unsigned percentiles[] = { 5000, 9000, 9900, 9990 };
+    unsigned i;
+
+    fprintf(m_report, "    %-7u %-7s", threads, op);
+    for (i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        fprintf(m_report, " %9.0f", (double)HistPercentile(hist, percentiles[i]) / m_cyclesPerNs);
+    }
+    fprintf(m_report, " %9.0f\n", (double)hist->max / m_cyclesPerNs);
+
+    fprintf(histFile, "# %s %s %u threads %s: %llu calls, max %.0f ns\n# from_ns to_ns count\n",
+            BENCH_MODE, BENCH_SINK, threads, op, hist->total, (double)hist->max / m_cyclesPerNs);
+    for (i = 0; i < HIST_BUCKETS - 1; i++) {
+        if (0 != hist->counts[i]) {
+            fprintf(histFile, "%.1f %.1f %llu\n", (double)HistFloor(i) / m_cyclesPerNs,
+                    (double)HistFloor(i + 1) / m_cyclesPerNs, hist->counts[i]);
+        }
+    }
+    if (0 != hist->counts[HIST_BUCKETS - 1]) {
+        fprintf(histFile, "%.1f %.1f %llu\n", (double)HistFloor(HIST_BUCKETS - 1) / m_cyclesPerNs,
+                (double)hist->max / m_cyclesPerNs, hist->counts[HIST_BUCKETS - 1]);
+    }
+    fprintf(histFile, "\n\n");
+}
@@ -0,0 +1,18 @@
+/**
+ * \file bench_latency_config.h
+ *
+ * \brief z_check configuration for the latency benchmark.
+ * \details
+ * Selected by `make bench-latency`, which builds one binary per sink and mode: the Makefile sets
+ * Z_CHECK_LOG_FUNC, and adds Z_CHECK_HAS_ARENA and Z_CHECK_HAS_ASYNC for the async binaries.
+ * `make bench-churn` uses it too, with the null sink, async.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "bench"
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_LOG_FILE_PATH   "bench_latency.log"
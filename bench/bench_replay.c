@@ -0,0 +1,115 @@
+/**
+ * \file bench_replay.c
+ *
+ * \brief Replay a recorded mix of log calls against the configuration this file is built with.
+ * \details
+ * The mix comes from a real log: `tools/zlogb.py mix BINARY LOG > mix.h` writes one function per
+ * call site that fired, with the site's level and format and samples of the arguments it was
+ * called with, and the order the sites fired in. Z_LOGB() sites replay as Z_LOGB(), or as Z_LOG()
+ * where Z_LOGB is not configured; Z_LOG() lines in the log replay as "%s" of their message. The
+ * cheapest recording is a Z_CHECK_LOGB_IDS build, whose records are already site IDs and raw
+ * arguments.
+ *
+ * `make replay REPLAY_BINARY=... REPLAY_LOG=... REPLAY_CFLAGS=...` builds this file around the
+ * mix with the given configuration and runs it: REPLAY_PASSES passes over the calls, at full
+ * speed, with the level at Z_DEBUG so every recorded call is written again. stdout goes to
+ * /dev/null; the time per call goes to stderr.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <time.h>
+
+#ifndef REPLAY_MIX
+    #error "define REPLAY_MIX as the path of a mix from tools/zlogb.py mix"
+#endif
+#include REPLAY_MIX
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define REPLAY_PASSES   10
+#define REPLAY_TOP      10      /* sites listed by calls */
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowNs(void);
+static void Replay(void);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static const size_t m_calls = sizeof(m_replayCalls) / sizeof(m_replayCalls[0]);
+static const size_t m_sites = sizeof(m_replaySites) / sizeof(m_replaySites[0]);
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    static unsigned long counts[sizeof(m_replaySites) / sizeof(m_replaySites[0])];
+    const size_t shown = (m_sites < REPLAY_TOP) ? m_sites : REPLAY_TOP;
+    double start;
+    double ns;
+    size_t i;
+    size_t n;
+    unsigned pass;
+
+    if (NULL == freopen("/dev/null", "w", stdout)) {
+        perror("freopen");
+        return 1;
+    }
+    ZLog_LevelSet(Z_DEBUG);
+
+    Replay();   /* warm up caches and register the sites */
+    start = NowNs();
+    for (pass = 0; pass < REPLAY_PASSES; pass++) {
+        Replay();
+    }
+    ZLog_Flush();
+    ns = NowNs() - start;
+
+    fprintf(stderr, "%lu calls at %lu sites, %d passes: %.1f ns/call\n", (unsigned long)m_calls,
+            (unsigned long)m_sites, REPLAY_PASSES, ns / ((double)m_calls * REPLAY_PASSES));
+
+    for (i = 0; i < m_calls; i++) {
+        counts[m_replayCalls[i][0]]++;
+    }
+    for (n = 0; n < shown; n++) {
+        size_t top = 0;
+
+        for (i = 1; i < m_sites; i++) {
+            top = (counts[i] > counts[top]) ? i : top;
+        }
+        if (0 == counts[top]) {
+            break;
+        }
+        fprintf(stderr, "    %6.2f%%  %s\n", 100.0 * (double)counts[top] / (double)m_calls,
+                m_replayNames[top]);
+        counts[top] = 0;
+    }
+    return 0;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowNs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+static void Replay(void) {
+    size_t i;
+
+    for (i = 0; i < m_calls; i++) {
+        m_replaySites[m_replayCalls[i][0]](m_replayCalls[i][1]);
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * \file bench_spool.c
+ *
+ * \brief Durable logging: lines per second when every caller waits for its line to be synced.
+ * \details
+ * `make bench-spool` builds this file at -O2 for the Z_SPOOL target and runs it in the build
+ * directory. For each count in SPOOL_THREADS, that many threads log for SPOOL_RUN_MS, each
+ * waiting on the ticket of every line before logging the next, as a server would before
+ * acknowledging a request. With one fdatasync() per commit whatever the number of waiters, the
+ * lines per second should grow with the threads while the syncs per second stay about the same.
+ *
+ * Each run's lines per second, syncs and lines per sync go to stderr. After the last run, the
+ * segments are read back; the exit status is 1 if a wait failed or any line of this process
+ * is missing from them. The segments are left for `tools/zlog_ship.py`.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define SPOOL_THREADS       { 1, 4, 16, 64 }
+#define SPOOL_MAX_THREADS   64
+#define SPOOL_RUN_MS        1000
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowNs(void);
+static void * Logger(void *arg);
+static unsigned long CountLines(void);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static int m_stop;
+static unsigned long m_failures;
+static char m_tag[32]; /* Flawfinder: ignore */
+    /* Warning: Statically-sized array
+       "Ignore" justification: snprintf() is bounded by sizeof(m_tag). */
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    static const unsigned counts[] = SPOOL_THREADS;
+    pthread_t threads[SPOOL_MAX_THREADS];
+    unsigned ids[SPOOL_MAX_THREADS];
+    ZLogSpoolStats_t before;
+    ZLogSpoolStats_t after;
+    struct timespec run = { SPOOL_RUN_MS / 1000, (SPOOL_RUN_MS % 1000) * 1000000L };
+    unsigned long found;
+    unsigned c;
+    unsigned i;
+
+    (void)snprintf(m_tag, sizeof(m_tag), " P%lu ", (unsigned long)getpid());
+    for (c = 0; c < (sizeof(counts) / sizeof(counts[0])); c++) {
+        double start;
+        double s;
+
+        ZLog_SpoolStatsGet(&before);
+        __atomic_store_n(&m_stop, 0, __ATOMIC_RELAXED);
+        start = NowNs();
+        for (i = 0; i < counts[c]; i++) {
+            ids[i] = i;
+            if (0 != pthread_create(&threads[i], NULL, Logger, &ids[i])) {
+                perror("pthread_create");
+                return 1;
+            }
+        }
+        (void)nanosleep(&run, NULL);
+        __atomic_store_n(&m_stop, 1, __ATOMIC_RELAXED);
+        for (i = 0; i < counts[c]; i++) {
+            (void)pthread_join(threads[i], NULL);
+        }
+        s = (NowNs() - start) / 1e9;
+        ZLog_SpoolStatsGet(&after);
+
+        fprintf(stderr, "%2u threads: %8.0f lines/s, %6.0f syncs/s, %6.1f lines/sync\n",
+                counts[c], (double)(after.lines - before.lines) / s,
+                (double)(after.commits - before.commits) / s,
+                (double)(after.lines - before.lines) /
+                    (double)((after.commits > before.commits) ? (after.commits - before.commits)
+                                                              : 1u));
+    }
+
+    ZLog_Flush();
+    ZLog_SpoolStatsGet(&after);
+    found = CountLines();
+    fprintf(stderr, "%lu lines in %lu segments, %lu found; %lu stalls, %lu failed commits, "
+            "%lu failed waits\n", after.lines, after.segments, found, after.stalls,
+            after.failures, m_failures);
+    return ((0 != m_failures) || (found != after.lines)) ? 1 : 0;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowNs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+static void * Logger(void *arg) {
+    const unsigned id = *(const unsigned *)arg;
+    unsigned long n;
+
+    for (n = 0; !__atomic_load_n(&m_stop, __ATOMIC_RELAXED); n++) {
+        Z_LOG(Z_INFO, "request%sT%u R%lu", m_tag, id, n);
+        if (0 != ZLog_SpoolWait(ZLog_SpoolTicket())) {
+            (void)__atomic_fetch_add(&m_failures, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+/* Lines of this process in the segments, sealed or not */
+static unsigned long CountLines(void) {
+    char path[512]; /* Flawfinder: ignore */
+    char line[1024]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: snprintf() and fgets() are bounded by the sizes. */
+    DIR * const dir = opendir(Z_CHECK_SPOOL_DIR);
+    const struct dirent *entry;
+    unsigned long lines = 0;
+
+    if (NULL == dir) {
+        return 0;
+    }
+    while (NULL != (entry = readdir(dir))) {
+        FILE *segment;
+
+        if ((NULL == strstr(entry->d_name, ".open")) && (NULL == strstr(entry->d_name, ".log"))) {
+            continue;
+        }
+        (void)snprintf(path, sizeof(path), "%s/%s", Z_CHECK_SPOOL_DIR, entry->d_name);
+        segment = fopen(path, "r");
+        while ((NULL != segment) && (NULL != fgets(line, sizeof(line), segment))) {
+            lines += (NULL != strstr(line, m_tag)) ? 1u : 0u;
+        }
+        if (NULL != segment) {
+            (void)fclose(segment);
+        }
+    }
+    (void)closedir(dir);
+    return lines;
+}
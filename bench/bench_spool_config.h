@@ -0,0 +1,19 @@
+/**
+ * \file bench_spool_config.h
+ *
+ * \brief z_check configuration for the spool benchmark.
+ * \details
+ * Selected by `make bench-spool`, which runs from the build directory, so the segments land in
+ * build/spool. Segments are kept small so that the run rolls through several of them.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "spool"
+#define Z_CHECK_LOG_FUNC        Z_SPOOL
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_SPOOL_DIR       "spool"
+#define Z_CHECK_SPOOL_SEGMENT   1048576
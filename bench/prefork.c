@@ -0,0 +1,293 @@
+/**
+ * \file prefork.c
+ *
+ * \brief Prefork workers logging through the shared ring, some killed mid-stream.
+ * \details
+ * `make prefork` builds this file with Z_CHECK_HAS_SHARED_RING and runs it. The parent creates
+ * the ring and forks PREFORK_WORKERS workers, each logging PREFORK_RECORDS numbered records of
+ * random length in random bursts, while a thread of the parent drains the ring into prefork.log.
+ * Every PREFORK_KILL_EVERY-th worker is killed with SIGKILL at a random point, maybe in the middle
+ * of a slot, and reaped at once, as a prefork master would; all but the last, which stays a
+ * zombie until the others are done, as under a master slow to reap. Once all are reaped, the
+ * parent logs one last line of its own.
+ *
+ * The run passes when every line is whole, each worker's numbers only go up, their gaps add up to
+ * no more than the lines the ring reports dropped or lost, and the parent's last line comes out:
+ * a slot left half-written by a killed worker must not hold back the ones after it. So every slot
+ * claimed and never published must have been recovered, and no more than PREFORK_MAX_DROP_PCT
+ * of the records dropped, as they would be behind a wedged slot. The counters and the lines per
+ * second go to stderr; a failed log is kept for a look.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define PREFORK_WORKERS     64
+#define PREFORK_RECORDS     4000
+#define PREFORK_BURST       16      /* most records a worker logs between naps */
+#define PREFORK_NAP_US      4000
+#define PREFORK_KILL_EVERY  8
+#define PREFORK_KILL_STEP_US 50000  /* most time between kills */
+#define PREFORK_MAX_PAD     400     /* keeps every line within the 512 byte line buffer */
+#define PREFORK_DRAIN_NAP_US 200    /* drain thread's nap when the ring is empty */
+#define PREFORK_SETTLE_US   3000000 /* longest the ring may take to empty once workers are gone */
+#define PREFORK_MAX_DROP_PCT 5      /* of all records; a ring that keeps draining drops far fewer */
+#define PREFORK_FD          100
+#define PREFORK_LOG         "prefork.log"
+
+
+/******************************************************************************
+ *                                                                      Types */
+typedef struct Totals_s
+{
+    unsigned long lines;
+    unsigned long broken;       /* torn, garbled or unknown lines */
+    unsigned long reordered;    /* numbers that went down or repeated */
+    unsigned long missing;      /* gaps in the numbers */
+    unsigned long killed;
+    int done;                   /* the parent's last line came out */
+} Totals_t;
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowUs(void);
+static void SleepUs(const unsigned long us);
+static void * Drain(void *unused);
+static void WorkerRun(const unsigned index) __attribute__((noreturn));
+static void CheckLog(void);
+static int CheckPad(const char * const pad, const unsigned len, const unsigned long start)
+    __attribute__((pure));
+static void CheckLine(const char * const line);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static char m_pad[26 + PREFORK_MAX_PAD + 1];    /* 'a' to 'z' over and over */
+static unsigned long m_expect[PREFORK_WORKERS]; /* checker: next record number per worker */
+static Totals_t m_totals;
+static int m_stop;
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    pid_t pids[PREFORK_WORKERS];
+    pid_t zombie = 0;
+    pthread_t drainer;
+    ZLogSharedRingStats_t stats;
+    unsigned seed = 1;
+    double start;
+    double deadline;
+    unsigned i;
+    int fd;
+    int failed;
+
+    for (i = 0; i < sizeof(m_pad) - 1; i++) {
+        m_pad[i] = (char)('a' + (i % 26));
+    }
+    fd = open(PREFORK_LOG, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if ((fd < 0) || (PREFORK_FD != dup2(fd, PREFORK_FD)) || (0 != ZLog_SharedRingCreate())) {
+        perror("prefork");
+        return 1;
+    }
+    (void)close(fd);
+    (void)pthread_create(&drainer, NULL, Drain, NULL);
+
+    start = NowUs();
+    for (i = 0; i < PREFORK_WORKERS; i++) {
+        pids[i] = fork();
+        if (0 == pids[i]) {
+            WorkerRun(i);
+        }
+    }
+    for (i = 0; i < PREFORK_WORKERS; i += PREFORK_KILL_EVERY) {
+        SleepUs((unsigned)rand_r(&seed) % PREFORK_KILL_STEP_US);
+        if ((0 < pids[i]) && (0 == kill(pids[i], SIGKILL))) {
+            m_totals.killed++;
+            if ((i + PREFORK_KILL_EVERY) < PREFORK_WORKERS) {
+                (void)waitpid(pids[i], NULL, 0);
+                pids[i] = 0;
+            }
+            else {
+                zombie = pids[i];
+            }
+        }
+    }
+    for (i = 0; i < PREFORK_WORKERS; i++) {
+        if ((0 < pids[i]) && (zombie != pids[i])) {
+            (void)waitpid(pids[i], NULL, 0);
+        }
+    }
+    Z_LOG(Z_INFO, "done");
+
+    /* whatever slot a killed worker left half-written is freed, the zombie's as well */
+    deadline = NowUs() + PREFORK_SETTLE_US;
+    do {
+        SleepUs(10000);
+        ZLog_SharedRingStatsGet(&stats);
+    } while (((stats.drained != stats.appended) ||
+              (stats.recovered != (stats.claimed - stats.appended))) && (NowUs() < deadline));
+    __atomic_store_n(&m_stop, 1, __ATOMIC_RELAXED);
+    (void)pthread_join(drainer, NULL);
+    ZLog_Flush();
+    ZLog_SharedRingStatsGet(&stats);
+    if (0 < zombie) {
+        (void)waitpid(zombie, NULL, 0);
+    }
+    CheckLog();
+
+    failed = (0 != m_totals.broken) || (0 != m_totals.reordered) || !m_totals.done ||
+             (m_totals.missing > stats.dropped + stats.lost) ||
+             (stats.recovered != (stats.claimed - stats.appended)) ||
+             ((stats.dropped * 100u) > (PREFORK_WORKERS * PREFORK_RECORDS * PREFORK_MAX_DROP_PCT));
+    fprintf(stderr, "prefork: %u workers, %lu killed, %lu lines in %.2f s (%.0f lines/s)\n",
+            PREFORK_WORKERS, m_totals.killed, m_totals.lines, (NowUs() - start) / 1e6,
+            (double)m_totals.lines * 1e6 / (NowUs() - start));
+    fprintf(stderr, "    ring: %lu claimed, %lu appended, %lu drained, %lu dropped, %lu recovered, "
+            "%lu lost\n", stats.claimed, stats.appended, stats.drained, stats.dropped,
+            stats.recovered, stats.lost);
+    fprintf(stderr, "    %lu missing, %lu broken lines, %lu out of order, last line %s\n",
+            m_totals.missing, m_totals.broken, m_totals.reordered,
+            m_totals.done ? "written" : "MISSING");
+    fprintf(stderr, "    %s\n", failed ? "FAIL" : "PASS");
+    if (!failed) {
+        (void)remove(PREFORK_LOG);
+    }
+    return failed;
+}
+
+void prefork_write(const char * const buf, const size_t len) {
+    (void)!write(PREFORK_FD, buf, len);
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowUs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+static void SleepUs(const unsigned long us) {
+    struct timespec delay;
+
+    delay.tv_sec = (time_t)(us / 1000000);
+    delay.tv_nsec = (long)((us % 1000000) * 1000);
+    while (0 != nanosleep(&delay, &delay)) {
+    }
+}
+
+static void * Drain(void *unused) {
+    (void)unused;
+    while (!__atomic_load_n(&m_stop, __ATOMIC_RELAXED)) {
+        if (0 == ZLog_SharedRingDrain()) {
+            SleepUs(PREFORK_DRAIN_NAP_US);
+        }
+    }
+    return NULL;
+}
+
+static void WorkerRun(const unsigned index) {
+    unsigned seed = index + 1;
+    unsigned long n = 0;
+
+    while (n < PREFORK_RECORDS) {
+        const unsigned burst = 1 + ((unsigned)rand_r(&seed) % PREFORK_BURST);
+        unsigned i;
+
+        for (i = 0; (i < burst) && (n < PREFORK_RECORDS); i++, n++) {
+            const unsigned len = (unsigned)rand_r(&seed) % (PREFORK_MAX_PAD + 1);
+
+            Z_LOG(Z_INFO, "rec W%u S%lu L%u %.*s E%u.%lu", index, n, len, (int)len,
+                  &m_pad[n % 26], index, n);
+        }
+        SleepUs((unsigned)rand_r(&seed) % PREFORK_NAP_US);
+    }
+    _exit(0);
+}
+
+static void CheckLog(void) {
+    char line[1024]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: fgets() is bounded by sizeof(line). */
+    FILE * const log = fopen(PREFORK_LOG, "r");
+
+    if (NULL == log) {
+        m_totals.broken++;
+        return;
+    }
+    while (NULL != fgets(line, sizeof(line), log)) {
+        m_totals.lines++;
+        CheckLine(line);
+    }
+    (void)fclose(log);
+}
+
+static int CheckPad(const char * const pad, const unsigned len, const unsigned long start) {
+    unsigned i;
+
+    for (i = 0; i < len; i++) {
+        if (pad[i] != m_pad[(start + i) % 26]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void CheckLine(const char * const line) {
+    const char * const end = strchr(line, '\n');
+    const char *body;
+    unsigned worker;
+    unsigned worker2;
+    unsigned len;
+    unsigned long n;
+    unsigned long n2;
+    int at = -1;
+    int tail = -1;
+
+    if ((NULL == end) || ('\0' != end[1]) || (0 != strncmp(line, "prefork: [", 10))) {
+        m_totals.broken++;
+    }
+    else if (NULL != (body = strstr(line, ": rec W"))) {
+        if ((3 == sscanf(body, ": rec W%u S%lu L%u %n", &worker, &n, &len, &at)) && (at >= 0) &&
+            (worker < PREFORK_WORKERS) && CheckPad(body + at, len, n % 26) &&
+            (2 == sscanf(body + at + len, " E%u.%lu%n", &worker2, &n2, &tail)) &&
+            (body + at + len + tail == end) && (worker2 == worker) && (n2 == n)) {
+            if (n < m_expect[worker]) {
+                m_totals.reordered++;
+            }
+            else {
+                m_totals.missing += n - m_expect[worker];
+                m_expect[worker] = n + 1;
+            }
+        }
+        else {
+            m_totals.broken++;
+        }
+    }
+    else if ((NULL != (body = strstr(line, ": done\n"))) && ('\0' == body[7])) {
+        m_totals.done = 1;
+    }
+    else {
+        m_totals.broken++;
+    }
+}
@@ -0,0 +1,19 @@
+/**
+ * \file prefork_config.h
+ *
+ * \brief z_check configuration for the prefork test.
+ * \details
+ * Selected by `make prefork`. Lines from every process go through the shared ring; the parent
+ * drains it to prefork_write(), which writes each line with a single write().
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "prefork"
+#define Z_CHECK_LOG_FUNC        Z_WRITE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_WRITE_FUNC      prefork_write
+#define Z_CHECK_HAS_SHARED_RING
@@ -0,0 +1,488 @@
+/**
+ * \file soak.c
+ *
+ * \brief Long-running stress test: no lost, repeated, reordered or torn records.
+ * \details
+ * `make soak SOAK_SECONDS=n` builds this file synchronous and with Z_CHECK_HAS_ASYNC and runs each
+ * for n seconds. SOAK_THREADS threads log numbered records of random length in random bursts,
+ * plus Z_DEBUG noise. Meanwhile the main thread, every SOAK_TICK_US:
+ *
+ *      flips the level between Z_INFO and Z_DEBUG with ZLog_LevelSet()/ZLog_LevelReset()
+ *      forks now and then; the child logs SOAK_CHILD_RECORDS records of its own and exits
+ *      every SOAK_SWAP_US, moves the sink to a new file (dup2() over its descriptor), then
+ *      checks and deletes the file before last, which no write can still be reaching
+ *
+ * A file passes when every line is whole, every record's padding and end tag match its number,
+ * each thread's numbers only go up, and each child forked into it shows up with all of its
+ * records. At the end, each thread's gaps must add up to no more than the records the async
+ * writer reports dropped (none, synchronously), and resident memory must not have grown by more
+ * than SOAK_RSS_GROWTH_KB since the first second. Failed files are kept for a look.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define SOAK_THREADS            8
+#define SOAK_BURST              32      /* most records a thread logs between naps */
+#define SOAK_NAP_US             2000
+#define SOAK_MAX_PAD            400     /* keeps every line within the 512 byte line buffer */
+#define SOAK_TICK_US            10000
+#define SOAK_SWAP_US            1000000
+#define SOAK_FORK_PERCENT       5       /* chance of a fork each tick */
+#define SOAK_CHILD_RECORDS      16
+#define SOAK_CHILD_WAIT_US      2000000
+#define SOAK_MAX_CHILDREN       64      /* per file; forks beyond this wait for the next file */
+#define SOAK_RSS_GROWTH_KB      4096
+#define SOAK_FD                 100     /* the sink's descriptor; files are dup2()'d onto it */
+
+#ifdef Z_CHECK_HAS_ASYNC
+    #define SOAK_MODE           "async"
+#else
+    #define SOAK_MODE           "sync"
+#endif
+
+
+/******************************************************************************
+ *                                                                      Types */
+typedef struct Worker_s
+{
+    pthread_t thread;
+    unsigned index;
+    unsigned seed;
+    unsigned long records;      /* records logged; read once the thread is joined */
+    unsigned long noise;
+    unsigned long expect;       /* checker: next record number not yet accounted for */
+} Worker_t;
+
+typedef struct Child_s
+{
+    long pid;
+    unsigned long expect;       /* next record number */
+    int broken;
+} Child_t;
+
+typedef struct Totals_s
+{
+    unsigned long lines;
+    unsigned long broken;       /* torn, garbled or unknown lines */
+    unsigned long reordered;    /* numbers that went down or repeated */
+    unsigned long missing;      /* gaps in the numbers */
+    unsigned long notedDrops;   /* from the async writer's "dropped" lines */
+    unsigned long children;
+    unsigned long childFailures;
+    unsigned long levelChanges;
+    unsigned files;
+    unsigned badFiles;
+    unsigned long rssFirstKb;
+    unsigned long rssMaxKb;
+} Totals_t;
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static double NowUs(void);
+static void SleepUs(const unsigned long us);
+static unsigned long RssKb(void);
+static int OpenLog(const unsigned index);
+static void *Work(void *arg);
+static void Fork(const unsigned file);
+static void ChildRun(void) __attribute__((noreturn));
+static void CheckFile(const unsigned index);
+static int CheckPad(const char * const pad, const unsigned len, const unsigned long start)
+    __attribute__((pure));
+static void CheckLine(const char * const line, Child_t * const children, unsigned * const count);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static char m_pad[26 + SOAK_MAX_PAD + 1];       /* 'a' to 'z' over and over */
+static Worker_t m_workers[SOAK_THREADS];
+static unsigned m_forked[4];                    /* children forked into each of the last files */
+static Totals_t m_totals;
+static int m_stop;
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(const int argc, char ** const argv) {
+    const double start = NowUs();
+    double nextSwap = start + SOAK_SWAP_US;
+    double seconds;
+    unsigned file = 0;
+    unsigned seed = 1;
+    unsigned i;
+    int failed;
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLogAsyncStats_t stats;
+#endif
+
+    if ((2 != argc) || (0 >= (seconds = atof(argv[1])))) {
+        fprintf(stderr, "usage: %s SECONDS\n", argv[0]);
+        return 1;
+    }
+    for (i = 0; i < sizeof(m_pad) - 1; i++) {
+        m_pad[i] = (char)('a' + (i % 26));
+    }
+    if (0 != OpenLog(file)) {
+        perror("soak");
+        return 1;
+    }
+
+    for (i = 0; i < SOAK_THREADS; i++) {
+        m_workers[i].index = i;
+        m_workers[i].seed = i + 1;
+        (void)pthread_create(&m_workers[i].thread, NULL, Work, &m_workers[i]);
+    }
+
+    while (NowUs() - start < seconds * 1e6) {
+        const unsigned roll = (unsigned)rand_r(&seed) % 100;
+
+        SleepUs(SOAK_TICK_US);
+        if (roll < 50) {
+            if (roll & 1) {
+                ZLog_LevelSet(Z_DEBUG);
+            }
+            else {
+                ZLog_LevelReset();
+            }
+            m_totals.levelChanges++;
+        }
+        else if ((roll < 50 + SOAK_FORK_PERCENT) && (m_forked[file % 4] < SOAK_MAX_CHILDREN)) {
+            Fork(file);
+        }
+
+        if (NowUs() >= nextSwap) {
+            nextSwap += SOAK_SWAP_US;
+            file++;
+            m_forked[file % 4] = 0;
+            if (0 != OpenLog(file)) {
+                perror("soak");
+                return 1;
+            }
+            if (file >= 2) {
+                CheckFile(file - 2);
+            }
+        }
+
+        if ((0 == m_totals.rssFirstKb) && (NowUs() - start >= 1e6)) {
+            m_totals.rssFirstKb = RssKb();
+        }
+        if (RssKb() > m_totals.rssMaxKb) {
+            m_totals.rssMaxKb = RssKb();
+        }
+    }
+
+    __atomic_store_n(&m_stop, 1, __ATOMIC_RELAXED);
+    for (i = 0; i < SOAK_THREADS; i++) {
+        (void)pthread_join(m_workers[i].thread, NULL);
+    }
+    ZLog_LevelReset();
+    ZLog_Flush();
+    for (i = (file >= 1) ? file - 1 : 0; i <= file; i++) {
+        CheckFile(i);
+    }
+    for (i = 0; i < SOAK_THREADS; i++) {
+        m_totals.missing += m_workers[i].records - m_workers[i].expect;
+    }
+
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncStatsGet(&stats);
+    failed = (m_totals.missing > stats.dropped);
+#else
+    failed = (0 != m_totals.missing);
+#endif
+    failed |= (0 != m_totals.broken) || (0 != m_totals.reordered) ||
+              (0 != m_totals.childFailures) || (0 != m_totals.badFiles) ||
+              ((0 != m_totals.rssFirstKb) &&
+               (m_totals.rssMaxKb > m_totals.rssFirstKb + SOAK_RSS_GROWTH_KB));
+
+    fprintf(stderr, "soak %s: %.0f s, %u threads, %lu lines in %u files, %lu level changes\n",
+            SOAK_MODE, seconds, SOAK_THREADS, m_totals.lines, m_totals.files,
+            m_totals.levelChanges);
+    for (i = 0; i < SOAK_THREADS; i++) {
+        fprintf(stderr, "    thread %u: %lu records, %lu noise\n", i, m_workers[i].records,
+                m_workers[i].noise);
+    }
+    fprintf(stderr, "    %lu children, %lu failed\n", m_totals.children, m_totals.childFailures);
+#ifdef Z_CHECK_HAS_ASYNC
+    fprintf(stderr, "    %lu missing, %lu dropped (%lu noted in the log)\n", m_totals.missing,
+            stats.dropped, m_totals.notedDrops);
+#else
+    fprintf(stderr, "    %lu missing\n", m_totals.missing);
+#endif
+    fprintf(stderr, "    %lu broken lines, %lu out of order, %u bad files\n", m_totals.broken,
+            m_totals.reordered, m_totals.badFiles);
+    fprintf(stderr, "    RSS %lu KiB after 1 s, %lu KiB at most\n", m_totals.rssFirstKb,
+            m_totals.rssMaxKb);
+    fprintf(stderr, "    %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+void soak_write(const char * const buf, const size_t len) {
+    /* one write() per line; with O_APPEND, lines from threads and children never overlap */
+    (void)!write(SOAK_FD, buf, len);
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+static double NowUs(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+static void SleepUs(const unsigned long us) {
+    struct timespec delay;
+
+    delay.tv_sec = (time_t)(us / 1000000);
+    delay.tv_nsec = (long)((us % 1000000) * 1000);
+    while (0 != nanosleep(&delay, &delay)) {
+    }
+}
+
+static unsigned long RssKb(void) {
+    FILE * const statm = fopen("/proc/self/statm", "r");
+    unsigned long size = 0;
+    unsigned long resident = 0;
+
+    if (NULL != statm) {
+        if (2 != fscanf(statm, "%lu %lu", &size, &resident)) {
+            resident = 0;
+        }
+        (void)fclose(statm);
+    }
+    return resident * ((unsigned long)sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int OpenLog(const unsigned index) {
+    char path[32]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: snprintf() is bounded by sizeof(path). */
+    int fd;
+
+    (void)snprintf(path, sizeof(path), "soak.%u.log", index);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    /* in-flight writes finish in the old file; every write after this lands in the new one */
+    if (SOAK_FD != dup2(fd, SOAK_FD)) {
+        (void)close(fd);
+        return -1;
+    }
+    (void)close(fd);
+    m_totals.files++;
+    return 0;
+}
+
+static void *Work(void *arg) {
+    Worker_t * const worker = (Worker_t *)arg;
+
+    while (!__atomic_load_n(&m_stop, __ATOMIC_RELAXED)) {
+        const unsigned burst = 1 + ((unsigned)rand_r(&worker->seed) % SOAK_BURST);
+        unsigned i;
+
+        for (i = 0; i < burst; i++) {
+            const unsigned len = (unsigned)rand_r(&worker->seed) % (SOAK_MAX_PAD + 1);
+            const unsigned long n = worker->records;
+
+            if (0 == (i % 8)) {
+                Z_LOG(Z_DEBUG, "noise T%u L%u %.*s E%u", worker->index, len % 64, (int)(len % 64),
+                      m_pad, worker->index);
+                worker->noise++;
+            }
+            Z_LOG(Z_INFO, "rec T%u S%lu L%u %.*s E%u.%lu", worker->index, n, len, (int)len,
+                  &m_pad[n % 26], worker->index, n);
+            worker->records = n + 1;
+        }
+        SleepUs((unsigned)rand_r(&worker->seed) % SOAK_NAP_US);
+    }
+    return NULL;
+}
+
+static void Fork(const unsigned file) {
+    const pid_t pid = fork();
+    const double deadline = NowUs() + SOAK_CHILD_WAIT_US;
+    int status = 0;
+
+    if (0 == pid) {
+        ChildRun();
+    }
+    if (pid < 0) {
+        return;
+    }
+    m_forked[file % 4]++;
+    m_totals.children++;
+    while (0 == waitpid(pid, &status, WNOHANG)) {
+        if (NowUs() > deadline) {
+            fprintf(stderr, "soak: child %ld hung; killing it\n", (long)pid);
+            (void)kill(pid, SIGKILL);
+            (void)waitpid(pid, &status, 0);
+            break;
+        }
+        SleepUs(1000);
+    }
+    if (!WIFEXITED(status) || (0 != WEXITSTATUS(status))) {
+        m_totals.childFailures++;
+    }
+}
+
+static void ChildRun(void) {
+    const long pid = (long)getpid();
+    unsigned seed = (unsigned)pid;
+    unsigned long n;
+
+    for (n = 0; n < SOAK_CHILD_RECORDS; n++) {
+        const unsigned len = (unsigned)rand_r(&seed) % (SOAK_MAX_PAD + 1);
+
+        Z_LOG(Z_INFO, "child P%ld S%lu L%u %.*s E%ld.%lu", pid, n, len, (int)len, &m_pad[n % 26],
+              pid, n);
+    }
+    ZLog_Flush();
+    exit(0);
+}
+
+static void CheckFile(const unsigned index) {
+    const unsigned long broken = m_totals.broken + m_totals.reordered;
+    char path[32]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: snprintf() is bounded by sizeof(path). */
+    char line[1024]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: fgets() is bounded by sizeof(line). */
+    Child_t children[SOAK_MAX_CHILDREN];
+    unsigned childCount = 0;
+    unsigned complete = 0;
+    unsigned i;
+    FILE *log;
+
+    (void)snprintf(path, sizeof(path), "soak.%u.log", index);
+    log = fopen(path, "r");
+    if (NULL == log) {
+        m_totals.badFiles++;
+        return;
+    }
+    while (NULL != fgets(line, sizeof(line), log)) {
+        m_totals.lines++;
+        CheckLine(line, children, &childCount);
+    }
+    (void)fclose(log);
+
+    for (i = 0; i < childCount; i++) {
+        complete += (!children[i].broken && (SOAK_CHILD_RECORDS == children[i].expect));
+    }
+    if ((complete != m_forked[index % 4]) || (complete != childCount)) {
+        fprintf(stderr, "soak: %s: %u children forked, %u complete of %u seen\n", path,
+                m_forked[index % 4], complete, childCount);
+    }
+
+    if ((broken == m_totals.broken + m_totals.reordered) && (complete == m_forked[index % 4])) {
+        (void)remove(path);
+    }
+    else {
+        m_totals.badFiles++;
+    }
+}
+
+static int CheckPad(const char * const pad, const unsigned len, const unsigned long start) {
+    unsigned i;
+
+    for (i = 0; i < len; i++) {
+        if (pad[i] != m_pad[(start + i) % 26]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void CheckLine(const char * const line, Child_t * const children, unsigned * const count) {
+    const char * const end = strchr(line, '\n');
+    const char *body;
+    unsigned thread;
+    unsigned thread2;
+    unsigned len;
+    unsigned long n;
+    unsigned long n2;
+    long pid;
+    long pid2;
+    int at = -1;
+    int tail = -1;
+
+    if ((NULL == end) || ('\0' != end[1]) || (0 != strncmp(line, "soak: [", 7))) {
+        m_totals.broken++;
+        return;
+    }
+
+    if (NULL != (body = strstr(line, ": rec T"))) {
+        if ((3 == sscanf(body, ": rec T%u S%lu L%u %n", &thread, &n, &len, &at)) && (at >= 0) &&
+            (thread < SOAK_THREADS) && CheckPad(body + at, len, n % 26) &&
+            (2 == sscanf(body + at + len, " E%u.%lu%n", &thread2, &n2, &tail)) &&
+            (body + at + len + tail == end) && (thread2 == thread) && (n2 == n)) {
+            Worker_t * const worker = &m_workers[thread];
+
+            if (n < worker->expect) {
+                m_totals.reordered++;
+            }
+            else {
+                m_totals.missing += n - worker->expect;
+                worker->expect = n + 1;
+            }
+            return;
+        }
+    }
+    else if (NULL != (body = strstr(line, ": noise T"))) {
+        if ((2 == sscanf(body, ": noise T%u L%u %n", &thread, &len, &at)) && (at >= 0) &&
+            CheckPad(body + at, len, 0) &&
+            (1 == sscanf(body + at + len, " E%u%n", &thread2, &tail)) &&
+            (body + at + len + tail == end) && (thread2 == thread)) {
+            return;
+        }
+    }
+    else if (NULL != (body = strstr(line, ": child P"))) {
+        if ((3 == sscanf(body, ": child P%ld S%lu L%u %n", &pid, &n, &len, &at)) && (at >= 0) &&
+            CheckPad(body + at, len, n % 26) &&
+            (2 == sscanf(body + at + len, " E%ld.%lu%n", &pid2, &n2, &tail)) &&
+            (body + at + len + tail == end) && (pid2 == pid) && (n2 == n)) {
+            unsigned i;
+
+            for (i = 0; (i < *count) && (children[i].pid != pid); i++) {
+            }
+            if ((i == *count) && (*count < SOAK_MAX_CHILDREN)) {
+                children[i].pid = pid;
+                children[i].expect = 0;
+                children[i].broken = 0;
+                (*count)++;
+            }
+            if (i < *count) {
+                children[i].broken |= (n != children[i].expect);
+                children[i].expect = n + 1;
+            }
+            return;
+        }
+    }
+    else if (NULL != (body = strstr(line, "[z_check: dropped "))) {
+        if (1 == sscanf(body, "[z_check: dropped %lu", &n)) {
+            m_totals.notedDrops += n;
+            return;
+        }
+    }
+    m_totals.broken++;
+}
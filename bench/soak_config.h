@@ -0,0 +1,19 @@
+/**
+ * \file soak_config.h
+ *
+ * \brief z_check configuration for the soak test.
+ * \details
+ * Selected by `make soak`. Lines go to soak_write(), which writes each one with a single write()
+ * to a descriptor the soak test moves to a new file from time to time. The async build adds
+ * Z_CHECK_HAS_ARENA and Z_CHECK_HAS_ASYNC on the command line.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "soak"
+#define Z_CHECK_LOG_FUNC        Z_WRITE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_WRITE_FUNC      soak_write
@@ -30,15 +30,34 @@ Z_CT_ASSERT_DECL(sizeof(int) == sizeof(unsigned));
 //Z_CT_ASSERT_DECL(sizeof(int) == sizeof(long));
 
 
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+/* Names for this file's statuses, from -1 up; Z_CHECK() failures show them in the log */
+Z_STATUS_DOMAIN(m_exampleStatus, -1, "EXAMPLE_FAILED", "EXAMPLE_OK");
+#endif
+
+
 /******************************************************************************
  *                                                      Function declarations */
 static int testExampleAsserts(void);
 static int testExampleLogs(void);
 static int testExampleChecks(void);
+#ifdef Z_CHECK_HAS_CALLSITES
+static void printCallsite(const ZLogCallsite_t *site, void *context);
+#endif
+#ifdef Z_CHECK_HAS_TIMING
+static void printTimeSite(const ZLogTimeSite_t *site, void *context);
+#endif
 
 
 /******************************************************************************
  *                                                         External functions */
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_WRITE)
+void example_write(const char * const buf, const size_t len) {
+    /* with Z_CHECK_LOGB_IDS, Z_LOGB() frames come through here too, so write bytes, not text */
+    (void)fwrite(buf, 1, len, stdout);
+}
+#endif
+
 int main(void) {
     int status = 0;
 
@@ -49,11 +68,26 @@ int main(void) {
      * `ZLog_Open()` and `ZLog_cClose()`, then un-define `Z_CHECK_STATIC_CONFIG` in z_check.h. */
     //ZLog_Open(Z_STDOUT, Z_INFO, "example_dynamic");
 
+#ifdef Z_CHECK_HAS_TRACE
+    /* Spans become slices on a timeline, with the log records as instants; try `make trace` */
+    Z_TRACE_BEGIN("main");
+#endif
+
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+    ZLog_StatusDomainAdd(&m_exampleStatus);
+#endif
+
     /* Try out the features. */
     status = testExampleAsserts();
     Z_CHECK(0 != status, -1, Z_ERR, "[X] testExampleAsserts failed!");
 
+#ifdef Z_CHECK_HAS_TRACE
+    Z_TRACE_BEGIN("testExampleLogs");
+#endif
     status = testExampleLogs();
+#ifdef Z_CHECK_HAS_TRACE
+    Z_TRACE_END("testExampleLogs");
+#endif
     Z_CHECK(0 != status, -1, Z_ERR, "[X] testExampleLogs failed!");
 
     status = testExampleChecks();
@@ -67,6 +101,9 @@ int main(void) {
     /* Use 'cleanup' tag to mark the end of the function, including actual clean up code. */
 cleanup:
     Z_LOG_IF(0 != status, Z_INFO, "[+] returning");
+#ifdef Z_CHECK_HAS_TRACE
+    Z_TRACE_END("main");
+#endif
     //ZLog_Close();
     return status;
 }
@@ -123,6 +160,87 @@ int testExampleLogs(void) {
     ZLog_LevelReset();
     Z_LOG(Z_DEBUG, "[X] will not print");
 
+    /* Z_LOG_ERRNO appends errno by name, instead of a strerror() call in the arguments that
+     * would run even when the level is filtered. Z_CHECK_ERRNO does the same for checks. */
+    errno = ENOENT;
+    Z_LOG_ERRNO(Z_INFO, "[+] open(\"%s\") failed", "missing.conf");
+
+#ifdef Z_CHECK_HAS_ARENA
+    /* Messages longer than the stack buffer are formatted into a block from the calling
+     * thread's arena instead of being truncated. The arena is static, so this never mallocs. */
+    {
+        ZLogArenaStats_t stats;
+
+        Z_LOG(Z_INFO, "[+] a long message, padded past the stack buffer: %0600d", 1);
+        ZLog_Flush();   /* with Z_CHECK_HAS_ASYNC, blocks come back as the writer gets to them */
+        ZLog_ArenaStatsGet(&stats);
+        Z_LOG(Z_INFO, "[+] arena: %lu of %lu 1 KiB blocks freed, %lu bytes carved, %lu failures",
+              stats.frees[1], stats.allocs[1], stats.bytesCarved, stats.failures);
+    }
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)
+    /* Lines wait in frames for the collector; ZLog_Flush() seals the last one and sends what
+     * the socket will take without blocking. */
+    {
+        ZLogNetStats_t stats;
+
+        ZLog_Flush();
+        ZLog_NetStatsGet(&stats);
+        Z_LOG(Z_INFO, "[+] net: %lu lines in %lu frames, %lu sent, %lu dropped, %lu connects",
+              stats.lines, stats.frames, stats.sent, stats.dropped, stats.connects);
+    }
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_JOURNAL)
+    /* Each line is a journal entry, with its file, line and function as fields of their own;
+     * one too long for a datagram is passed in a memory file. */
+    {
+        ZLogJournalStats_t stats;
+
+        Z_LOG(Z_INFO, "[+] a long entry, passed in a memory file: %0400d", 1);
+        ZLog_Flush();
+        ZLog_JournalStatsGet(&stats);
+        Z_LOG(Z_INFO, "[+] journal: %lu entries, %lu sent, %lu by memory file, %lu dropped",
+              stats.entries, stats.sent, stats.memfds, stats.dropped);
+    }
+#endif
+
+#ifdef Z_CHECK_HAS_CALLSITES
+    /* Each log site registers itself the first time it runs, so sites can be listed and
+     * switched off at run time, even before they have run. */
+    ZLog_CallsiteSet("example.c", __LINE__ + 1, 0);
+    Z_LOG(Z_INFO, "[X] this site is switched off");
+    ZLog_CallsiteForEach(printCallsite, NULL);
+#endif
+
+#ifdef Z_CHECK_HAS_LOG_COST
+    /* Each site also times its own calls into the library; list the two most expensive. */
+    ZLog_CostReport(2);
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+    /* Z_TIME_SCOPE times the rest of its block, however the block is left, and logs only runs
+     * over the threshold. Every run lands in the site's histogram. */
+    {
+        Z_TIME_SCOPE(Z_WARN, 100, "[+] counting to a million");
+        volatile unsigned long count;
+
+        for (count = 0; count < 1000000; count++) {
+        }
+    }
+    ZLog_TimeForEach(printTimeSite, NULL);
+#endif
+
+#if defined(Z_CHECK_HAS_LOGB) && (__STDC_VERSION__ >= 201112L)
+    /* Z_LOGB copies the arguments with their types instead of formatting them; the text is
+     * made later, where the message is written. Strings are copied, so they need not outlive
+     * the call. */
+    Z_LOGB(Z_INFO, "[+] binary: %d %u %lld %.3f %s %p", -7, 7u, 1LL << 40, 2.5, "str",
+           (void *)&status);
+    Z_LOGB_IF(false, Z_INFO, "[X] this will not print");
+#endif
+
     return status;
 }
 
@@ -150,3 +268,29 @@ cleanup:
     return status;
 }
 
+#ifdef Z_CHECK_HAS_CALLSITES
+void printCallsite(const ZLogCallsite_t *site, void *context) {
+    UNUSED_VARIABLE(context);
+#ifdef Z_CHECK_HAS_CALLSITE_HITS
+    printf("    site %s:%d:%s ran %lu times%s\n", site->file, site->line, site->func, site->hits,
+           site->enabled ? "" : " (off)");
+#else
+    printf("    site %s:%d:%s%s\n", site->file, site->line, site->func,
+           site->enabled ? "" : " (off)");
+#endif
+}
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+void printTimeSite(const ZLogTimeSite_t *site, void *context) {
+    unsigned i;
+
+    UNUSED_VARIABLE(context);
+    printf("    timer %s:%d \"%s\" ran %lu times, %lu slow, max %lu us; by power of two us:",
+           site->file, site->line, site->name, site->runs, site->slowRuns, site->maxUs);
+    for (i = 0; i < Z_CHECK_TIME_BUCKETS; i++) {
+        printf(" %lu", site->buckets[i]);
+    }
+    printf("\n");
+}
+#endif
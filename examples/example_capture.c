@@ -0,0 +1,118 @@
+/**
+ * \file example_capture.c
+ *
+ * \brief Check what was logged, as a unit test would, through the Z_CAPTURE target.
+ * \details
+ * `make capture` builds this file with example_capture_config.h, once logging from the calling
+ * thread and once through the writer thread, and runs both. Each logs a few lines and compares
+ * ZLog_CaptureGet() with the lines it expects, byte for byte; logs a line too long for what is
+ * left of the buffer and checks that it is counted as dropped and leaves the text as it was; and
+ * checks that ZLog_CaptureClear() empties the buffer. Any difference goes to stderr, and the exit
+ * status is 1.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************
+ *                                                                    Defines */
+#define EXPECT_MAX  512
+#define LONG_LEN    200     /* characters in the line that does not fit */
+
+
+/******************************************************************************
+ *                                                      Function declarations */
+static int Expect(const char *what, const char *expected);
+static int Status(const int value);
+
+
+/******************************************************************************
+ *                                                                       Data */
+static char m_expected[EXPECT_MAX]; /* Flawfinder: ignore */
+static char m_long[LONG_LEN + 1]; /* Flawfinder: ignore */
+    /* Warning: Statically-sized arrays
+       "Ignore" justification: snprintf() is bounded by sizeof(m_expected); m_long is filled
+       with memset() to LONG_LEN, then terminated. */
+static int m_checkLine;     /* of the Z_CHECK() in Status() */
+
+
+/******************************************************************************
+ *                                                         External functions */
+int main(void) {
+    ZLogCaptureStats_t before;
+    ZLogCaptureStats_t after;
+    size_t len = 0;
+    int failures = 0;
+    int line;
+    int status;
+
+    ZLog_CaptureClear();
+    ZLog_CaptureStatsGet(&before);
+
+    line = __LINE__ + 1;
+    Z_LOG(Z_INFO, "[+] sensor %d reads %u", 3, 1024u);
+    Z_LOG(Z_DEBUG, "[X] filtered by level");
+    status = Status(-5);
+    (void)snprintf(m_expected, sizeof(m_expected),
+                   "capture: [INFO] example_capture.c:%d:main: [+] sensor 3 reads 1024\n"
+                   "capture: [ERROR] example_capture.c:%d:Status: [+] status %d\n",
+                   line, m_checkLine, status);
+    failures += Expect("two lines", m_expected);
+
+    memset(m_long, 'x', LONG_LEN);
+    Z_LOG(Z_WARN, "[+] %s", m_long);
+    failures += Expect("after a line that does not fit", m_expected);
+    ZLog_CaptureStatsGet(&after);
+    if (((after.lines - before.lines) != 3u) || ((after.dropped - before.dropped) != 1u)) {
+        fprintf(stderr, "counters: %lu lines, %lu dropped; expected 3 and 1\n",
+                after.lines - before.lines, after.dropped - before.dropped);
+        failures++;
+    }
+
+    ZLog_CaptureClear();
+    if ((0 != strcmp(ZLog_CaptureGet(&len), "")) || (0u != len)) {
+        fprintf(stderr, "after ZLog_CaptureClear(): %lu bytes left\n", (unsigned long)len);
+        failures++;
+    }
+    line = __LINE__ + 1;
+    Z_LOG(Z_NOTICE, "[+] cleared");
+    (void)snprintf(m_expected, sizeof(m_expected),
+                   "capture: [NOTICE] example_capture.c:%d:main: [+] cleared\n", line);
+    failures += Expect("after ZLog_CaptureClear()", m_expected);
+
+    fprintf(stderr, "%s\n", (0 == failures) ? "PASS" : "FAIL");
+    return (0 == failures) ? 0 : 1;
+}
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+/* Compare the captured text with the expected, and show both if they differ */
+static int Expect(const char *what, const char *expected) {
+    size_t len = 0;
+    const char * const got = ZLog_CaptureGet(&len);
+
+    if ((len == strlen(expected)) && (0 == memcmp(got, expected, len))) {
+        return 0;
+    }
+    fprintf(stderr, "%s: expected\n%sgot\n%s", what, expected, got);
+    return 1;
+}
+
+static int Status(const int value) {
+    int status = 0;
+
+    m_checkLine = __LINE__ + 1;
+    Z_CHECK(0 > value, value, Z_ERR, "[+] status %d", value);
+
+cleanup:
+    return status;
+}
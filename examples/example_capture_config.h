@@ -0,0 +1,17 @@
+/**
+ * \file example_capture_config.h
+ *
+ * \brief z_check configuration for the example that checks its own log lines.
+ * \details
+ * Selected by `make capture`. The buffer is kept small so that the example can overflow it.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "capture"
+#define Z_CHECK_LOG_FUNC        Z_CAPTURE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_CAPTURE_SIZE    256
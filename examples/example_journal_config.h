@@ -0,0 +1,20 @@
+/**
+ * \file example_journal_config.h
+ *
+ * \brief z_check configuration for the example logging to the systemd journal.
+ * \details
+ * Selected by `make journal`, which builds the example as build/example_journal with
+ * Z_CHECK_JOURNAL_SOCKET pointed at `tools/zlog_journal.py` instead of journald, and runs it
+ * against that. Entries over 512 bytes go by memory file, so the example's long entry takes
+ * that path.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME         "main"
+#define Z_CHECK_LOG_FUNC            Z_JOURNAL
+#define Z_CHECK_INIT_LOG_LEVEL      Z_INFO
+#define Z_CHECK_JOURNAL_MEMFD_OVER  512
@@ -0,0 +1,22 @@
+/**
+ * \file example_logb_config.h
+ *
+ * \brief z_check configuration for the example built with Z_LOGB site IDs.
+ * \details
+ * Selected by `make logb-ids`. Z_LOGB() records leave the program as frames of site IDs and raw
+ * arguments, mixed with the text lines of Z_LOG(); decode them with
+ * `tools/zlogb.py decode build/example LOG`. `make trace` adds Z_CHECK_HAS_TRACE on top, for
+ * `tools/zlogb.py trace build/example LOG`.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+#define Z_CHECK_HAS_LOGB
+#define Z_CHECK_LOGB_IDS
+
+#define Z_CHECK_MODULE_NAME     "main"
+#define Z_CHECK_LOG_FUNC        Z_WRITE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_WRITE_FUNC      example_write
@@ -0,0 +1,18 @@
+/**
+ * \file example_net_config.h
+ *
+ * \brief z_check configuration for the example logging to a collector over the network.
+ * \details
+ * Selected by `make net`, which builds the example as build/example_net_tcp, starts
+ * `tools/zlog_listen.py` on port 5140 as the collector and runs the example against it.
+ * `make net NET_PROTO=udp` builds build/example_net_udp, with Z_CHECK_NET_UDP, for datagrams.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+
+#define Z_CHECK_MODULE_NAME     "main"
+#define Z_CHECK_LOG_FUNC        Z_NET
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
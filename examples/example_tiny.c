@@ -0,0 +1,39 @@
+/**
+ * \file example_tiny.c
+ *
+ * \brief Minimal program for comparing z_check footprints.
+ * \details
+ * Built twice by `make size-report`: once with the default configuration (stdio and
+ * vsnprintf()), once freestanding with example_tiny_config.h, where lines go to tiny_write().
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include "z_check.h"
+#include <unistd.h>
+
+
+/******************************************************************************
+ *                                                         External functions */
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_WRITE)
+void tiny_write(const char * const buf, const size_t len) {
+    /* stands in for a UART or RTT channel on a real target */
+    ssize_t rc = write(STDOUT_FILENO, buf, len);
+    UNUSED_VARIABLE(rc);
+}
+#endif
+
+int main(void) {
+    int status = 0;
+
+    Z_LOG(Z_INFO, "[+] sensor %d reads %u (%s)", 3, 1024u, "ok");
+    Z_LOG(Z_DEBUG, "[X] filtered by level");
+    Z_CHECK(1024u > 1000u, -1, Z_ERR, "[+] reading %u above limit %c", 1024u, '!');
+
+cleanup:
+    return status;
+}
@@ -0,0 +1,49 @@
+/**
+ * \file example_tiny_baseline.c
+ *
+ * \brief example_tiny.c's libc calls without z_check, for `make size-report`.
+ * \details
+ * Built with BASELINE_STDIO, it calls vsnprintf() and fprintf() as the default build of
+ * example_tiny.c does; without, it only calls write() as the freestanding build does. Each
+ * whole image of example_tiny.c is compared with the matching one.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+
+/******************************************************************************
+ *                                                                 Inclusions */
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+/******************************************************************************
+ *                                                         External functions */
+#ifdef BASELINE_STDIO
+static int format(char * const buf, const size_t size, const char * const fmt, ...) {
+    va_list args;
+    int rc;
+
+    va_start(args, fmt);
+    rc = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return rc;
+}
+#endif
+
+int main(int argc, char **argv) {
+#ifdef BASELINE_STDIO
+    char buf[64];
+
+    (void)format(buf, sizeof(buf), "%s %d", argv[0], argc);
+    fprintf(stdout, "%s\n", buf);
+    fflush(stdout);
+#else
+    ssize_t rc = write(STDOUT_FILENO, argv[0], (size_t)argc);
+
+    (void)rc;
+#endif
+    return 0;
+}
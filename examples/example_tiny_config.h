@@ -0,0 +1,19 @@
+/**
+ * \file example_tiny_config.h
+ *
+ * \brief z_check configuration for the freestanding example_tiny build.
+ * \details
+ * Selected with -DZ_CHECK_CONFIG_FILE='"examples/example_tiny_config.h"'; see the size-report
+ * target in the Makefile.
+ *
+ * \copyright Copyright (c) 2019, Kevin Kredit.
+ * \license MIT
+ */
+
+#define Z_CHECK_STATIC_CONFIG
+#define Z_CHECK_FREESTANDING
+
+#define Z_CHECK_MODULE_NAME     "tiny"
+#define Z_CHECK_LOG_FUNC        Z_WRITE
+#define Z_CHECK_INIT_LOG_LEVEL  Z_INFO
+#define Z_CHECK_WRITE_FUNC      tiny_write
@@ -0,0 +1,71 @@
+#!/bin/sh
+#
+# Compare the footprint of the default z_check build with the freestanding one.
+#
+# Both builds compile examples/example_tiny.c at -Os; the freestanding one uses
+# examples/example_tiny_config.h. Reports object sizes, whole static images, the
+# libc symbols each build pulls in, and the stack frames of the logging path
+# (from -fstack-usage).
+#
+# The freestanding z_check.o is the larger one, since it carries its own
+# formatter; what it saves is libc's. So each whole image is set against
+# examples/example_tiny_baseline.c, which makes the same libc calls without
+# z_check: vsnprintf() and fprintf() for the hosted build, write() alone for the
+# freestanding one. glibc links stdio into every static binary, so the two
+# baselines differ little here; on embedded C libraries (newlib, picolibc) the
+# stdio one grows by their formatter.
+#
+# Usage: tools/size_report.sh [output dir]
+
+set -e
+
+CC=${CC:-gcc}
+OUT=${1:-build/size-report}
+FLAGS="-Os -ffunction-sections -fdata-sections -fstack-usage -std=c99 -D_POSIX_C_SOURCE=200112L -I. -Iz_check"
+LINK="-static -Wl,--gc-sections"
+
+build() {
+    dir=$OUT/$1
+    shift
+    mkdir -p "$dir"
+    $CC $FLAGS "$@" -c z_check/z_check.c -o "$dir/z_check.o"
+    $CC $FLAGS "$@" -c examples/example_tiny.c -o "$dir/example_tiny.o"
+    $CC $FLAGS "$@" -c examples/example_tiny_baseline.c -o "$dir/example_tiny_baseline.o"
+    $CC $LINK "$dir/z_check.o" "$dir/example_tiny.o" -o "$dir/example_tiny"
+    $CC $LINK "$dir/example_tiny_baseline.o" -o "$dir/example_tiny_baseline"
+}
+
+text() {
+    size "$1" | awk 'NR == 2 { print $1 }'
+}
+
+build hosted -DBASELINE_STDIO
+build freestanding -DZ_CHECK_CONFIG_FILE='"examples/example_tiny_config.h"'
+
+echo "== z_check.o flash (bytes, -Os) =="
+for b in hosted freestanding; do
+    size "$OUT/$b/z_check.o" | awk -v b=$b 'NR == 2 { printf "%-14s text %6d  data %5d  bss %5d\n", b, $1, $2, $3 }'
+done
+echo "freestanding z_check.o: $(( $(text "$OUT/freestanding/z_check.o") - $(text "$OUT/hosted/z_check.o") )) bytes of text over hosted, for its own formatter"
+
+echo
+echo "== whole static image, text (bytes, -Os) =="
+for b in hosted freestanding; do
+    image=$(text "$OUT/$b/example_tiny")
+    base=$(text "$OUT/$b/example_tiny_baseline")
+    printf "%-14s %8d  baseline %8d  z_check adds %6d\n" $b $image $base $((image - base))
+done
+echo "stdio baseline over write baseline: $(( $(text "$OUT/hosted/example_tiny_baseline") - $(text "$OUT/freestanding/example_tiny_baseline") )) bytes of libc formatting"
+
+echo
+echo "== libc symbols z_check.o needs =="
+for b in hosted freestanding; do
+    printf "%-14s %s\n" $b "$(nm -u "$OUT/$b/z_check.o" | awk '{ print $2 }' | grep -v '^tiny_write$' | tr '\n' ' ')"
+done
+
+echo
+echo "== stack frames (bytes) =="
+for b in hosted freestanding; do
+    echo "$b:"
+    sort -t '	' -k2 -n -r "$OUT/$b/z_check.su" | awk -F '\t' '{ n = split($1, a, ":"); printf "    %-28s %6d  %s\n", a[n], $2, $3 }'
+done
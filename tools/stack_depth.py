@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Worst-case stack depth of every public function, from GCC call graphs.
+
+Reads the .ci files written by -fcallgraph-info=su and the objects they belong
+to. Public functions are the global text symbols of the objects. Each one is
+reported with the deepest call chain below it, summing the frame sizes GCC
+recorded. Calls out of the graph (libc) cannot be measured and are listed so
+the caller can add their own budget for them.
+
+Usage: stack_depth.py [--indirect REGEX] OBJECT.o... -- FILE.ci...
+"""
+
+import re
+import subprocess
+import sys
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+SIZE_RE = re.compile(r'\\n(\d+) bytes \(([^)]*)\)')
+INDIRECT = '__indirect_call'
+
+
+def parse(paths):
+    frames = {}     # function -> (bytes, qualifier)
+    calls = {}      # function -> set of callees
+    for path in paths:
+        with open(path) as ci:
+            for line in ci:
+                node = NODE_RE.search(line)
+                if node:
+                    size = SIZE_RE.search(node.group(2))
+                    if size:
+                        frames[node.group(1)] = (int(size.group(1)), size.group(2))
+                    continue
+                edge = EDGE_RE.search(line)
+                if edge:
+                    calls.setdefault(edge.group(1), set()).add(edge.group(2))
+    return frames, calls
+
+
+def public_functions(objects):
+    names = []
+    for obj in objects:
+        out = subprocess.run(['nm', '-g', '--defined-only', obj],
+                             check=True, capture_output=True, text=True).stdout
+        names += [f[2] for f in (l.split() for l in out.splitlines()) if len(f) == 3
+                  and f[1] == 'T']
+    return sorted(set(names))
+
+
+class Analyzer:
+    def __init__(self, frames, calls, indirect):
+        self.frames = frames
+        self.calls = calls
+        self.indirect = [f for f in frames if indirect and re.search(indirect, f)]
+        self.memo = {}
+
+    def callees(self, fn):
+        for callee in sorted(self.calls.get(fn, ())):
+            if callee == INDIRECT and self.indirect:
+                yield from self.indirect
+            else:
+                yield callee
+
+    def worst(self, fn, active=()):
+        """Return (bytes, chain, unmeasured callees, notes) for the deepest path from fn."""
+        if fn in self.memo:
+            return self.memo[fn]
+        if fn not in self.frames:
+            return 0, [fn], {fn}, set()
+        own, qualifier = self.frames[fn]
+        notes = set()
+        if 'bounded' not in qualifier and 'dynamic' in qualifier:
+            notes.add('%s has an unbounded dynamic frame' % fn)
+        best = (0, [], set(), set())
+        unmeasured = set()
+        for callee in self.callees(fn):
+            if callee in active or callee == fn:
+                notes.add('recursion through %s' % callee)
+                continue
+            sub = self.worst(callee, active + (fn,))
+            unmeasured |= sub[2]
+            notes |= sub[3]
+            if sub[0] > best[0] or not best[1]:
+                best = sub
+        result = (own + best[0], [fn] + best[1], unmeasured, notes)
+        self.memo[fn] = result
+        return result
+
+
+def main(argv):
+    indirect = None
+    if len(argv) > 1 and argv[0] == '--indirect':
+        indirect, argv = argv[1], argv[2:]
+    if '--' not in argv:
+        sys.exit(__doc__)
+    split = argv.index('--')
+    frames, calls = parse(argv[split + 1:])
+    analyzer = Analyzer(frames, calls, indirect)
+
+    for fn in public_functions(argv[:split]):
+        depth, chain, unmeasured, notes = analyzer.worst(fn)
+        measured = [f.split(':')[-1] for f in chain if f in frames]
+        print('    %-22s %6d  %s' % (fn, depth, ' > '.join(measured)))
+        if unmeasured:
+            print('    %-22s %6s  + %s' % ('', '', ', '.join(sorted(unmeasured))))
+        for note in sorted(notes):
+            print('    %-22s %6s  ! %s' % ('', '', note))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Report the worst-case stack depth of every public z_check function.
+#
+# Builds z_check.c in a few configurations with -fcallgraph-info=su and walks
+# the call graphs with tools/stack_depth.py. Depths cover z_check's own frames;
+# the libc functions listed under each entry point come on top.
+#
+# Fails if an entry point of another configuration goes deeper than in the
+# default build. Where the default build leaves the line to stdio, its own
+# frames undercount, so every entry point may also use as much as the default
+# build's ZLog(), which builds a whole line on its stack.
+#
+# Usage: tools/stack_report.sh [output dir] [extra CFLAGS...]
+
+set -e
+
+CC=${CC:-gcc}
+OUT=${1:-build/stack-report}
+[ $# -gt 0 ] && shift
+FLAGS="-O2 -fcallgraph-info=su -std=c99 -D_POSIX_C_SOURCE=200112L -I. -Iz_check $*"
+TINY='-DZ_CHECK_CONFIG_FILE="examples/example_tiny_config.h"'
+
+report() {
+    name=$1
+    shift
+    mkdir -p "$OUT/$name"
+    $CC $FLAGS "$@" -c z_check/z_check.c -o "$OUT/$name/z_check.o"
+    echo "$name ($*):"
+    python3 tools/stack_depth.py --indirect '^ZLog_(StdOut|StdErr|Syslog|File)$' \
+        "$OUT/$name/z_check.o" -- "$OUT/$name/z_check.ci" > "$OUT/$name/depths"
+    cat "$OUT/$name/depths"
+    echo
+}
+
+check() {
+    awk -v name="$1" '
+        $2 !~ /^[0-9]+$/ { next }
+        FNR == NR { base[$1] = $2; next }
+        {
+            budget = ($1 in base) ? base[$1] : 0
+            budget = (base["ZLog"] > budget) ? base["ZLog"] : budget
+            if ($2 + 0 > budget + 0) {
+                printf "%s: %s takes %d bytes, over the default build'"'"'s %d\n", \
+                    name, $1, $2, budget
+                failed = 1
+            }
+        }
+        END { exit failed }
+    ' "$OUT/default/depths" "$OUT/$1/depths"
+}
+
+echo "== worst-case stack depth of public functions (bytes) =="
+report default
+report low-stack -DZ_CHECK_LOW_STACK
+report freestanding "$TINY"
+report freestanding-low-stack "$TINY" -DZ_CHECK_LOW_STACK
+
+status=0
+for name in low-stack freestanding freestanding-low-stack; do
+    check $name || status=1
+done
+[ $status -eq 0 ] && echo "no entry point deeper than in the default build"
+exit $status
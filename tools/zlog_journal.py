@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Stand in for journald: take entries from z_check's Z_JOURNAL target.
+
+Binds a UNIX datagram socket at SOCKET and reads journald's native protocol:
+one entry per datagram, as lines of KEY=value, or for values that may hold a
+newline, KEY, a newline, the value's length as 64-bit little-endian, the value
+and a newline. An empty datagram carrying a descriptor (SCM_RIGHTS) passes the
+entry in a memory file instead. Each entry is written to stdout as a JSON
+object, with "_MEMFD": true if it came in a file.
+
+The stand-in stops after IDLE seconds without an entry (default: never), or on
+SIGINT or SIGTERM, then reports on stderr. The exit status is 1 if nothing
+came, or an entry could not be parsed or lacked one of REQUIRED.
+
+Usage: zlog_journal.py SOCKET [IDLE]
+"""
+
+import array
+import json
+import os
+import signal
+import socket
+import struct
+import sys
+
+REQUIRED = ('MESSAGE', 'PRIORITY', 'SYSLOG_IDENTIFIER', 'CODE_FILE', 'CODE_LINE', 'CODE_FUNC')
+
+
+def parse(data):
+    fields = {}
+    pos = 0
+    while pos < len(data):
+        end = data.index(b'\n', pos)
+        line = data[pos:end]
+        if b'=' in line:
+            key, value = line.split(b'=', 1)
+            pos = end + 1
+        else:
+            key = line
+            length, = struct.unpack_from('<Q', data, end + 1)
+            start = end + 1 + 8
+            value = data[start:start + length]
+            if len(value) != length or data[start + length:start + length + 1] != b'\n':
+                raise ValueError(f'field {key!r} cut short')
+            pos = start + length + 1
+        fields[key.decode()] = value.decode(errors='replace')
+    return fields
+
+
+def receive(sock):
+    fds = array.array('i')
+    data, ancdata, _, _ = sock.recvmsg(1 << 20, socket.CMSG_SPACE(fds.itemsize))
+    for level, kind, cdata in ancdata:
+        if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+            fds.frombytes(cdata[:len(cdata) - (len(cdata) % fds.itemsize)])
+    if not fds:
+        return data, False
+    for fd in fds[1:]:
+        os.close(fd)
+    try:
+        return os.pread(fds[0], os.fstat(fds[0]).st_size, 0), True
+    finally:
+        os.close(fds[0])
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.exit(__doc__.strip().splitlines()[-1])
+    path = argv[1]
+    if os.path.exists(path):
+        os.unlink(path)
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+    sock.bind(path)
+    sock.settimeout(float(argv[2]) if len(argv) > 2 else None)
+    for signum in (signal.SIGINT, signal.SIGTERM):
+        signal.signal(signum, signal.default_int_handler)
+
+    entries = memfds = bad = 0
+    try:
+        while True:
+            data, memfd = receive(sock)
+            try:
+                fields = parse(data)
+            except (ValueError, struct.error) as err:
+                print(f'bad entry: {err}', file=sys.stderr)
+                bad += 1
+                continue
+            missing = [key for key in REQUIRED if key not in fields]
+            if missing:
+                print(f'entry without {", ".join(missing)}', file=sys.stderr)
+                bad += 1
+            entries += 1
+            memfds += memfd
+            if memfd:
+                fields['_MEMFD'] = True
+            print(json.dumps(fields), flush=True)
+    except (socket.timeout, KeyboardInterrupt):
+        pass
+    finally:
+        sock.close()
+        os.unlink(path)
+    print(f'{entries} entries, {memfds} by memory file, {bad} bad', file=sys.stderr)
+    sys.exit(0 if entries and not bad else 1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Stand in for a log collector: take frames from z_check's Z_NET target.
+
+A frame is a 16-byte big-endian header -- the length of what follows the
+length field, the sender's pid and the frame's sequence number -- then whole
+text lines. Over TCP frames follow each other on the stream; over UDP each
+datagram is one frame. Lines are written to stdout as they come. A frame whose
+number was already seen from that pid (resent after a reconnect) is skipped;
+numbers missing after the first one seen from a pid are counted as gaps.
+
+The listener stops after IDLE seconds without traffic (default: never), or on
+SIGINT or SIGTERM, then
+reports frames, lines, repeats and gaps per pid on stderr. The exit status is
+1 if there were gaps, or nothing came at all.
+
+Usage: zlog_listen.py tcp|udp PORT [IDLE]
+"""
+
+import selectors
+import signal
+import socket
+import struct
+import sys
+
+HEADER = struct.Struct('>IIQ')
+
+
+class Senders:
+    def __init__(self, write):
+        self.write = write
+        self.pids = {}
+
+    def frame(self, pid, sequence, lines):
+        stats = self.pids.setdefault(pid, {'next': sequence, 'frames': 0, 'lines': 0,
+                                           'repeats': 0, 'gaps': 0})
+        if sequence < stats['next']:
+            stats['repeats'] += 1
+            return
+        stats['gaps'] += sequence - stats['next']
+        stats['next'] = sequence + 1
+        stats['frames'] += 1
+        stats['lines'] += lines.count(b'\n')
+        self.write(lines)
+
+    def report(self):
+        for pid, stats in sorted(self.pids.items()):
+            print(f"pid {pid}: {stats['frames']} frames, {stats['lines']} lines, "
+                  f"{stats['repeats']} repeats, {stats['gaps']} gaps", file=sys.stderr)
+        return bool(self.pids) and not any(stats['gaps'] for stats in self.pids.values())
+
+
+def listen(proto, port, idle, senders):
+    udp = proto == 'udp'
+    server = socket.socket(socket.AF_INET, socket.SOCK_DGRAM if udp else socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', port))
+    if not udp:
+        server.listen()
+    selector = selectors.DefaultSelector()
+    selector.register(server, selectors.EVENT_READ, None)
+    while True:
+        events = selector.select(idle)
+        if not events:
+            return
+        for key, _ in events:
+            if udp:
+                data = server.recv(65536)
+                if len(data) >= HEADER.size:
+                    _, pid, sequence = HEADER.unpack_from(data)
+                    senders.frame(pid, sequence, data[HEADER.size:])
+            elif key.data is None:
+                conn, _ = server.accept()
+                selector.register(conn, selectors.EVENT_READ, bytearray())
+            else:
+                data = key.fileobj.recv(65536)
+                if not data:
+                    # a frame cut off here comes again whole on the sender's next connection
+                    selector.unregister(key.fileobj)
+                    key.fileobj.close()
+                    continue
+                pending = key.data
+                pending += data
+                while len(pending) >= 4:
+                    length, = struct.unpack_from('>I', pending)
+                    if len(pending) < 4 + length:
+                        break
+                    _, pid, sequence = HEADER.unpack_from(pending)
+                    senders.frame(pid, sequence, bytes(pending[HEADER.size:4 + length]))
+                    del pending[:4 + length]
+
+
+def main(argv):
+    if len(argv) not in (3, 4) or argv[1] not in ('tcp', 'udp'):
+        sys.exit(__doc__.strip().splitlines()[-1])
+    senders = Senders(lambda lines: (sys.stdout.buffer.write(lines), sys.stdout.flush()))
+    for signum in (signal.SIGINT, signal.SIGTERM):
+        signal.signal(signum, signal.default_int_handler)
+    try:
+        listen(argv[1], int(argv[2]), float(argv[3]) if len(argv) > 3 else None, senders)
+    except KeyboardInterrupt:
+        pass
+    sys.exit(0 if senders.report() else 1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Ship the segments of z_check's Z_SPOOL target: a local shipper.
+
+Sealed segments (NNNNNNNNNNNNNNNN.log) in SPOOL_DIR are read in order of their
+numbers and their lines written to stdout; once stdout has taken a segment, it
+is renamed NNN.shipped, which tells the sink it may delete it. A last line with
+no newline, left by a failed write, is counted and skipped. A shipper that dies
+between writing a segment and renaming it ships it again when restarted: lines
+come at least once, not exactly once.
+
+The shipper looks for new segments every half second, and stops after IDLE
+seconds without one (default: never; 0 for a single pass), or on SIGINT or
+SIGTERM, then reports segments, lines and torn lines on stderr. The exit status
+is 1 if there was nothing to ship at all.
+
+Usage: zlog_ship.py SPOOL_DIR [IDLE]
+"""
+
+import os
+import re
+import signal
+import sys
+import time
+
+SEALED = re.compile(r'^(\d{16})\.log$')
+POLL = 0.5
+
+
+def sealed(spool):
+    names = [name for name in os.listdir(spool) if SEALED.match(name)]
+    return [os.path.join(spool, name) for name in sorted(names)]
+
+
+def ship(path, out, totals):
+    with open(path, 'rb') as segment:
+        data = segment.read()
+    whole = data.rfind(b'\n') + 1
+    out.write(data[:whole])
+    out.flush()
+    os.rename(path, path[:-len('.log')] + '.shipped')
+    totals['segments'] += 1
+    totals['lines'] += data.count(b'\n', 0, whole)
+    totals['torn'] += 1 if whole < len(data) else 0
+
+
+def run(spool, idle, totals):
+    quiet = 0.0
+    while True:
+        paths = sealed(spool)
+        for path in paths:
+            ship(path, sys.stdout.buffer, totals)
+        if paths:
+            quiet = 0.0
+        elif idle is not None and quiet >= idle:
+            return
+        else:
+            time.sleep(POLL)
+            quiet += POLL
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.exit(__doc__.strip().splitlines()[-1])
+    totals = {'segments': 0, 'lines': 0, 'torn': 0}
+    for signum in (signal.SIGINT, signal.SIGTERM):
+        signal.signal(signum, signal.default_int_handler)
+    try:
+        run(argv[1], float(argv[2]) if len(argv) > 2 else None, totals)
+    except KeyboardInterrupt:
+        pass
+    print(f"{totals['segments']} segments, {totals['lines']} lines, {totals['torn']} torn",
+          file=sys.stderr)
+    sys.exit(0 if totals['segments'] else 1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,539 @@
+#!/usr/bin/env python3
+"""
+Read back the Z_LOGB site table of a binary, and decode logs written with it.
+
+With Z_CHECK_LOGB_IDS, every Z_LOGB() call site is laid down in the
+z_check_sites section, and records are written as the site's index there plus
+the raw tagged arguments (see ZLog_BinarySite() in z_check.h). This tool reads
+the table straight from the ELF file, so nothing about the sites has to travel
+with the log or be registered at startup:
+
+    table   print the sites as JSON, with the binary's build-ID
+    decode  turn a log back into z_check's text lines; text lines already in
+            the log pass through, and the log's build-ID must match
+    trace   with Z_CHECK_HAS_TRACE, turn a log into Chrome trace-event JSON,
+            which Perfetto (ui.perfetto.dev) and chrome://tracing load: spans
+            become slices, log lines and records instant events
+    mix     turn a log into a replay mix for bench/bench_replay.c: a C header
+            with one function per site that fired, calling it with samples of
+            the recorded arguments, and the order the sites fired in (the
+            first MIX_CALLS of them); Z_LOG() lines, of which only the text is
+            known, replay as Z_LOG(level, "%s", text)
+
+Arguments are read with the byte order and pointer size of the binary, and
+formatted as printf() would have (%a aside, which follows Python's float.hex()).
+
+Usage: zlogb.py table BINARY
+       zlogb.py decode BINARY [LOG]
+       zlogb.py trace BINARY [LOG]
+       zlogb.py mix BINARY [LOG]
+"""
+
+import json
+import os
+import re
+import struct
+import sys
+
+SECTION = 'z_check_sites'
+FRAME_MARK = 0x1E
+LEVELS = ['EMERGENCY', 'ALERT', 'CRITICAL', 'ERROR', 'WARNING', 'NOTICE', 'INFO', 'DEBUG']
+SHT_RELA, SHT_NOTE, SHT_NOBITS = 4, 7, 8
+NT_GNU_BUILD_ID = 3
+Z_ARG_INT, Z_ARG_UINT, Z_ARG_LLONG, Z_ARG_ULLONG, Z_ARG_DOUBLE, Z_ARG_PTR, Z_ARG_STR = range(1, 8)
+C_LEVELS = ['Z_EMERG', 'Z_ALERT', 'Z_CRIT', 'Z_ERR', 'Z_WARN', 'Z_NOTICE', 'Z_INFO', 'Z_DEBUG']
+MIX_CALLS = 200000      # calls replayed, from the start of the log
+MIX_SAMPLES = 32        # argument samples per site, spread evenly over its calls
+MIX_STRING_MAX = 4000   # C99 compilers need only take string literals of 4095 bytes
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            sys.exit(f'{path}: not an ELF file')
+        self.is64 = self.data[4] == 2
+        self.end = '<' if self.data[5] == 1 else '>'
+        self.ptr = 8 if self.is64 else 4
+        if self.is64:
+            shoff, = self.unpack('Q', 0x28)
+            shentsize, shnum, shstrndx = self.unpack('HHH', 0x3A)
+        else:
+            shoff, = self.unpack('I', 0x20)
+            shentsize, shnum, shstrndx = self.unpack('HHH', 0x2E)
+        self.sections = [self.section(shoff + i * shentsize) for i in range(shnum)]
+        names = self.sections[shstrndx]
+        for sec in self.sections:
+            sec['name'] = self.cstr(names['offset'] + sec['name'])
+        self.relocs = self.relative_relocs()
+
+    def unpack(self, fmt, offset):
+        return struct.unpack_from(self.end + fmt, self.data, offset)
+
+    def section(self, offset):
+        if self.is64:
+            name, kind, _, addr, off, size, _, _, _, entsize = self.unpack('IIQQQQIIQQ', offset)
+        else:
+            name, kind, _, addr, off, size, _, _, _, entsize = self.unpack('IIIIIIIIII', offset)
+        return {'name': name, 'type': kind, 'addr': addr, 'offset': off, 'size': size,
+                'entsize': entsize}
+
+    def cstr(self, offset):
+        return self.data[offset:self.data.index(b'\0', offset)].decode(errors='replace')
+
+    def relative_relocs(self):
+        # position-independent binaries keep pointer values in RELA addends, not in place
+        relocs = {}
+        for sec in (s for s in self.sections if s['type'] == SHT_RELA):
+            size = 24 if self.is64 else 12
+            for off in range(sec['offset'], sec['offset'] + sec['size'], size):
+                if self.is64:
+                    where, info, addend = self.unpack('QQq', off)
+                    symbol = info >> 32
+                else:
+                    where, info, addend = self.unpack('IIi', off)
+                    symbol = info >> 8
+                if symbol == 0:
+                    relocs[where] = addend
+        return relocs
+
+    def file_offset(self, addr):
+        for sec in self.sections:
+            if sec['type'] != SHT_NOBITS and sec['addr'] and \
+                    sec['addr'] <= addr < sec['addr'] + sec['size']:
+                return sec['offset'] + addr - sec['addr']
+        return None
+
+    def pointer(self, addr):
+        if addr in self.relocs:
+            return self.relocs[addr]
+        return self.unpack('Q' if self.is64 else 'I', self.file_offset(addr))[0]
+
+    def string_at(self, addr):
+        offset = self.file_offset(addr)
+        return '?' if offset is None else self.cstr(offset)
+
+    def build_id(self):
+        for sec in (s for s in self.sections if s['type'] == SHT_NOTE):
+            off, end = sec['offset'], sec['offset'] + sec['size']
+            while off + 12 <= end:
+                namesz, descsz, kind = self.unpack('III', off)
+                desc = off + 12 + ((namesz + 3) & ~3)
+                if kind == NT_GNU_BUILD_ID and self.data[off + 12:off + 12 + namesz] == b'GNU\0':
+                    return self.data[desc:desc + descsz].hex()
+                off = desc + ((descsz + 3) & ~3)
+        return ''
+
+    def sites(self):
+        sec = next((s for s in self.sections if s['name'] == SECTION), None)
+        if sec is None:
+            return []
+        # ZLogSite_t: format, file, func pointers, then int line, padded to pointer alignment
+        size = (3 * self.ptr + 4 + self.ptr - 1) // self.ptr * self.ptr
+        sites = []
+        for addr in range(sec['addr'], sec['addr'] + sec['size'], size):
+            line, = self.unpack('i', self.file_offset(addr + 3 * self.ptr))
+            sites.append({'id': len(sites),
+                          'format': self.string_at(self.pointer(addr)),
+                          'file': self.string_at(self.pointer(addr + self.ptr)),
+                          'func': self.string_at(self.pointer(addr + 2 * self.ptr)),
+                          'line': line})
+        return sites
+
+
+class Args:
+    """Tagged Z_LOGB() arguments, read in order."""
+
+    def __init__(self, elf, data):
+        self.elf = elf
+        self.data = data
+        self.pos = 0
+
+    def next(self):
+        if self.pos >= len(self.data):
+            return None, None
+        tag = self.data[self.pos]
+        self.pos += 1
+        fmt = {Z_ARG_INT: 'i', Z_ARG_UINT: 'I', Z_ARG_LLONG: 'q', Z_ARG_ULLONG: 'Q',
+               Z_ARG_DOUBLE: 'd', Z_ARG_PTR: 'Q' if self.elf.is64 else 'I',
+               Z_ARG_STR: 'H'}.get(tag)
+        if fmt is None or self.pos + struct.calcsize(fmt) > len(self.data):
+            return None, None
+        value, = struct.unpack_from(self.elf.end + fmt, self.data, self.pos)
+        self.pos += struct.calcsize(fmt)
+        if tag == Z_ARG_STR:
+            if value == 0xFFFF:
+                value = '(null)'
+            else:
+                value = self.data[self.pos:self.pos + value].decode(errors='replace')
+                self.pos += len(value.encode(errors='replace'))
+        return tag, value
+
+
+def number(spec, args):
+    """A literal or '*' width or precision; returns (value or None, rest of spec)."""
+    if spec.startswith('*'):
+        tag, value = args.next()
+        return (value if tag in (Z_ARG_INT, Z_ARG_UINT) else None), spec[1:]
+    digits = len(spec) - len(spec.lstrip('0123456789'))
+    return (int(spec[:digits]) if digits else None), spec[digits:]
+
+
+def format_args(fmt, args):
+    """printf() of fmt over tagged arguments, as ZLog_BinaryFormat() does it."""
+    out = []
+    i = 0
+    while i < len(fmt):
+        if fmt[i] != '%':
+            out.append(fmt[i])
+            i += 1
+            continue
+        if fmt[i + 1:i + 2] == '%':
+            out.append('%')
+            i += 2
+            continue
+        rest = fmt[i + 1:]
+        flags = rest[:len(rest) - len(rest.lstrip('-+ #0'))]
+        rest = rest[len(flags):]
+        width, rest = number(rest, args)
+        if width is not None and width < 0:
+            flags, width = flags + '-', -width
+        precision = None
+        if rest.startswith('.'):
+            precision, rest = number(rest[1:], args)
+            precision = 0 if precision is None else (None if precision < 0 else precision)
+        rest = rest.lstrip('hlLqjzt')
+        conv, rest = rest[:1], rest[1:]
+        i = len(fmt) - len(rest)
+
+        tag, value = args.next()
+        if tag is None:
+            out.append('[z_check: missing argument]')
+            break
+        spec = '%' + flags + ('' if width is None else str(width))
+        ints = (Z_ARG_INT, Z_ARG_UINT, Z_ARG_LLONG, Z_ARG_ULLONG)
+        if conv in 'diuoxXc' and conv and tag in ints:
+            if conv in 'uoxX' and value < 0:
+                value += 1 << (32 if tag == Z_ARG_INT else 64)
+            if conv == 'c':
+                out.append((spec + 's') % chr(value & 0xFF))
+                continue
+            if conv in 'oxX' and value == 0:
+                spec = spec.replace('#', '')
+            text = (spec.replace('#', '') if conv == 'o' else spec) + \
+                ('' if precision is None else '.%d' % precision) + ('d' if conv in 'iu' else conv)
+            text = text % value
+            if conv == 'o' and '#' in flags and not text.lstrip(' -+').startswith('0'):
+                text = text.replace(text.lstrip(' '), '0' + text.lstrip(' '), 1)
+            out.append(text)
+        elif conv and conv in 'eEfFgGaA' and tag == Z_ARG_DOUBLE:
+            if conv in 'aA':
+                mantissa, exponent = float(value).hex().split('p')
+                text = mantissa.rstrip('0').rstrip('.') + 'p' + exponent
+                out.append((spec + 's') % (text.upper() if conv == 'A' else text))
+            else:
+                out.append((spec + ('' if precision is None else '.%d' % precision) + conv)
+                           % value)
+        elif conv == 'p' and tag == Z_ARG_PTR:
+            out.append((spec + 's') % ('0x%x' % value if value else '(nil)'))
+        elif conv == 's' and tag == Z_ARG_STR:
+            out.append((spec + 's') % (value if precision is None else value[:precision]))
+        elif conv and conv in 'diuoxXceEfFgGaApsc':
+            out.append('[z_check: argument mismatch]')
+            break
+        else:
+            out.append('[z_check: unsupported conversion]')
+            break
+    return ''.join(out)
+
+
+def units(elf, log, names=None):
+    """Yield (kind, stamp, value, raw) for each line or frame of a log, in order.
+
+    kind is 'line' (value: the text line), 'record' (value: the decoded line) or
+    'B'/'E' (value: the span's site). stamp is (thread, ns) from the 'T' frame
+    in front of the unit, or None. raw is (site, level, argument bytes) for a
+    record of a known site, or None. With Z_CHECK_HAS_THREAD_INFO, 'N' frames
+    name the threads, by the kernel's ID: names, if given, is filled in from
+    them, and decoded records carry the thread as text lines do.
+    """
+    sites = elf.sites()
+    build_id = elf.build_id()
+    module = '?'
+    stamp = None
+    thread = None
+    names = {} if names is None else names
+    pos = 0
+    while pos < len(log):
+        if log[pos] != FRAME_MARK:
+            end = log.find(b'\n', pos)
+            end = len(log) if end < 0 else end + 1
+            yield 'line', stamp, log[pos:end], None
+            stamp = None
+            pos = end
+        elif log[pos + 1:pos + 2] == b'H':
+            n = log[pos + 2]
+            log_id = log[pos + 3:pos + 3 + n].hex()
+            if log_id != build_id:
+                sys.exit(f'log was written by build {log_id or "(none)"}, '
+                         f'binary is build {build_id or "(none)"}')
+            pos += 3 + n
+            m = log[pos]
+            module = log[pos + 1:pos + 1 + m].decode(errors='replace')
+            pos += 1 + m
+        elif log[pos + 1:pos + 2] == b'T' and pos + 14 <= len(log):
+            stamp = struct.unpack_from('<IQ', log, pos + 2)
+            pos += 14
+        elif log[pos + 1:pos + 2] == b'N' and pos + 7 <= len(log):
+            thread, n = struct.unpack_from('<IB', log, pos + 2)
+            if n:
+                names[thread] = log[pos + 7:pos + 7 + n].decode(errors='replace')
+            pos += 7 + n
+        elif log[pos + 1:pos + 2] in (b'B', b'E') and pos + 6 <= len(log):
+            site_id, = struct.unpack_from('<I', log, pos + 2)
+            site = sites[site_id] if site_id < len(sites) else \
+                {'id': site_id, 'format': f'unknown site {site_id}', 'file': '?', 'func': '?',
+                 'line': 0}
+            yield chr(log[pos + 1]), stamp, site, None
+            stamp = thread = None
+            pos += 6
+        elif log[pos + 1:pos + 2] == b'R' and pos + 9 <= len(log):
+            level = log[pos + 2]
+            site_id, length = struct.unpack_from('<IH', log, pos + 3)
+            data = log[pos + 9:pos + 9 + length]
+            pos += 9 + length
+            if thread is None and stamp is not None and stamp[0] in names:
+                thread = stamp[0]   # named before, and stamped with the kernel's ID since
+            who = '' if thread is None else f'[{thread} {names.get(thread, "")}] '
+            if site_id >= len(sites):
+                yield 'record', stamp, \
+                    f'{module}: [?] {who}unknown site {site_id}\n'.encode(), None
+            else:
+                site = sites[site_id]
+                text = format_args(site['format'], Args(elf, data))
+                level_name = LEVELS[level] if level < len(LEVELS) else '?'
+                yield 'record', stamp, \
+                    (f'{module}: [{level_name}] {who}{os.path.basename(site["file"])}:'
+                     f'{site["line"]}:{site["func"]}: {text}\n').encode(), (site, level, data)
+            stamp = thread = None
+        else:
+            sys.exit(f'bad frame at byte {pos}')
+
+
+def decode(elf, log, write):
+    for kind, _, value, _ in units(elf, log):
+        if kind in ('line', 'record'):
+            write(value)
+
+
+LINE = re.compile(r'^(?P<module>.*?): \[(?P<level>[A-Z?]+)\] '
+                  r'(?:\[(?P<tid>\d+) (?P<thread>[^]]*)\] )?'     # with Z_CHECK_HAS_THREAD_INFO
+                  r'(?P<file>[^:]*):(?P<line>\d+):(?P<func>[^:]*): (?P<message>.*)$', re.S)
+
+
+def trace(elf, log):
+    """Chrome trace-event JSON: spans as B/E slices, stamped lines as thread instants."""
+    events = []
+    module = None
+    names = {}
+    for kind, stamp, value, _ in units(elf, log, names):
+        if stamp is None:
+            continue    # written without a stamp (a re-entrant line), so it has no place in time
+        thread, ns = stamp
+        event = {'pid': 1, 'tid': thread, 'ts': ns / 1000.0}
+        if kind in ('B', 'E'):
+            event.update(ph=kind, name=value['format'],
+                         args={'site': f'{os.path.basename(value["file"])}:{value["line"]}:'
+                                       f'{value["func"]}'})
+        else:
+            text = value.decode(errors='replace').rstrip('\n')
+            match = LINE.match(text)
+            if match:
+                module = match['module']
+                if match['tid'] is not None:
+                    names[int(match['tid'])] = match['thread']
+                event.update(ph='i', s='t', name=match['message'], cat=match['level'],
+                             args={'site': f'{match["file"]}:{match["line"]}:{match["func"]}'})
+            else:
+                event.update(ph='i', s='t', name=text)
+        events.append(event)
+    threads = sorted({e['tid'] for e in events})
+    meta = [{'ph': 'M', 'pid': 1, 'name': 'process_name', 'args': {'name': module or '?'}}]
+    meta += [{'ph': 'M', 'pid': 1, 'tid': t, 'name': 'thread_name',
+              'args': {'name': names.get(t, f'thread {t}')}} for t in threads]
+    return {'traceEvents': meta + events, 'displayTimeUnit': 'ns'}
+
+
+CONVERSION = re.compile(r'%[-+ #0]*(?P<width>\*|\d*)(?P<precision>\.(?:\*|\d*))?'
+                        r'(?P<length>hh|h|ll|l|L|q|j|z|t)?(?P<conv>[diuoxXceEfFgGaAsp%])')
+SIGNED = {'l': 'long', 'll': 'long long', 'q': 'long long', 'j': 'intmax_t', 'z': 'ptrdiff_t',
+          't': 'ptrdiff_t'}
+UNSIGNED = {'l': 'unsigned long', 'll': 'unsigned long long', 'q': 'unsigned long long',
+            'j': 'uintmax_t', 'z': 'size_t', 't': 'size_t'}
+
+
+def c_types(fmt):
+    """The C type of each argument fmt takes, in order, as the replay passes them."""
+    types = []
+    for match in CONVERSION.finditer(fmt):
+        conv, length = match['conv'], match['length'] or ''
+        if conv == '%':
+            continue
+        types += ['int'] * ((match['width'] == '*') + (match['precision'] == '.*'))
+        if conv in 'di':
+            types.append(SIGNED.get(length, 'int'))
+        elif conv in 'uoxX':
+            types.append(UNSIGNED.get(length, 'unsigned'))
+        elif conv == 'c':
+            types.append('int')
+        elif conv == 's':
+            types.append('const char *')
+        elif conv == 'p':
+            types.append('const void *')
+        else:
+            types.append('long double' if length == 'L' else 'double')
+    return types
+
+
+def c_string(text):
+    out = []
+    for byte in text.encode(errors='replace')[:MIX_STRING_MAX]:
+        char = chr(byte)
+        out.append(char if 0x20 <= byte < 0x7F and char not in '\\"?' else '\\%03o' % byte)
+    return '"' + ''.join(out) + '"'
+
+
+def c_value(ctype, value):
+    if ctype == 'const char *':
+        return c_string(str(value))
+    if ctype == 'const void *':
+        return f'(const void *)(size_t){int(value):#x}u' if value else 'NULL'
+    if ctype.endswith('double'):
+        value = float(value)
+        if value != value:
+            return '__builtin_nan("")'
+        if value in (float('inf'), float('-inf')):
+            return ('-' if value < 0 else '') + '__builtin_inf()'
+        return f'({ctype}){value.hex()}'
+    value = int(value)
+    if value == -(1 << 63):
+        return f'({ctype})(-9223372036854775807LL - 1)'
+    if -(1 << 31) < value < (1 << 31):
+        return f'({ctype}){value}'
+    return f'({ctype}){value}{"LL" if value < 0 else "ULL"}'
+
+
+def mix(elf, log, name):
+    """A replay mix for bench/bench_replay.c, as C source."""
+    sites = {}      # (site id or text site, level) -> {'format', 'types', 'label', 'calls'}
+    order = []      # site index of each call
+    for kind, _, value, raw in units(elf, log):
+        if len(order) >= MIX_CALLS:
+            break
+        if kind == 'record' and raw is not None:
+            site, level, data = raw
+            key = (site['id'], level)
+            if key not in sites:
+                sites[key] = {'format': site['format'], 'types': c_types(site['format']),
+                              'label': f'{os.path.basename(site["file"])}:{site["line"]}:'
+                                       f'{site["func"]}', 'logb': True, 'calls': []}
+            args = Args(elf, data)
+            values = []
+            while True:
+                tag, arg = args.next()
+                if tag is None:
+                    break
+                values.append(arg)
+        elif kind == 'line':
+            match = LINE.match(value.decode(errors='replace'))
+            if not match or match['level'] not in LEVELS:
+                continue
+            level = LEVELS.index(match['level'])
+            key = (f'{match["file"]}:{match["line"]}:{match["func"]}', level)
+            if key not in sites:
+                sites[key] = {'format': '%s', 'types': ['const char *'], 'label': key[0],
+                              'logb': False, 'calls': []}
+            values = [match['message'].rstrip('\n')]
+        else:
+            continue
+        if len(values) != len(sites[key]['types']):
+            continue    # arguments don't fit the format; nothing sensible to replay
+        sites[key]['calls'].append(values)
+        order.append(key)
+
+    keys = [key for key in sites if sites[key]['calls']]
+    if len(keys) > 0xFFFF:
+        sys.exit(f'{len(keys)} sites; the replay takes at most {0xFFFF}')
+    index = {key: i for i, key in enumerate(keys)}
+    out = [f'/* Replay mix from {name} (build {elf.build_id() or "unknown"}): {len(order)} calls at',
+           f' * {len(keys)} sites. Generated by tools/zlogb.py mix for bench/bench_replay.c. */',
+           '#include <stddef.h>', '#include <stdint.h>', '',
+           '#if defined(Z_CHECK_HAS_LOGB) && (__STDC_VERSION__ >= 201112L)',
+           '#define REPLAY_LOGB Z_LOGB', '#else', '#define REPLAY_LOGB Z_LOG', '#endif', '']
+    seen = {}
+    for i, key in enumerate(keys):
+        site = sites[key]
+        calls = site['calls']
+        samples = [calls[j * len(calls) // MIX_SAMPLES] for j in range(min(MIX_SAMPLES, len(calls)))]
+        seen[key] = 0
+        args = ''
+        if site['types']:
+            fields = ' '.join(f'{t}{"" if t.endswith("*") else " "}a{n};'
+                              for n, t in enumerate(site['types']))
+            out.append(f'static const struct {{ {fields} }} m_site{i}[] = {{')
+            for sample in samples:
+                out.append('    { ' + ', '.join(c_value(t, v) for t, v in
+                                                 zip(site['types'], sample)) + ' },')
+            out.append('};')
+            args = ''.join(f', m_site{i}[sample].a{n}' for n in range(len(site['types'])))
+        out.append(f'static void ReplaySite{i}(const unsigned sample) {{')
+        if not site['types']:
+            out.append('    (void)sample;')
+        out.append(f'    {"REPLAY_LOGB" if site["logb"] else "Z_LOG"}({C_LEVELS[key[1]]}, '
+                   f'{c_string(site["format"])}{args});')
+        out.append('}')
+        out.append('')
+
+    out.append('static void (* const m_replaySites[])(const unsigned sample) = {')
+    out += [f'    ReplaySite{i},' for i in range(len(keys))]
+    out.append('};')
+    out.append('static const char * const m_replayNames[] = {')
+    out += [f'    {c_string(sites[key]["label"])},' for key in keys]
+    out.append('};')
+    out.append('static const unsigned short m_replayCalls[][2] = {    /* site, sample */')
+    pairs = []
+    for key in order:
+        calls = len(sites[key]['calls'])
+        pairs.append(f'{{{index[key]}, {seen[key] * min(MIX_SAMPLES, calls) // calls}}}')
+        seen[key] += 1
+    for start in range(0, len(pairs), 8):
+        out.append('    ' + ', '.join(pairs[start:start + 8]) + ',')
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+def main(argv):
+    if len(argv) < 3 or argv[1] not in ('table', 'decode', 'trace', 'mix'):
+        sys.exit('\n'.join(__doc__.strip().splitlines()[-4:]))
+    elf = Elf(argv[2])
+    if argv[1] == 'table':
+        json.dump({'build_id': elf.build_id(), 'sites': elf.sites()}, sys.stdout, indent=1)
+        print()
+    else:
+        if len(argv) > 3:
+            with open(argv[3], 'rb') as f:
+                log = f.read()
+        else:
+            log = sys.stdin.buffer.read()
+        if argv[1] == 'decode':
+            decode(elf, log, sys.stdout.buffer.write)
+        elif argv[1] == 'mix':
+            sys.stdout.write(mix(elf, log, os.path.basename(argv[3]) if len(argv) > 3 else 'stdin'))
+        else:
+            json.dump(trace(elf, log), sys.stdout)
+            print()
+
+
+if __name__ == '__main__':
+    main(sys.argv)
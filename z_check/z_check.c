@@ -12,31 +12,284 @@
 /******************************************************************************
  *                                                                 Inclusions */
 #include "z_check.h"
+#ifndef Z_CHECK_FREESTANDING
 #include <stdio.h>
+#endif
 #include <string.h>
 #ifdef USE_BSD
 #include <bsd/string.h>
 #endif
 #include <stdarg.h>
 #include <stdbool.h>
-#ifdef Z_CHECK_HAS_SYSLOG
+#include <stdint.h>
+#if defined(Z_CHECK_HAS_SYSLOG) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SYSLOG))
 #include <syslog.h>
 #endif
+#ifdef Z_CHECK_HAS_ARENA
+#include <stddef.h>
+#include <pthread.h>
+#endif
+#ifdef Z_CHECK_HAS_ASYNC
+#include <stdlib.h>
+#endif
+#if defined(Z_CHECK_HAS_ASYNC) || defined(Z_CHECK_HAS_TIMING) || defined(Z_CHECK_HAS_TRACE) || \
+    defined(Z_CHECK_HAS_SHARED_RING) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT))
+#include <time.h>
+#endif
+#ifdef Z_CHECK_LOGB_IDS
+#include <elf.h>
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#endif
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdlib.h>
+#endif
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_JOURNAL)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#endif
+#ifdef Z_CHECK_HAS_SHARED_RING
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT)
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif
+#if defined(Z_CHECK_FILE_WRITEBACK) && \
+    (!defined(Z_CHECK_STATIC_CONFIG) || (Z_CHECK_LOG_FUNC == Z_FILE))
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SPOOL)
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#endif
 
 
 /******************************************************************************
  *                                                                    Defines */
-#ifdef Z_CHECK_STATIC_CONFIG
-    #define FUNC_MAYBE_UNUSED __attribute__((unused))
-#else
-    #define FUNC_MAYBE_UNUSED
+#ifndef Z_CHECK_STATIC_CONFIG
     #define DEFAULT_MODULE_NAME "z_check"
 #endif
 
+/* Where ZLog() formats: into an arena record for the writer thread, a per-thread static
+ * buffer, or its own stack frame */
+#if !defined(Z_CHECK_HAS_ASYNC) && defined(Z_CHECK_LOW_STACK)
+    #define EMIT_STATIC_BUFFER
+#elif !defined(Z_CHECK_HAS_ASYNC)
+    #define EMIT_ON_STACK
+#endif
+
+/* Sinks compiled in. Static config builds only its own sink and calls it directly; dynamic
+ * config keeps them all and picks one through m_ZLogFunc at ZLog_Open(). */
+#ifndef Z_CHECK_STATIC_CONFIG
+    #define STDOUT_SINK
+    #define STDERR_SINK
+    #define FILE_SINK
+    #ifdef Z_CHECK_HAS_SYSLOG
+    #define SYSLOG_SINK
+    #endif
+    #define TARGET_SINK m_ZLogFunc
+#elif Z_CHECK_LOG_FUNC == Z_STDOUT
+    #define STDOUT_SINK
+    #define TARGET_SINK ZLog_StdOut
+#elif Z_CHECK_LOG_FUNC == Z_STDERR
+    #define STDERR_SINK
+    #define TARGET_SINK ZLog_StdErr
+#elif Z_CHECK_LOG_FUNC == Z_WRITE
+    #define WRITE_SINK
+    #define WRITE_FUNC Z_CHECK_WRITE_FUNC
+    #ifndef EMIT_STATIC_BUFFER
+    #define TARGET_SINK ZLog_Write    /* with a static buffer, ZLog() builds every line itself */
+    #endif
+#elif Z_CHECK_LOG_FUNC == Z_SYSLOG
+    #define SYSLOG_SINK
+    #define TARGET_SINK ZLog_Syslog
+#elif (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT)
+    #define WRITE_SINK              /* built as for Z_WRITE, with the library's own hook */
+    #define DIRECT_SINK
+    #define WRITE_FUNC ZLog_DirectWrite
+    #ifndef EMIT_STATIC_BUFFER
+    #define TARGET_SINK ZLog_Write
+    #endif
+#elif Z_CHECK_LOG_FUNC == Z_FILE
+    #define FILE_SINK
+    #define TARGET_SINK ZLog_File
+#elif Z_CHECK_LOG_FUNC == Z_CAPTURE
+    #define WRITE_SINK              /* built as for Z_WRITE, with the library's own hook */
+    #define CAPTURE_SINK
+    #define WRITE_FUNC ZLog_CaptureWrite
+    #ifndef EMIT_STATIC_BUFFER
+    #define TARGET_SINK ZLog_Write
+    #endif
+#elif Z_CHECK_LOG_FUNC == Z_JOURNAL
+    #define JOURNAL_SINK
+    #define TARGET_SINK ZLog_Journal
+#elif Z_CHECK_LOG_FUNC == Z_NET
+    #define WRITE_SINK              /* built as for Z_WRITE, with the library's own hook */
+    #define NET_SINK
+    #define WRITE_FUNC ZLog_NetWrite
+    #ifndef EMIT_STATIC_BUFFER
+    #define TARGET_SINK ZLog_Write
+    #endif
+#elif Z_CHECK_LOG_FUNC == Z_SPOOL
+    #define WRITE_SINK              /* built as for Z_WRITE, with the library's own hook */
+    #define SPOOL_SINK
+    #define WRITE_FUNC ZLog_SpoolWrite
+    #ifndef EMIT_STATIC_BUFFER
+    #define TARGET_SINK ZLog_Write
+    #endif
+#else
+    #error "invalid Z_CHECK_LOG_FUNC"
+#endif
+
+/* The buffered file sink's lines, sent to disk and dropped from the page cache by the writer
+ * thread */
+#if defined(Z_CHECK_FILE_WRITEBACK) && defined(FILE_SINK)
+    #define FILE_WRITEBACK
+#endif
+
+/* With the shared ring, lines go into it, and whichever process drains it hands them to the
+ * target */
+#ifdef Z_CHECK_HAS_SHARED_RING
+    #define ZLOG_SINK ZLog_RingPut
+#elif defined(TARGET_SINK)
+    #define ZLOG_SINK TARGET_SINK
+#endif
+
+/* Z_WRITE-style targets have ZLog() build and write the whole line, unless the writer thread or
+ * the shared ring takes the message on its own */
+#if defined(WRITE_SINK) && !defined(Z_CHECK_HAS_ASYNC) && !defined(Z_CHECK_HAS_SHARED_RING)
+    #define EMIT_WHOLE_LINE
+#endif
+
+/* There, ZLog_Errno() and ZLog_Check() also build the whole line from the caller's format,
+ * rather than formatting the message apart for ZLog_Write() to copy */
+#if defined(EMIT_WHOLE_LINE) && !defined(EMIT_STATIC_BUFFER)
+    #define NOTED_WHOLE_LINE
+#endif
+
+#if Z_CHECK_FORMATTER == Z_FMT_COMPACT
+    #define COMPACT_FORMATTER
+#elif Z_CHECK_FORMATTER != Z_FMT_LIBC
+    #error "invalid Z_CHECK_FORMATTER"
+#endif
+
+#ifdef COMPACT_FORMATTER
+    #define ZLOG_VSNPRINTF ZLog_VFormat
+#else
+    #define ZLOG_VSNPRINTF vsnprintf
+#endif
+
+/* Messages are formatted on their own, apart from the line, unless Z_WRITE builds the line */
+#ifndef EMIT_WHOLE_LINE
+    #define FORMAT_FAILED "[z_check: failed to format message!]"
+#endif
+
+#ifdef Z_CHECK_HEADER_ONLY
+    /* z_check.h checks levels inline, so the current level needs external linkage */
+    #define m_logLevel ZLog_currentLevel
+    #define LEVEL_STORAGE
+#else
+    #define LEVEL_STORAGE static
+#endif
+
 #define PURE_FUNC __attribute__((pure))     /* no side effects, global memory read-only */
 #define CONST_FUNC __attribute__((const))   /* no side effects, no global memory access */
-#define MESSAGE_MAX_LEN 512
 #define MAX_LEGAL_LEVEL ((unsigned)Z_DEBUG)
+#define MESSAGE_MAX_LEN 512
+
+#if defined(Z_CHECK_HAS_ARENA) || defined(Z_CHECK_LOW_STACK) || defined(Z_CHECK_HAS_TRACE) || \
+    defined(Z_CHECK_HAS_THREAD_INFO) || defined(SPOOL_SINK)
+    #define THREAD_LOCAL Z_CHECK_THREAD_LOCAL
+#endif
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    #define THREAD_NAME_MAX 16  /* the kernel's limit, terminator included */
+#endif
+
+/* Parts with locks, threads or a pid to put right in a fork()ed child, through one set of
+ * handlers */
+#if defined(Z_CHECK_HAS_ASYNC) || defined(Z_CHECK_HAS_SHARED_RING) || \
+    defined(Z_CHECK_HAS_THREAD_INFO) || defined(NET_SINK) || defined(DIRECT_SINK) || \
+    defined(SPOOL_SINK)
+    #define FORK_HANDLERS
+#endif
+
+#ifdef Z_CHECK_HAS_ARENA
+    #define ARENA_CLASSES Z_CHECK_ARENA_CLASSES
+    #define ARENA_CLASS_SIZE(sizeClass) (256u << (2u * (sizeClass)))
+    #define ARENA_BYTES ((Z_CHECK_ARENA_BLOCKS_256 * ARENA_CLASS_SIZE(0)) + \
+                         (Z_CHECK_ARENA_BLOCKS_1K * ARENA_CLASS_SIZE(1)) + \
+                         (Z_CHECK_ARENA_BLOCKS_4K * ARENA_CLASS_SIZE(2)))
+#endif
+
+#ifdef Z_CHECK_HAS_ASYNC
+    /* message bytes that fit in a record of the given arena class */
+    #define RECORD_CAPACITY(sizeClass) \
+        (ARENA_CLASS_SIZE(sizeClass) - sizeof(ZLogBlock_t) - sizeof(ZLogRecord_t))
+    #define WRITER_IDLE_NS 10000000L    /* longest the writer sleeps without a wakeup */
+#endif
+
+#ifdef Z_CHECK_LOGB_IDS
+    #define FRAME_MARK 0x1E     /* record separator; text lines start with the module name */
+    #define FRAME_HEAD 9        /* mark, 'R', level, 4-byte ID, 2-byte length */
+    #define FRAME_ARGS_MAX (1 + (8 * (1 + sizeof(unsigned short) + Z_CHECK_LOGB_STR_MAX)))
+    #ifdef Z_CHECK_HAS_TRACE
+    #define FRAME_STAMP 14      /* mark, 'T', 4-byte thread, 8-byte time; ahead of each unit */
+    #define FRAME_SPAN 6        /* mark, 'B' or 'E', 4-byte ID */
+    #else
+    #define FRAME_STAMP 0
+    #endif
+    #ifdef Z_CHECK_HAS_THREAD_INFO
+    #define FRAME_THREAD (7 + THREAD_NAME_MAX - 1)  /* mark, 'N', 4-byte ID, name length, name */
+    #else
+    #define FRAME_THREAD 0
+    #endif
+    #define FRAME_MAX (FRAME_THREAD + FRAME_STAMP + FRAME_HEAD + FRAME_ARGS_MAX)
+    #define BUILD_ID_MAX 64
+    #define NOTE_ALIGN(n, a) (((n) + ((a) - 1)) & ~(size_t)((a) - 1))
+    #if UINTPTR_MAX > 0xFFFFFFFFu
+    #define ELF_EHDR Elf64_Ehdr
+    #define ELF_PHDR Elf64_Phdr
+    #define ELF_NHDR Elf64_Nhdr
+    #else
+    #define ELF_EHDR Elf32_Ehdr
+    #define ELF_PHDR Elf32_Phdr
+    #define ELF_NHDR Elf32_Nhdr
+    #endif
+#endif
 
 
 /******************************************************************************
@@ -44,6 +297,128 @@
 typedef void (*ZLogFn_t)(const ZLogLevel_t level, const char * const file, const int line,
                          const char * const func, const char * const message);
 
+/* Bounded output buffer; len keeps counting past size so truncation can be detected. */
+typedef struct ZLogOut_s
+{
+    char *buf;
+    size_t size;
+    size_t len;
+} ZLogOut_t;
+
+#ifdef COMPACT_FORMATTER
+#if Z_CHECK_FMT_HAS_LONG
+typedef unsigned long long ZLogUInt_t;
+#else
+typedef uintptr_t ZLogUInt_t;   /* wide enough for %p, native width for the rest */
+#endif
+#endif /* COMPACT_FORMATTER */
+
+#ifdef Z_CHECK_HAS_ARENA
+/* Header in front of every arena block. Blocks always go back to the arena they came from. */
+typedef struct ZLogBlock_s
+{
+    struct ZLogBlock_s *next;       /* free list or return stack link */
+    struct ZLogArena_s *arena;      /* owning arena */
+    unsigned sizeClass;
+} __attribute__((aligned(16))) ZLogBlock_t;
+
+/**
+ * A thread's private pool of record blocks.
+ *
+ * Only the owning thread touches freeList, so allocating and freeing on the owner needs no
+ * atomics. Other threads (e.g. a writer thread) give blocks back by pushing onto returned, a
+ * lock-free stack; the owner takes the whole stack with one exchange when its free list runs dry.
+ * Pushing with compare-and-swap while popping only by exchange is free of ABA.
+ */
+typedef struct ZLogArena_s
+{
+    ZLogBlock_t *freeList[ARENA_CLASSES];
+    ZLogBlock_t *returned[ARENA_CLASSES];
+    int owned;                                  /* claimed by a live thread */
+    unsigned freeNext;                          /* on m_arenaFree: index + 1 of the next, or 0 */
+    unsigned carved[ARENA_CLASSES];             /* blocks split from storage; owner writes */
+    unsigned long allocs[ARENA_CLASSES];        /* written by owner only */
+    unsigned long frees[ARENA_CLASSES];         /* written by owner only */
+    unsigned long remoteFrees[ARENA_CLASSES];   /* written atomically by anyone */
+    unsigned long highWater[ARENA_CLASSES];     /* written by owner only */
+    unsigned long failures;                     /* written by owner only */
+    unsigned char storage[ARENA_BYTES] __attribute__((aligned(64)));
+} ZLogArena_t;
+#endif /* Z_CHECK_HAS_ARENA */
+
+#ifdef Z_CHECK_HAS_TRACE
+/* Who wrote a record, and when */
+typedef struct ZLogStamp_s
+{
+    uint32_t thread;            /* numbered from 1 in the order threads first write */
+    unsigned long long ns;      /* ZLog_TimeNow() */
+} ZLogStamp_t;
+#endif /* Z_CHECK_HAS_TRACE */
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+/* A thread as its lines show it, cached in its thread-local storage */
+typedef struct ZLogThread_s
+{
+    uint32_t tid;               /* the kernel's thread ID, 0 if unknown */
+    bool loaded;                /* tid and name have been read */
+    bool named;                 /* the name has gone out in a frame since it was read */
+    char name[THREAD_NAME_MAX];
+} ZLogThread_t;
+#endif /* Z_CHECK_HAS_THREAD_INFO */
+
+#ifdef Z_CHECK_HAS_ASYNC
+/* A record on its way to the writer thread, in an arena block of the thread that logged it.
+ * file and func point at string literals, so they outlive the call. */
+typedef struct ZLogRecord_s
+{
+    struct ZLogRecord_s *next;      /* queue link */
+    const char *file;
+    const char *func;
+    int line;
+    ZLogLevel_t level;
+#ifdef Z_CHECK_HAS_LOGB
+    const char *format;             /* set for Z_LOGB() records, whose message holds arguments */
+    size_t argsLen;
+#endif
+#ifdef Z_CHECK_LOGB_IDS
+    const ZLogSite_t *site;         /* set to write the record as a frame */
+#endif
+#ifdef Z_CHECK_HAS_TRACE
+    ZLogStamp_t stamp;              /* taken on the caller's thread */
+    char span;                      /* 'B' or 'E' for a span point, else 0 */
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    ZLogThread_t thread;            /* copied from the caller's thread */
+#endif
+    char message[];
+} ZLogRecord_t;
+#endif /* Z_CHECK_HAS_ASYNC */
+
+#ifdef Z_CHECK_HAS_CALLSITES
+/* A ZLog_CallsiteSet() call, kept for sites that have not run yet */
+typedef struct ZLogCallsiteRule_s
+{
+    const char *file;
+    int line;
+    int enabled;
+    int ready;                      /* set once the fields above are written */
+} ZLogCallsiteRule_t;
+#endif /* Z_CHECK_HAS_CALLSITES */
+
+#ifdef Z_CHECK_HAS_LOGB
+/* One Z_LOGB() argument, read back */
+typedef struct ZLogArg_s
+{
+    ZLogArgType_t type;
+    long long s;                /* integers, sign-extended */
+    unsigned long long u;       /* integers, at their own width */
+    double d;
+    const void *p;
+    const char *str;            /* not NUL-terminated */
+    size_t strLen;
+} ZLogArg_t;
+#endif /* Z_CHECK_HAS_LOGB */
+
 
 /******************************************************************************
  *                                                      Function declarations */
@@ -54,53 +429,473 @@ static inline bool ZLog_LevelIsLegal(const ZLogLevel_t level) CONST_FUNC;
 #endif
 
 static inline bool ZLog_LevelPasses(const ZLogLevel_t level) PURE_FUNC;
+static void ZLog_Noted(const ZLogLevel_t level, const char * const file, const int line,
+                       const char * const func, const int errnum, const long * const status,
+                       const char * const format, va_list args);
+#ifndef NOTED_WHOLE_LINE
+static void ZLog_NoteFormat(char * const message, const int errnum, const long * const status,
+                            const char * const format, va_list args);
+#endif
+static void ZLog_OutNotes(ZLogOut_t * const out, const int errnum, const long * const status);
+#ifndef COMPACT_FORMATTER
+static int ZLog_Format(char * const buf, const size_t size, const char * const format, ...)
+    __attribute__((format(printf, 3, 4))); /* Flawfinder: ignore */
+    /* Warning: use of "printf"
+       "Ignore" justification: an attribute, as on ZLog(). */
+#endif
 static inline const char * ZLog_LevelStr(const ZLogLevel_t level) CONST_FUNC;
+#ifdef EMIT_STATIC_BUFFER
+static void ZLog_EmitRaw(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const format);
+#endif
+#ifdef EMIT_ON_STACK
+static void ZLog_EmitOnStack(const ZLogLevel_t level, const char * const file, const int line,
+                             const char * const func, const char * const format, va_list args);
+#endif
+#ifndef Z_CHECK_HAS_ASYNC
+static void ZLog_Emit(char * const message, const ZLogLevel_t level, const char * const file,
+                      const int line, const char * const func, const char * const format,
+                      va_list args);
+#endif
+#ifndef Z_CHECK_FREESTANDING
+static void ZLog_SinkFlush(void);
 static inline void ZLog_StdFile(FILE *outfile, const ZLogLevel_t level, const char * const file,
                                 const int line, const char * const func, const char * const message);
-static void ZLog_StdErr(const ZLogLevel_t level, const char * const file, const int line,
-                        const char * const func, const char * const message) FUNC_MAYBE_UNUSED;
+#endif
+#ifdef STDOUT_SINK
 static void ZLog_StdOut(const ZLogLevel_t level, const char * const file, const int line,
-                        const char * const func, const char * const message) FUNC_MAYBE_UNUSED;
-#ifdef Z_CHECK_HAS_SYSLOG
+                        const char * const func, const char * const message);
+#endif
+#ifdef STDERR_SINK
+static void ZLog_StdErr(const ZLogLevel_t level, const char * const file, const int line,
+                        const char * const func, const char * const message);
+#endif
+#ifdef FILE_SINK
+static FILE * ZLog_FileOpen(const char * const path);
+static FILE * ZLog_FileGet(void);
+static void ZLog_File(const ZLogLevel_t level, const char * const file, const int line,
+                      const char * const func, const char * const message);
+#endif
+#ifdef FILE_WRITEBACK
+static void ZLog_FileWriteback(void);
+#ifndef Z_CHECK_STATIC_CONFIG
+static void ZLog_FileWritebackReset(void);
+#endif
+#endif
+#if defined(WRITE_SINK) && !defined(EMIT_STATIC_BUFFER)
+static void ZLog_Write(const ZLogLevel_t level, const char * const file, const int line,
+                       const char * const func, const char * const message);
+#endif
+#ifdef NOTED_WHOLE_LINE
+static void ZLog_WriteNoted(const ZLogLevel_t level, const char * const file, const int line,
+                            const char * const func, const int errnum, const long * const status,
+                            const char * const format, va_list args);
+#endif
+#ifdef WRITE_SINK
+static void ZLog_OutPrefix(ZLogOut_t * const out, const ZLogLevel_t level, const char * const file,
+                           const int line, const char * const func);
+static void ZLog_OutLine(ZLogOut_t * const out);
+#endif
+#ifdef CAPTURE_SINK
+static void ZLog_CaptureWrite(const char * const buf, const size_t len);
+#endif
+#ifdef JOURNAL_SINK
+static void ZLog_Journal(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const message);
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_JournalWriterInit(void);
+static inline bool ZLog_JournalPending(void);
+static void ZLog_JournalSendBatch(void);
+#endif
+#endif
+#ifdef NET_SINK
+static void ZLog_NetWrite(const char * const buf, const size_t len);
+static void ZLog_NetFlush(void);
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_NetIdle(void);
+#endif
+static void ZLog_NetExit(void);
+static void ZLog_NetForkPrepare(void);
+static void ZLog_NetForkParent(void);
+static void ZLog_NetForkChild(void);
+#endif
+#ifdef DIRECT_SINK
+static void ZLog_DirectWrite(const char * const buf, const size_t len);
+static void ZLog_DirectFlush(void);
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_DirectIdle(void);
+#endif
+static void ZLog_DirectForkPrepare(void);
+static void ZLog_DirectForkParent(void);
+static void ZLog_DirectForkChild(void);
+#endif
+#ifdef SPOOL_SINK
+static void ZLog_SpoolWrite(const char * const buf, const size_t len);
+static void ZLog_SpoolFlush(void);
+static void ZLog_SpoolForkPrepare(void);
+static void ZLog_SpoolForkParent(void);
+static void ZLog_SpoolForkChild(void);
+#endif
+#ifdef Z_CHECK_HAS_SHARED_RING
+static void ZLog_RingPut(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const message);
+static void ZLog_RingFlush(void);
+static void ZLog_RingForkChild(void);
+#endif
+#if defined(EMIT_WHOLE_LINE) || defined(COMPACT_FORMATTER)
+static void ZLog_OutVPrintf(ZLogOut_t * const out, const char * const format, va_list args);
+#endif
+#if defined(COMPACT_FORMATTER) || defined(Z_CHECK_HAS_LOGB)
+static inline void ZLog_OutChar(ZLogOut_t * const out, const char c);
+#endif
+#ifdef COMPACT_FORMATTER
+static inline int ZLog_VFormat(char * const buf, const size_t size, const char * const format,
+                               va_list args);
+static void ZLog_OutPad(ZLogOut_t * const out, const char pad, unsigned count);
+static void ZLog_OutStr(ZLogOut_t * const out, const char * const str, const size_t maxLen,
+                        const unsigned width, const bool leftAlign);
+static void ZLog_OutNum(ZLogOut_t * const out, ZLogUInt_t value, const bool negative,
+                        const unsigned base, const bool upper, const unsigned width,
+                        const bool leftAlign, const char pad);
+#endif
+#ifdef SYSLOG_SINK
 static inline int ZLog_Level2Syslog(const ZLogLevel_t level) CONST_FUNC;
 static void ZLog_Syslog(const ZLogLevel_t level, const char * const file, const int line,
                         const char * const func, const char * const message);
 #endif
+#if defined(Z_CHECK_HAS_ARENA) && !defined(Z_CHECK_HAS_ASYNC) && !defined(EMIT_WHOLE_LINE)
+static void ZLog_LongMessage(const ZLogLevel_t level, const char * const file, const int line,
+                             const char * const func, const char * const truncated,
+                             const size_t len, const char * const format, va_list args);
+#endif
+#ifdef Z_CHECK_HAS_ARENA
+static ZLogArena_t * ZLog_ArenaGet(void);
+static void ZLog_ArenaKeyInit(void);
+static void ZLog_ArenaRelease(void *arena);
+static ZLogArena_t * ZLog_ArenaClaim(void);
+static void ZLog_ArenaGrow(ZLogArena_t * const arena, const unsigned sizeClass);
+static bool ZLog_ArenaBudgetTake(const unsigned long bytes);
+static void * ZLog_ArenaAlloc(const size_t size);
+static void ZLog_ArenaFree(void * const ptr);
+static inline unsigned long ZLog_StatRead(const unsigned long * const stat);
+static inline void ZLog_StatBump(unsigned long * const stat);
+#endif
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_EmitAsync(const ZLogLevel_t level, const char * const file, const int line,
+                           const char * const func, const char * const format, va_list args);
+static void ZLog_EnqueueMsg(const ZLogLevel_t level, const char * const file, const int line,
+                            const char * const func, const char * const message);
+static ZLogRecord_t * ZLog_RecordAlloc(size_t * const capacity);
+static void ZLog_AsyncDrain(void);
+static inline bool ZLog_AsyncBehind(const unsigned long target);
+static void ZLog_Enqueue(ZLogRecord_t * const record, const ZLogLevel_t level,
+                         const char * const file, const int line, const char * const func);
+static void ZLog_QueuePush(ZLogRecord_t * const record);
+static ZLogRecord_t * ZLog_QueuePop(void);
+static void ZLog_AsyncStart(void);
+static void ZLog_AsyncStop(void);
+static void ZLog_AsyncForkChild(void);
+static void * ZLog_Writer(void *unused);
+static void ZLog_WriterIdle(unsigned long * const reportedDrops);
+static void ZLog_RecordSink(const ZLogRecord_t * const record);
+#endif
+#ifdef Z_CHECK_HAS_LOGB
+#ifdef Z_CHECK_HAS_ASYNC
+static ZLogRecord_t * ZLog_RecordArgs(const unsigned char * const args, const size_t len);
+#else
+static void ZLog_EmitBinary(char * const message, const ZLogLevel_t level,
+                            const char * const file, const int line, const char * const func,
+                            const char * const format, const unsigned char * const args,
+                            const size_t len);
+#endif
+static void ZLog_OutBinary(ZLogOut_t * const out, const char * const format,
+                           const unsigned char * const args, const size_t len);
+static bool ZLog_SpecNum(const char ** const f, const unsigned char * const args,
+                         const size_t len, size_t * const pos, int * const value);
+static void ZLog_OutSpec(ZLogOut_t * const out, const char * const spec, ...);
+static bool ZLog_ArgNext(const unsigned char * const args, const size_t len, size_t * const pos,
+                         ZLogArg_t * const arg);
+static inline bool ZLog_ArgIsInt(const ZLogArg_t * const arg) PURE_FUNC;
+#endif
+#ifdef Z_CHECK_HAS_CALLSITES
+static bool ZLog_CallsiteMatches(const ZLogCallsite_t * const site, const char * const file,
+                                 const int line) PURE_FUNC;
+#endif
+#if defined(Z_CHECK_HAS_LOG_COST) || defined(Z_CHECK_HAS_TIMING)
+static const char * ZLog_BaseName(const char * const path) PURE_FUNC;
+#endif
+#ifdef Z_CHECK_HAS_LOG_COST
+static inline unsigned ZLog_CostBucket(const unsigned long long cycles) CONST_FUNC;
+static inline unsigned long long ZLog_CostBucketFloor(const unsigned bucket) CONST_FUNC;
+static unsigned long long ZLog_CostPercentile(const ZLogCost_t * const cost,
+                                              const unsigned long calls, const unsigned percent);
+static const ZLogCallsite_t * ZLog_CostNext(const ZLogCallsite_t * const after);
+#endif
+#ifdef Z_CHECK_HAS_TIMING
+static void ZLog_TimeRegister(ZLogTimeSite_t * const site);
+static inline unsigned ZLog_TimeBucket(const unsigned long us) CONST_FUNC;
+#endif
+#ifdef Z_CHECK_LOGB_IDS
+static void ZLog_WriteFrame(unsigned char * const frame, const ZLogLevel_t level,
+                            const ZLogSite_t * const site, const unsigned char * const args,
+                            const size_t len);
+static void ZLog_WriteFrameHeader(void);
+static size_t ZLog_BuildId(unsigned char * const id);
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+static inline ZLogThread_t * ZLog_ThreadSelf(void);
+static inline const ZLogThread_t * ZLog_ThreadGet(void);
+static void ZLog_ThreadLoad(const char * const name);
+static void ZLog_ThreadForkChild(void);
+#ifdef Z_CHECK_LOGB_IDS
+static size_t ZLog_PutThread(unsigned char * const frame);
+#endif
+#endif
+#ifdef Z_CHECK_HAS_TRACE
+static void ZLog_WriteSpan(const char kind, const ZLogSite_t * const site);
+static size_t ZLog_PutStamp(unsigned char * const frame);
+static void ZLog_OutStamp(ZLogOut_t * const out);
+static void ZLog_StampGet(ZLogStamp_t * const stamp);
+#endif
+#ifdef FORK_HANDLERS
+static void ZLog_ForkInit(void);
+static void ZLog_ForkPrepare(void);
+static void ZLog_ForkParent(void);
+static void ZLog_ForkChild(void);
+#endif
 
 
 /******************************************************************************
  *                                                                       Data */
+#if defined(Z_CHECK_HAS_ASYNC) && !defined(Z_CHECK_HAS_ARENA)
+    #error "Async Z_CHECK formats into record arenas; define Z_CHECK_HAS_ARENA"
+#endif
+#if defined(Z_CHECK_HAS_LOGB) && defined(Z_CHECK_FREESTANDING)
+    #error "Z_LOGB() records are formatted with snprintf(), which freestanding Z_CHECK lacks"
+#endif
+#ifdef Z_CHECK_HAS_LOGB
+    Z_CT_ASSERT_DECL(Z_CHECK_LOGB_STR_MAX < 0xFFFF);    /* 0xFFFF marks a NULL string */
+#endif
+#if defined(Z_CHECK_HAS_LOG_COST) && defined(COMPACT_FORMATTER) && !Z_CHECK_FMT_HAS_LONG
+    #error "ZLog_CostReport() prints with %llu; set Z_CHECK_FMT_HAS_LONG"
+#endif
+#if defined(Z_CHECK_HAS_TIMING) && defined(Z_CHECK_FREESTANDING)
+    #error "Z_TIME_SCOPE() reads clock_gettime(), which freestanding Z_CHECK lacks"
+#endif
+#if defined(Z_CHECK_LOGB_IDS) && (!defined(Z_CHECK_HAS_LOGB) || !defined(WRITE_SINK))
+    #error "Z_CHECK_LOGB_IDS needs Z_CHECK_HAS_LOGB and a Z_WRITE or Z_CAPTURE target"
+#endif
+#if defined(Z_CHECK_HAS_TRACE) && !defined(Z_CHECK_LOGB_IDS)
+    #error "Z_CHECK_HAS_TRACE writes span sites as IDs; define Z_CHECK_LOGB_IDS"
+#endif
+#if defined(Z_CHECK_HAS_THREAD_INFO) && defined(Z_CHECK_FREESTANDING)
+    #error "Z_CHECK_HAS_THREAD_INFO asks the kernel who a thread is; freestanding Z_CHECK can't"
+#endif
+#if defined(Z_CHECK_FILE_WRITEBACK) && defined(Z_CHECK_FILE_DIRECT)
+    #error "Z_CHECK_FILE_WRITEBACK is for files written through the page cache; direct ones skip it"
+#endif
+
 #ifndef Z_CHECK_STATIC_CONFIG
+    #if defined(Z_CHECK_FREESTANDING)
+        #error "Freestanding Z_CHECK requires static configuration"
+    #endif
+
     /* Dynamically configured */
     static char m_moduleName[Z_CHECK_MODULE_NAME_MAX_LEN] = {0}; /* Flawfinder: ignore */
         /* Warning: Statically-sized array
            "Ignore" justification: we only write to it once using strncpy(sizeof(m_moduleName) -1)),
            which writes a limited number of bits excluding the NULL terminator. */
     static ZLogFn_t m_ZLogFunc = NULL;
-    static ZLogLevel_t m_logLevel;
+    LEVEL_STORAGE ZLogLevel_t m_logLevel;
     static ZLogLevel_t m_logLevelOrig;
 #else
     /* Statically configured */
     #if !defined(Z_CHECK_MODULE_NAME) || !defined(Z_CHECK_LOG_FUNC) || !defined(Z_CHECK_INIT_LOG_LEVEL)
         #error "Must fully define Z_CHECK static configuration."
     #endif
-    #if defined(Z_CHECK_HAS_SYSLOG)
-        #error "Syslog version of Z_CHECK requires dynamic configuration"
+
+    #if defined(Z_CHECK_FREESTANDING) && !defined(WRITE_SINK)
+        #error "Freestanding Z_CHECK can only log to Z_WRITE or Z_CAPTURE"
+    #endif
+    #if defined(Z_CHECK_FREESTANDING) && !defined(COMPACT_FORMATTER)
+        #error "Freestanding Z_CHECK has no vsnprintf(); use Z_FMT_COMPACT"
+    #endif
+    #if defined(Z_CHECK_FREESTANDING) && defined(Z_CHECK_HAS_ARENA)
+        #error "Arenas need pthreads, which freestanding Z_CHECK does not assume"
     #endif
 
     static const char * const m_moduleName = Z_CHECK_MODULE_NAME;
 
-    #if Z_CHECK_LOG_FUNC == Z_STDOUT
-        static const ZLogFn_t m_ZLogFunc = ZLog_StdOut;
-    #elif Z_CHECK_LOG_FUNC == Z_STDERR
-        static const ZLogFn_t m_ZLogFunc = ZLog_StdErr;
-    #else
-        #error "invalid Z_CHECK_LOG_FUNC"
-    #endif
-
     Z_CT_ASSERT_DECL(Z_CHECK_INIT_LOG_LEVEL <= MAX_LEGAL_LEVEL);
-    static ZLogLevel_t m_logLevel = Z_CHECK_INIT_LOG_LEVEL;
+    LEVEL_STORAGE ZLogLevel_t m_logLevel = Z_CHECK_INIT_LOG_LEVEL;
     static const ZLogLevel_t m_logLevelOrig = Z_CHECK_INIT_LOG_LEVEL;
+
+    #ifdef SYSLOG_SINK
+    static int m_syslogOpened = 0;  /* openlog() happens on the first record */
+    #endif
+#endif
+
+#ifdef FILE_SINK
+    /* Opened by ZLog_Open() in dynamic config, on the first record in static config. Falls back
+     * to stderr if the file cannot be opened. */
+    static FILE *m_logFile = NULL;
+#endif
+
+#ifdef CAPTURE_SINK
+    #if Z_CHECK_CAPTURE_SIZE > 0
+    /* Lines claim their space with a compare-and-swap on the length, then copy in; the extra
+     * byte holds the NUL that ZLog_CaptureGet() adds. */
+    static char m_capture[Z_CHECK_CAPTURE_SIZE + 1]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_CaptureWrite() only copies into space it has claimed. */
+    static size_t m_captureLen = 0;
+    #endif
+    static unsigned long m_captureLines = 0;
+    static unsigned long m_captureBytes = 0;
+    static unsigned long m_captureDropped = 0;
+#endif
+
+/* Indexed by errno; duplicates of other names on this system (EWOULDBLOCK) are left out */
+static const char * const m_errnoNames[] = {
+    [E2BIG] = "E2BIG", [EACCES] = "EACCES", [EADDRINUSE] = "EADDRINUSE",
+    [EADDRNOTAVAIL] = "EADDRNOTAVAIL", [EAFNOSUPPORT] = "EAFNOSUPPORT", [EAGAIN] = "EAGAIN",
+    [EALREADY] = "EALREADY", [EBADF] = "EBADF", [EBADMSG] = "EBADMSG", [EBUSY] = "EBUSY",
+    [ECANCELED] = "ECANCELED", [ECHILD] = "ECHILD", [ECONNABORTED] = "ECONNABORTED",
+    [ECONNREFUSED] = "ECONNREFUSED", [ECONNRESET] = "ECONNRESET", [EDEADLK] = "EDEADLK",
+    [EDESTADDRREQ] = "EDESTADDRREQ", [EDOM] = "EDOM", [EDQUOT] = "EDQUOT", [EEXIST] = "EEXIST",
+    [EFAULT] = "EFAULT", [EFBIG] = "EFBIG", [EHOSTUNREACH] = "EHOSTUNREACH", [EIDRM] = "EIDRM",
+    [EILSEQ] = "EILSEQ", [EINPROGRESS] = "EINPROGRESS", [EINTR] = "EINTR", [EINVAL] = "EINVAL",
+    [EIO] = "EIO", [EISCONN] = "EISCONN", [EISDIR] = "EISDIR", [ELOOP] = "ELOOP",
+    [EMFILE] = "EMFILE", [EMLINK] = "EMLINK", [EMSGSIZE] = "EMSGSIZE",
+    [EMULTIHOP] = "EMULTIHOP", [ENAMETOOLONG] = "ENAMETOOLONG", [ENETDOWN] = "ENETDOWN",
+    [ENETRESET] = "ENETRESET", [ENETUNREACH] = "ENETUNREACH", [ENFILE] = "ENFILE",
+    [ENOBUFS] = "ENOBUFS", [ENODEV] = "ENODEV", [ENOENT] = "ENOENT", [ENOEXEC] = "ENOEXEC",
+    [ENOLCK] = "ENOLCK", [ENOLINK] = "ENOLINK", [ENOMEM] = "ENOMEM", [ENOMSG] = "ENOMSG",
+    [ENOPROTOOPT] = "ENOPROTOOPT", [ENOSPC] = "ENOSPC", [ENOSYS] = "ENOSYS",
+    [ENOTCONN] = "ENOTCONN", [ENOTDIR] = "ENOTDIR", [ENOTEMPTY] = "ENOTEMPTY",
+    [ENOTRECOVERABLE] = "ENOTRECOVERABLE", [ENOTSOCK] = "ENOTSOCK", [ENOTSUP] = "ENOTSUP",
+    [ENOTTY] = "ENOTTY", [ENXIO] = "ENXIO", [EOVERFLOW] = "EOVERFLOW",
+    [EOWNERDEAD] = "EOWNERDEAD", [EPERM] = "EPERM", [EPIPE] = "EPIPE", [EPROTO] = "EPROTO",
+    [EPROTONOSUPPORT] = "EPROTONOSUPPORT", [EPROTOTYPE] = "EPROTOTYPE", [ERANGE] = "ERANGE",
+    [EROFS] = "EROFS", [ESPIPE] = "ESPIPE", [ESRCH] = "ESRCH", [ESTALE] = "ESTALE",
+    [ETIMEDOUT] = "ETIMEDOUT", [ETXTBSY] = "ETXTBSY", [EXDEV] = "EXDEV",
+#if EOPNOTSUPP != ENOTSUP
+    [EOPNOTSUPP] = "EOPNOTSUPP",
+#endif
+};
+
+#ifdef EMIT_STATIC_BUFFER
+    /* Formatting buffer that would otherwise sit in ZLog()'s frame. The busy flag catches a
+     * signal handler logging while its thread is mid-record. */
+    static THREAD_LOCAL char m_message[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_Emit() never writes more than MESSAGE_MAX_LEN bytes. */
+    static THREAD_LOCAL bool m_messageBusy = false;
+    /* ZLog_Errno() and ZLog_Check() build their message here before handing it to ZLog_Msg() */
+    static THREAD_LOCAL char m_notedMessage[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_NoteFormat() never writes more than MESSAGE_MAX_LEN
+           bytes. */
+    static THREAD_LOCAL bool m_notedBusy = false;
+    #ifdef Z_CHECK_LOGB_IDS
+    static THREAD_LOCAL unsigned char m_frame[FRAME_MAX];
+    #endif
+#endif
+
+#ifdef Z_CHECK_LOGB_IDS
+    /* From the linker: the start of the site table (weak, as there is no section without sites)
+     * and this module's own ELF header, through which its build-ID is found */
+    extern const ZLogSite_t __start_z_check_sites[] __attribute__((weak));
+    extern const ELF_EHDR __ehdr_start __attribute__((weak, visibility("hidden")));
+    static bool m_frameHeaderSent = false;
+#endif
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    static THREAD_LOCAL ZLogThread_t m_threadInfo;  /* loaded on the thread's first record */
+    #if defined(Z_CHECK_HAS_ASYNC) || defined(Z_CHECK_HAS_SHARED_RING)
+    /* the thread of the record being written, set around the sink as m_sinkStamp is, or as the
+     * shared ring drains */
+    static THREAD_LOCAL const ZLogThread_t *m_sinkThread = NULL;
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_TRACE
+    #ifndef Z_CHECK_HAS_THREAD_INFO
+    static THREAD_LOCAL uint32_t m_thread = 0;     /* this thread's number, 0 until it writes */
+    static uint32_t m_threadCount = 0;
+    #endif
+    #ifdef Z_CHECK_HAS_ASYNC
+    /* the stamp of the record being written, set around the sink by whoever drains the queue */
+    static THREAD_LOCAL const ZLogStamp_t *m_sinkStamp = NULL;
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_ARENA
+    /* Static so that steady-state logging never calls malloc() and memory is bounded by the
+     * configuration. Untouched arenas, and storage not yet carved, stay in zero pages. */
+    static ZLogArena_t m_arenas[Z_CHECK_ARENA_MAX_THREADS];
+    static const unsigned m_arenaClassBlocks[ARENA_CLASSES] = {
+        Z_CHECK_ARENA_BLOCKS_256,
+        Z_CHECK_ARENA_BLOCKS_1K,
+        Z_CHECK_ARENA_BLOCKS_4K,
+    };
+    static unsigned long m_arenaNoArena = 0;
+    /* Arenas given back by exited threads, as a stack: a generation count in the high half
+     * (against ABA) and the index + 1 of the top in the low half, 0 when empty */
+    static uint64_t m_arenaFree = 0;
+    static unsigned m_arenaUntouched = 0;       /* m_arenas[] from here on were never owned */
+    static unsigned long m_arenaCarved = 0;     /* bytes, over all arenas */
+    static unsigned long m_arenaOverBudget = 0;
+    static pthread_once_t m_arenaKeyOnce = PTHREAD_ONCE_INIT;
+    static pthread_key_t m_arenaKey;
+    static THREAD_LOCAL ZLogArena_t *m_threadArena = NULL;
+#endif
+
+#ifdef Z_CHECK_HAS_CALLSITES
+    /* Sites push themselves here the first time they run, so the registry costs nothing at
+     * startup. It never shrinks: sites are static. */
+    static ZLogCallsite_t *m_callsites = NULL;
+    static ZLogCallsiteRule_t m_callsiteRules[Z_CHECK_CALLSITE_RULES];
+    static unsigned m_callsiteRuleCount = 0;    /* slots claimed; may run past the array */
+#endif
+
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+    /* ZLog_StatusDomainAdd() pushes domains here; like m_callsites, it never shrinks */
+    static ZLogStatusDomain_t *m_statusDomains = NULL;
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+    /* Z_TIME_SCOPE() sites, pushed the first time they end, as for m_callsites */
+    static ZLogTimeSite_t *m_timeSites = NULL;
+#endif
+
+#ifdef Z_CHECK_HAS_ASYNC
+    /* Intrusive multi-producer, single-consumer queue: producers swap themselves in at the tail
+     * and then link the previous tail to them; only the writer moves the head. The stub keeps
+     * the queue non-empty so neither end is ever NULL. */
+    static ZLogRecord_t m_queueStub;
+    static ZLogRecord_t *m_queueHead = &m_queueStub;    /* writer only */
+    static ZLogRecord_t *m_queueTail = &m_queueStub;
+
+    static pthread_t m_writer;
+    static pthread_mutex_t m_writerLock = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_cond_t m_writerWake = PTHREAD_COND_INITIALIZER;     /* records queued */
+    static pthread_cond_t m_writerDone = PTHREAD_COND_INITIALIZER;     /* records written */
+    static int m_writerRunning = 0;
+    static int m_writerSleeping = 0;
+    static int m_flushWaiting = 0;
+    static bool m_writerStop = false;       /* under m_writerLock */
+    #ifdef Z_CHECK_STATIC_CONFIG
+    static pthread_once_t m_writerOnce = PTHREAD_ONCE_INIT;
+    #endif
+
+    static unsigned long m_asyncQueued = 0;
+    static unsigned long m_asyncWritten = 0;    /* written by the writer only */
+    static unsigned long m_asyncDropped = 0;    /* arena full even after draining */
+#endif
+
+#ifdef FORK_HANDLERS
+    static pthread_once_t m_forkOnce = PTHREAD_ONCE_INIT;   /* a child inherits the handlers */
 #endif
 
 
@@ -127,13 +922,20 @@ void ZLog_Open(const ZLogType_t logType, const ZLogLevel_t logLevel, const char
                 m_ZLogFunc = ZLog_StdOut;
                 break;
 
-#ifdef Z_CHECK_HAS_SYSLOG
+#ifdef SYSLOG_SINK
             case Z_SYSLOG:
                 openlog(m_moduleName, LOG_CONS, LOG_LOCAL0);
                 m_ZLogFunc = ZLog_Syslog;
                 break;
 #endif
 
+            case Z_FILE:
+                if (NULL == m_logFile) {
+                    m_logFile = ZLog_FileOpen(Z_CHECK_LOG_FILE_PATH);
+                }
+                m_ZLogFunc = ZLog_File;
+                break;
+
             default:
                 /* don't have Z_LOG setup yet to use */
                 fprintf(stderr, "Warning: Unknown log type (%d); falling back to stderr\n",
@@ -141,21 +943,54 @@ void ZLog_Open(const ZLogType_t logType, const ZLogLevel_t logLevel, const char
                 m_ZLogFunc = ZLog_StdErr;
                 break;
         }
+#ifdef Z_CHECK_HAS_ASYNC
+        ZLog_AsyncStart();
+#endif
+    }
+}
+
+void ZLog_OpenFile(const char * const path, const ZLogLevel_t logLevel,
+                   const char * const moduleName) {
+    if ((NULL == m_ZLogFunc) && (NULL == m_logFile)) {
+        m_logFile = ZLog_FileOpen(path);
     }
+    ZLog_Open(Z_FILE, logLevel, moduleName);
 }
 
 void ZLog_Close(void) {
-#ifdef Z_CHECK_HAS_SYSLOG
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncStop();
+#endif
+#ifdef SYSLOG_SINK
     if (ZLog_Syslog == m_ZLogFunc) {
         closelog();
     }
 #endif
+    if ((NULL != m_logFile) && (stderr != m_logFile)) {
+        (void)fclose(m_logFile);
+    }
+    m_logFile = NULL;
+#ifdef FILE_WRITEBACK
+    ZLog_FileWritebackReset();
+#endif
 
     m_ZLogFunc = NULL;
     memset(m_moduleName, 0, sizeof(m_moduleName));
 }
 #endif /* Z_CHECK_STATIC_CONFIG */
 
+void ZLog_Flush(void) {
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncDrain();
+#endif
+#ifdef Z_CHECK_HAS_SHARED_RING
+    ZLog_RingFlush();
+#endif
+#ifndef Z_CHECK_FREESTANDING
+    ZLog_SinkFlush();
+#endif
+}
+
 void ZLog_LevelSet(const ZLogLevel_t logLevel) {
     m_logLevel = logLevel;
 }
@@ -164,67 +999,481 @@ void ZLog_LevelReset(void) {
     m_logLevel = m_logLevelOrig;
 }
 
-void ZLog(const ZLogLevel_t level, const char * const file, const int line, const char * const func,
-          const char * const format, ...) {
-#ifndef Z_CHECK_STATIC_CONFIG
-    if (NULL == m_ZLogFunc) {
-        fprintf(stderr, "Error: May not use ZLog() before calling ZLog_Open()\n");
+#ifdef Z_CHECK_HAS_ARENA
+void ZLog_ArenaStatsGet(ZLogArenaStats_t * const stats) {
+    unsigned i;
+    unsigned c;
+
+    memset(stats, 0, sizeof(*stats));
+    for (i = 0; i < Z_CHECK_ARENA_MAX_THREADS; i++) {
+        ZLogArena_t * const arena = &m_arenas[i];
+        if (__atomic_load_n(&arena->owned, __ATOMIC_RELAXED)) {
+            stats->arenasInUse++;
+        }
+        for (c = 0; c < ARENA_CLASSES; c++) {
+            const unsigned long allocs = ZLog_StatRead(&arena->allocs[c]);
+            const unsigned long remote = ZLog_StatRead(&arena->remoteFrees[c]);
+            const unsigned long frees = ZLog_StatRead(&arena->frees[c]) + remote;
+            const unsigned long highWater = ZLog_StatRead(&arena->highWater[c]);
+
+            stats->allocs[c] += allocs;
+            stats->frees[c] += frees;
+            stats->remoteFrees[c] += remote;
+            stats->inUse[c] += (allocs > frees) ? (allocs - frees) : 0;
+            if (highWater > stats->highWater[c]) {
+                stats->highWater[c] = highWater;
+            }
+        }
+        stats->failures += ZLog_StatRead(&arena->failures);
     }
-    else
-#endif
+    stats->arenasTouched = __atomic_load_n(&m_arenaUntouched, __ATOMIC_RELAXED);
+    stats->bytesCarved = ZLog_StatRead(&m_arenaCarved);
+    stats->overBudget = ZLog_StatRead(&m_arenaOverBudget);
+    stats->noArena = ZLog_StatRead(&m_arenaNoArena);
+}
+#endif /* Z_CHECK_HAS_ARENA */
 
-    if (ZLog_LevelPasses(level)) {
-        int rc;
-        va_list args;
-        char message[MESSAGE_MAX_LEN] = {0}; /* Flawfinder: ignore */
-            /* Warning: Statically-sized array
-               "Ignore" justification: we only write to it once using vsnprintf(), which writes a
-               limited number of bits including the NULL terminator. */
+#ifdef Z_CHECK_HAS_ASYNC
+void ZLog_AsyncStatsGet(ZLogAsyncStats_t * const stats) {
+    stats->queued = ZLog_StatRead(&m_asyncQueued);
+    stats->written = ZLog_StatRead(&m_asyncWritten);
+    stats->dropped = ZLog_StatRead(&m_asyncDropped);
+}
+#endif /* Z_CHECK_HAS_ASYNC */
 
-        va_start(args, format);
-        rc = vsnprintf(message, MESSAGE_MAX_LEN - 1, format, args); /* Flawfinder: ignore */
-            /* Warning: use of "vsnprintf" and a user provided format
-               "Ignore" justification: leaving the message format to the caller is a required
-               feature. The code calling this is considered trusted. However, it is up to the
-               calling code to make sure the user cannot influence the format-string itself. */
-        va_end(args);
+#ifdef CAPTURE_SINK
+const char * ZLog_CaptureGet(size_t * const len) {
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncDrain();
+#endif
+#if Z_CHECK_CAPTURE_SIZE > 0
+    {
+        const size_t captured = __atomic_load_n(&m_captureLen, __ATOMIC_ACQUIRE);
 
-        if (0 > rc) {
-            m_ZLogFunc(level, file, line, func, "[z_check: failed to format message!]");
-        }
-        else {
-            m_ZLogFunc(level, file, line, func, message);
+        m_capture[captured] = '\0';
+        if (NULL != len) {
+            *len = captured;
         }
+        return m_capture;
+    }
+#else
+    if (NULL != len) {
+        *len = 0;
     }
+    return "";
+#endif
 }
 
+void ZLog_CaptureClear(void) {
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncDrain();
+#endif
+#if Z_CHECK_CAPTURE_SIZE > 0
+    __atomic_store_n(&m_captureLen, 0, __ATOMIC_RELEASE);
+#endif
+}
 
-/******************************************************************************
- *                                                         Internal functions */
-#ifndef Z_CHECK_STATIC_CONFIG
-static void ZLog_ModuleNameInit(const char * const moduleName) {
-    const char * const moduleNameToUse = (NULL != moduleName) ? moduleName : DEFAULT_MODULE_NAME;
-    (void)strlcpy(m_moduleName, moduleNameToUse, sizeof(m_moduleName));
+void ZLog_CaptureStatsGet(ZLogCaptureStats_t * const stats) {
+    stats->lines = __atomic_load_n(&m_captureLines, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&m_captureBytes, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&m_captureDropped, __ATOMIC_RELAXED);
 }
+#endif /* CAPTURE_SINK */
 
-static ZLogLevel_t ZLog_LevelSanitize(const ZLogLevel_t logLevel) {
-    ZLogLevel_t sanitizedLevel = logLevel;
-    if (!ZLog_LevelIsLegal(logLevel)) {
-        /* don't have Z_LOG setup yet to use */
-        fprintf(stderr, "Warning: Invalid log level (%u); falling back to MAX_LEGAL_LEVEL (%u)\n",
-                (unsigned)logLevel, MAX_LEGAL_LEVEL);
-        sanitizedLevel = MAX_LEGAL_LEVEL;
+#ifdef Z_CHECK_HAS_THREAD_INFO
+void ZLog_ThreadNameSet(const char * const name) {
+#ifdef __linux__
+    if (NULL != name) {
+        (void)prctl(PR_SET_NAME, name);
     }
-    return sanitizedLevel;
+#endif
+    ZLog_ThreadLoad(name);
 }
+#endif /* Z_CHECK_HAS_THREAD_INFO */
 
-static inline bool ZLog_LevelIsLegal(const ZLogLevel_t level) {
-    return (MAX_LEGAL_LEVEL >= (unsigned)level);
-}
-#endif /* Z_CHECK_STATIC_CONFIG */
+#ifdef Z_CHECK_HAS_CALLSITES
+size_t ZLog_CallsiteSet(const char * const file, const int line, const int enabled) {
+    const unsigned slot = __atomic_fetch_add(&m_callsiteRuleCount, 1, __ATOMIC_SEQ_CST);
+    ZLogCallsite_t *site;
+    size_t matched = 0;
 
-static inline bool ZLog_LevelPasses(const ZLogLevel_t level) {
-    return ((unsigned)level <= (unsigned)m_logLevel);
+    if (slot < Z_CHECK_CALLSITE_RULES) {
+        m_callsiteRules[slot].file = file;
+        m_callsiteRules[slot].line = line;
+        m_callsiteRules[slot].enabled = (0 != enabled);
+        __atomic_store_n(&m_callsiteRules[slot].ready, 1, __ATOMIC_SEQ_CST);
+    }
+    /* a site pushed after this load finds the rule itself, as it was published first */
+    for (site = __atomic_load_n(&m_callsites, __ATOMIC_SEQ_CST); NULL != site; site = site->next) {
+        if (ZLog_CallsiteMatches(site, file, line)) {
+            __atomic_store_n(&site->enabled, (0 != enabled), __ATOMIC_RELAXED);
+            matched++;
+        }
+    }
+    return matched;
+}
+
+void ZLog_CallsiteForEach(const ZLogCallsiteFn_t fn, void * const context) {
+    const ZLogCallsite_t *site;
+
+    for (site = __atomic_load_n(&m_callsites, __ATOMIC_ACQUIRE); NULL != site; site = site->next) {
+        fn(site, context);
+    }
+}
+
+void ZLog_CallsiteRegister(ZLogCallsite_t * const site) {
+    int state = 0;
+
+    /* a thread losing the race logs through the site unregistered; the winner links it */
+    if (__atomic_compare_exchange_n(&site->state, &state, 1, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        ZLogCallsite_t *head = __atomic_load_n(&m_callsites, __ATOMIC_RELAXED);
+        unsigned count;
+        unsigned i;
+
+        do {
+            site->next = head;
+        } while (!__atomic_compare_exchange_n(&m_callsites, &head, site, true, __ATOMIC_SEQ_CST,
+                                              __ATOMIC_RELAXED));
+
+        /* rules published before the push; ZLog_CallsiteSet() applies later ones itself */
+        count = __atomic_load_n(&m_callsiteRuleCount, __ATOMIC_SEQ_CST);
+        for (i = 0; (i < count) && (i < Z_CHECK_CALLSITE_RULES); i++) {
+            const ZLogCallsiteRule_t * const rule = &m_callsiteRules[i];
+
+            if (__atomic_load_n(&rule->ready, __ATOMIC_SEQ_CST) &&
+                ZLog_CallsiteMatches(site, rule->file, rule->line)) {
+                __atomic_store_n(&site->enabled, rule->enabled, __ATOMIC_RELAXED);
+            }
+        }
+        __atomic_store_n(&site->state, 2, __ATOMIC_RELEASE);
+    }
+}
+#endif /* Z_CHECK_HAS_CALLSITES */
+
+#ifdef Z_CHECK_HAS_LOG_COST
+void ZLog_CostReport(const unsigned top) {
+    const ZLogCallsite_t *site = NULL;
+    unsigned rank;
+
+    for (rank = 1; (rank <= top) && (NULL != (site = ZLog_CostNext(site))); rank++) {
+        const ZLogCost_t * const cost = site->cost;
+        const unsigned long calls = __atomic_load_n(&cost->calls, __ATOMIC_RELAXED);
+        const unsigned long long cycles = __atomic_load_n(&cost->cycles, __ATOMIC_RELAXED);
+
+        ZLog(Z_NOTICE, ZLog_BaseName(site->file), site->line, site->func,
+             "cost #%u: %lu calls, %llu cycles, mean %llu, p50 %llu, p99 %llu, max %llu",
+             rank, calls, cycles, cycles / calls, ZLog_CostPercentile(cost, calls, 50),
+             ZLog_CostPercentile(cost, calls, 99),
+             __atomic_load_n(&cost->maxCycles, __ATOMIC_RELAXED));
+    }
+}
+
+void ZLog_CostAdd(ZLogCallsite_t * const site, const unsigned long long cycles) {
+    ZLogCost_t * const cost = site->cost;
+    unsigned long long max = __atomic_load_n(&cost->maxCycles, __ATOMIC_RELAXED);
+
+    (void)__atomic_fetch_add(&cost->calls, 1, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&cost->cycles, cycles, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&cost->buckets[ZLog_CostBucket(cycles)], 1, __ATOMIC_RELAXED);
+    while ((cycles > max) && !__atomic_compare_exchange_n(&cost->maxCycles, &max, cycles, true,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+#endif /* Z_CHECK_HAS_LOG_COST */
+
+#if defined(Z_CHECK_HAS_TIMING) || defined(Z_CHECK_HAS_TRACE) || defined(NET_SINK) || \
+    defined(Z_CHECK_HAS_SHARED_RING) || defined(DIRECT_SINK) || defined(FILE_WRITEBACK)
+unsigned long long ZLog_TimeNow(void) {
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((unsigned long long)now.tv_sec * 1000000000ull) + (unsigned long long)now.tv_nsec;
+}
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+void ZLog_TimeForEach(const ZLogTimeSiteFn_t fn, void * const context) {
+    const ZLogTimeSite_t *site;
+
+    for (site = __atomic_load_n(&m_timeSites, __ATOMIC_ACQUIRE); NULL != site; site = site->next) {
+        fn(site, context);
+    }
+}
+
+void ZLog_TimeScopeEnd(ZLogTimeScope_t * const scope) {
+    ZLogTimeSite_t * const site = scope->site;
+    const unsigned long us = (unsigned long)((ZLog_TimeNow() - scope->startNs) / 1000u);
+    unsigned long max = __atomic_load_n(&site->maxUs, __ATOMIC_RELAXED);
+
+    if (2 != __atomic_load_n(&site->state, __ATOMIC_ACQUIRE)) {
+        ZLog_TimeRegister(site);
+    }
+    (void)__atomic_fetch_add(&site->runs, 1, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&site->buckets[ZLog_TimeBucket(us)], 1, __ATOMIC_RELAXED);
+    while ((us > max) && !__atomic_compare_exchange_n(&site->maxUs, &max, us, true,
+                                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    if (us > scope->thresholdUs) {
+        (void)__atomic_fetch_add(&site->slowRuns, 1, __ATOMIC_RELAXED);
+#ifdef Z_CHECK_HAS_CALLSITES
+        if (!ZLog_CallsiteEnabled(&site->callsite)) {
+            return;
+        }
+#endif
+        ZLog(scope->level, ZLog_BaseName(site->file), site->line, site->func,
+             "%s took %lu us (threshold %lu us)", site->name, us, scope->thresholdUs);
+    }
+}
+#endif /* Z_CHECK_HAS_TIMING */
+
+void ZLog(const ZLogLevel_t level, const char * const file, const int line, const char * const func,
+          const char * const format, ...) {
+    va_list args;
+
+#ifndef Z_CHECK_STATIC_CONFIG
+    if (NULL == m_ZLogFunc) {
+        fprintf(stderr, "Error: May not use ZLog() before calling ZLog_Open()\n");
+    }
+    else
+#endif
+
+    if (ZLog_LevelPasses(level)) {
+        va_start(args, format);
+#if defined(Z_CHECK_HAS_ASYNC)
+        ZLog_EmitAsync(level, file, line, func, format, args);
+#elif defined(EMIT_STATIC_BUFFER)
+        if (!m_messageBusy) {
+            m_messageBusy = true;
+            ZLog_Emit(m_message, level, file, line, func, format, args);
+            m_messageBusy = false;
+        }
+        else {
+            /* a signal handler interrupted this thread mid-record; leave its buffer alone */
+            ZLog_EmitRaw(level, file, line, func, format);
+        }
+#else
+        ZLog_EmitOnStack(level, file, line, func, format, args);
+#endif
+        va_end(args);
+    }
+}
+
+void ZLog_Msg(const ZLogLevel_t level, const char * const file, const int line,
+              const char * const func, const char * const message) {
+#ifndef Z_CHECK_STATIC_CONFIG
+    if (NULL == m_ZLogFunc) {
+        fprintf(stderr, "Error: May not use ZLog() before calling ZLog_Open()\n");
+    }
+    else
+#endif
+
+    if (ZLog_LevelPasses(level)) {
+#if defined(Z_CHECK_HAS_ASYNC)
+        ZLog_EnqueueMsg(level, file, line, func, message);
+#elif defined(WRITE_SINK) && defined(EMIT_STATIC_BUFFER)
+        /* build the line in the per-thread buffer rather than in ZLog_Write()'s frame */
+        ZLog(level, file, line, func, "%s", message);
+#else
+        ZLOG_SINK(level, file, line, func, message);
+#endif
+    }
+}
+
+void ZLog_Errno(const ZLogLevel_t level, const char * const file, const int line,
+                const char * const func, const int errnum, const char * const format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    ZLog_Noted(level, file, line, func, errnum, NULL, format, args);
+    va_end(args);
+    errno = errnum;
+}
+
+const char * ZLog_ErrnoName(const int errnum) {
+    const size_t count = sizeof(m_errnoNames) / sizeof(m_errnoNames[0]);
+
+    return ((0 <= errnum) && ((size_t)errnum < count)) ? m_errnoNames[errnum] : NULL;
+}
+
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+void ZLog_Check(const ZLogLevel_t level, const char * const file, const int line,
+                const char * const func, const long status, const int errnum,
+                const char * const format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    ZLog_Noted(level, file, line, func, errnum, &status, format, args);
+    va_end(args);
+    if (0 <= errnum) {
+        errno = errnum;
+    }
+}
+
+void ZLog_StatusDomainAdd(ZLogStatusDomain_t * const domain) {
+    int added = 0;
+
+    if (__atomic_compare_exchange_n(&domain->added, &added, 1, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        ZLogStatusDomain_t *head = __atomic_load_n(&m_statusDomains, __ATOMIC_RELAXED);
+
+        do {
+            domain->next = head;
+        } while (!__atomic_compare_exchange_n(&m_statusDomains, &head, domain, true,
+                                              __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+}
+
+const char * ZLog_StatusName(const long status) {
+    const ZLogStatusDomain_t *domain;
+
+    for (domain = __atomic_load_n(&m_statusDomains, __ATOMIC_ACQUIRE); NULL != domain;
+         domain = domain->next) {
+        /* unsigned, so codes below first wrap past count */
+        const unsigned long index = (unsigned long)status - (unsigned long)domain->first;
+
+        if ((index < domain->count) && (NULL != domain->names[index])) {
+            return domain->names[index];
+        }
+    }
+    return NULL;
+}
+#endif /* Z_CHECK_HAS_STATUS_NAMES */
+
+#ifdef Z_CHECK_HAS_LOGB
+void ZLog_Binary(const ZLogLevel_t level, const char * const file, const int line,
+                 const char * const func, const char * const format, const void * const args,
+                 const size_t len) {
+#ifndef Z_CHECK_STATIC_CONFIG
+    if (NULL == m_ZLogFunc) {
+        fprintf(stderr, "Error: May not use ZLog() before calling ZLog_Open()\n");
+    }
+    else
+#endif
+
+    if (ZLog_LevelPasses(level)) {
+#if defined(Z_CHECK_HAS_ASYNC)
+        ZLogRecord_t * const record = ZLog_RecordArgs(args, len);
+
+        if (NULL != record) {
+            record->format = format;
+            ZLog_Enqueue(record, level, file, line, func);
+        }
+#elif defined(EMIT_STATIC_BUFFER)
+        if (!m_messageBusy) {
+            m_messageBusy = true;
+            ZLog_EmitBinary(m_message, level, file, line, func, format, args, len);
+            m_messageBusy = false;
+        }
+        else {
+            ZLog_EmitRaw(level, file, line, func, format);
+        }
+#else
+        char message[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: ZLog_EmitBinary() never writes more than MESSAGE_MAX_LEN
+               bytes. */
+        ZLog_EmitBinary(message, level, file, line, func, format, args, len);
+#endif
+    }
+}
+
+size_t ZLog_BinaryFormat(char * const buf, const size_t size, const char * const format,
+                         const void * const args, const size_t len) {
+    char empty[1]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: only ever holds the terminator. */
+    ZLogOut_t out = { buf, size, 0 };
+
+    if (0 == size) {
+        /* still measure */
+        out.buf = empty;
+        out.size = sizeof(empty);
+    }
+    ZLog_OutBinary(&out, format, args, len);
+    return out.len;
+}
+#endif /* Z_CHECK_HAS_LOGB */
+
+#ifdef Z_CHECK_LOGB_IDS
+void ZLog_BinarySite(const ZLogLevel_t level, const ZLogSite_t * const site,
+                     const void * const args, const size_t len) {
+    if (ZLog_LevelPasses(level)) {
+#if defined(Z_CHECK_HAS_ASYNC)
+        ZLogRecord_t * const record = ZLog_RecordArgs(args, len);
+
+        if (NULL != record) {
+            record->format = site->format;
+            record->site = site;
+            ZLog_Enqueue(record, level, site->file, site->line, site->func);
+        }
+#elif defined(EMIT_STATIC_BUFFER)
+        if (!m_messageBusy) {
+            m_messageBusy = true;
+            ZLog_WriteFrame(m_frame, level, site, args, len);
+            m_messageBusy = false;
+        }
+        else {
+            ZLog_EmitRaw(level, site->file, site->line, site->func, site->format);
+        }
+#else
+        unsigned char frame[FRAME_MAX];
+
+        ZLog_WriteFrame(frame, level, site, args, len);
+#endif
+    }
+}
+#endif /* Z_CHECK_LOGB_IDS */
+
+#ifdef Z_CHECK_HAS_TRACE
+void ZLog_TraceSpan(const char kind, const ZLogSite_t * const site) {
+#if defined(Z_CHECK_HAS_ASYNC)
+    /* through the queue like any record, so spans and logs stay in order */
+    size_t capacity = 0;
+    ZLogRecord_t * const record = ZLog_RecordAlloc(&capacity);
+
+    if (NULL == record) {
+        (void)__atomic_fetch_add(&m_asyncDropped, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        record->site = site;
+        record->span = kind;
+        ZLog_Enqueue(record, Z_DEBUG, site->file, site->line, site->func);
+    }
+#else
+    ZLog_WriteSpan(kind, site);
+#endif
+}
+#endif /* Z_CHECK_HAS_TRACE */
+
+
+/******************************************************************************
+ *                                                         Internal functions */
+#ifndef Z_CHECK_STATIC_CONFIG
+static void ZLog_ModuleNameInit(const char * const moduleName) {
+    const char * const moduleNameToUse = (NULL != moduleName) ? moduleName : DEFAULT_MODULE_NAME;
+    (void)strlcpy(m_moduleName, moduleNameToUse, sizeof(m_moduleName));
+}
+
+static ZLogLevel_t ZLog_LevelSanitize(const ZLogLevel_t logLevel) {
+    ZLogLevel_t sanitizedLevel = logLevel;
+    if (!ZLog_LevelIsLegal(logLevel)) {
+        /* don't have Z_LOG setup yet to use */
+        fprintf(stderr, "Warning: Invalid log level (%u); falling back to MAX_LEGAL_LEVEL (%u)\n",
+                (unsigned)logLevel, MAX_LEGAL_LEVEL);
+        sanitizedLevel = MAX_LEGAL_LEVEL;
+    }
+    return sanitizedLevel;
+}
+
+static inline bool ZLog_LevelIsLegal(const ZLogLevel_t level) {
+    return (MAX_LEGAL_LEVEL >= (unsigned)level);
+}
+#endif /* Z_CHECK_STATIC_CONFIG */
+
+static inline bool ZLog_LevelPasses(const ZLogLevel_t level) {
+    return ((unsigned)level <= (unsigned)m_logLevel);
 }
 
 static inline const char * ZLog_LevelStr(const ZLogLevel_t level) {
@@ -232,44 +1481,3936 @@ static inline const char * ZLog_LevelStr(const ZLogLevel_t level) {
      *  (1): levels > m_logLevel are thrown out in ZLog_LevelPasses()
      *  (2): m_logLevels > MAX_LEVEL_INDEX are thrown out in Z_CT_ASSERTs in static config and
      *          with input sanitization in dynamic config. */
-    const char * const levelStrs[] = {
-        "EMERGENCY",
-        "ALERT",
-        "CRITICAL",
-        "ERROR",
-        "WARNING",
-        "NOTICE",
-        "INFO",
-        "DEBUG",
-    };
+    const char * const levelStrs[] = { Z_CHECK_LEVEL_NAMES };
     return levelStrs[(int)level];
 }
 
-static inline void ZLog_StdFile(FILE *outfile, const ZLogLevel_t level, const char * const file,
-                                const int line, const char * const func, const char * const message) {
-    fprintf(outfile, "%s: [%s] %s:%d:%s: %s\n",
-            m_moduleName, ZLog_LevelStr(level), file, line, func, message);
+/* A message with notes after it, built apart and written as a preformatted message */
+static void ZLog_Noted(const ZLogLevel_t level, const char * const file, const int line,
+                       const char * const func, const int errnum, const long * const status,
+                       const char * const format, va_list args) {
+#ifdef EMIT_STATIC_BUFFER
+    char * const message = m_notedMessage;
+#elif !defined(NOTED_WHOLE_LINE)
+    char message[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_NoteFormat() never writes more than MESSAGE_MAX_LEN
+           bytes. */
+#endif
+
+    if (!ZLog_LevelPasses(level)) {
+        /* filtered: nothing to name */
+    }
+#ifdef EMIT_STATIC_BUFFER
+    else if (m_notedBusy) {
+        /* a signal handler interrupted this thread mid-record; leave its buffer alone and log
+         * a marker with the errno, since the caller's format cannot be expanded */
+        char nested[48] = "[nested]"; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: ZLogOut_t bounds every write to sizeof(nested). */
+        ZLogOut_t out = { nested, sizeof(nested), sizeof("[nested]") - 1 };
+
+        ZLog_OutNotes(&out, errnum, NULL);
+        ZLog_Msg(level, file, line, func, nested);
+    }
+#endif
+    else {
+#ifdef EMIT_STATIC_BUFFER
+        m_notedBusy = true;
+#endif
+#ifdef NOTED_WHOLE_LINE
+        ZLog_WriteNoted(level, file, line, func, errnum, status, format, args);
+#else
+        ZLog_NoteFormat(message, errnum, status, format, args);
+        ZLog_Msg(level, file, line, func, message);
+#endif
+#ifdef EMIT_STATIC_BUFFER
+        m_notedBusy = false;
+#endif
+    }
 }
 
-static void ZLog_StdOut(const ZLogLevel_t level, const char * const file, const int line,
-                        const char * const func, const char * const message) {
-    ZLog_StdFile(stdout, level, file, line, func, message);
+#ifndef NOTED_WHOLE_LINE
+/* The caller's message and its notes, cut to MESSAGE_MAX_LEN bytes with the NUL */
+static void ZLog_NoteFormat(char * const message, const int errnum, const long * const status,
+                            const char * const format, va_list args) {
+    ZLogOut_t out = { message, MESSAGE_MAX_LEN, 0 };
+    const int rc = ZLOG_VSNPRINTF(message, MESSAGE_MAX_LEN, format, args); /* Flawfinder: ignore */
+        /* Warning: use of "vsnprintf" and a user provided format
+           "Ignore" justification: same as in ZLog(). */
+
+    out.len = (0 > rc) ? 0 : (size_t)rc;
+    ZLog_OutNotes(&out, errnum, status);
 }
+#endif
 
-static void ZLog_StdErr(const ZLogLevel_t level, const char * const file, const int line,
-                        const char * const func, const char * const message) {
-    ZLog_StdFile(stderr, level, file, line, func, message);
+/* ": NAME (errno N)" unless errnum is negative, then " [status=N (NAME)]" if there is a status,
+ * after what out already holds; cut like the rest of it */
+#ifdef COMPACT_FORMATTER
+static void ZLog_OutNotes(ZLogOut_t * const out, const int errnum, const long * const status) {
+    /* spelled out rather than formatted to keep a va_list off the stack */
+    const char *name;
+
+    if (0 <= errnum) {
+        name = ZLog_ErrnoName(errnum);
+        ZLog_OutStr(out, ": ", (size_t)-1, 0, false);
+        if (NULL != name) {
+            ZLog_OutStr(out, name, (size_t)-1, 0, false);
+            ZLog_OutStr(out, " (", (size_t)-1, 0, false);
+        }
+        ZLog_OutStr(out, "errno ", (size_t)-1, 0, false);
+        ZLog_OutNum(out, (ZLogUInt_t)(unsigned)errnum, false, 10u, false, 0, false, ' ');
+        if (NULL != name) {
+            ZLog_OutChar(out, ')');
+        }
+    }
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+    if (NULL != status) {
+        name = ZLog_StatusName(*status);
+        ZLog_OutStr(out, " [status=", (size_t)-1, 0, false);
+        ZLog_OutNum(out, (0 > *status) ? (0u - (ZLogUInt_t)*status) : (ZLogUInt_t)*status,
+                    (0 > *status), 10u, false, 0, false, ' ');
+        if (NULL != name) {
+            ZLog_OutStr(out, " (", (size_t)-1, 0, false);
+            ZLog_OutStr(out, name, (size_t)-1, 0, false);
+            ZLog_OutChar(out, ')');
+        }
+        ZLog_OutChar(out, ']');
+    }
+#else
+    UNUSED_VARIABLE(status);
+#endif
+    out->buf[(out->len < (out->size - 1)) ? out->len : (out->size - 1)] = '\0';
 }
+#else
+static void ZLog_OutNotes(ZLogOut_t * const out, const int errnum, const long * const status) {
+    const char *name;
+    size_t used;
+    int rc;
 
-#ifdef Z_CHECK_HAS_SYSLOG
-static inline int ZLog_Level2Syslog(const ZLogLevel_t level) {
-    return (int)level;
+    if (0 <= errnum) {
+        used = (out->len < (out->size - 1)) ? out->len : (out->size - 1);
+        name = ZLog_ErrnoName(errnum);
+        if (NULL != name) {
+            rc = ZLog_Format(out->buf + used, out->size - used, ": %s (errno %d)", name, errnum);
+        }
+        else {
+            rc = ZLog_Format(out->buf + used, out->size - used, ": errno %d", errnum);
+        }
+        out->len = used + ((0 > rc) ? 0 : (size_t)rc);
+    }
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+    if (NULL != status) {
+        used = (out->len < (out->size - 1)) ? out->len : (out->size - 1);
+        name = ZLog_StatusName(*status);
+        if (NULL != name) {
+            rc = ZLog_Format(out->buf + used, out->size - used, " [status=%ld (%s)]", *status,
+                             name);
+        }
+        else {
+            rc = ZLog_Format(out->buf + used, out->size - used, " [status=%ld]", *status);
+        }
+        out->len = used + ((0 > rc) ? 0 : (size_t)rc);
+    }
+#else
+    UNUSED_VARIABLE(status);
+#endif
 }
 
-static void ZLog_Syslog(const ZLogLevel_t level, const char * const file, const int line,
-                        const char * const func, const char * const message) {
-    syslog(ZLog_Level2Syslog(level), "[%s] %s:%d:%s: %s",
-           ZLog_LevelStr(level), file, line, func, message);
+static int ZLog_Format(char * const buf, const size_t size, const char * const format, ...) {
+    va_list args;
+    int rc;
+
+    va_start(args, format);
+    rc = ZLOG_VSNPRINTF(buf, size, format, args); /* Flawfinder: ignore */
+        /* Warning: use of "vsnprintf" and a user provided format
+           "Ignore" justification: only called with the library's own formats. */
+    va_end(args);
+    return rc;
+}
+#endif /* COMPACT_FORMATTER */
+
+#ifdef EMIT_STATIC_BUFFER
+static void ZLog_EmitRaw(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const format) {
+    /* no buffer to format into, so pass the format string through as the message */
+#ifdef WRITE_SINK
+    UNUSED_VARIABLE(level);
+    UNUSED_VARIABLE(file);
+    UNUSED_VARIABLE(line);
+    UNUSED_VARIABLE(func);
+    WRITE_FUNC(format, strlen(format));
+    WRITE_FUNC("\n", 1);
+#else
+    ZLOG_SINK(level, file, line, func, format);
+#endif
+}
+#endif /* EMIT_STATIC_BUFFER */
+
+#ifdef EMIT_ON_STACK
+static void ZLog_EmitOnStack(const ZLogLevel_t level, const char * const file, const int line,
+                             const char * const func, const char * const format, va_list args) {
+    char message[MESSAGE_MAX_LEN] = {0}; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_Emit() never writes more than MESSAGE_MAX_LEN bytes. */
+
+    ZLog_Emit(message, level, file, line, func, format, args);
+}
+#endif /* EMIT_ON_STACK */
+
+#ifdef EMIT_WHOLE_LINE
+static void ZLog_Emit(char * const message, const ZLogLevel_t level, const char * const file,
+                      const int line, const char * const func, const char * const format,
+                      va_list args) {
+    ZLogOut_t out = { message, MESSAGE_MAX_LEN - 1, 0 }; /* keep a byte for the newline */
+#ifdef Z_CHECK_HAS_ARENA
+    char *longLine = NULL;
+    va_list argsLong;
+
+    va_copy(argsLong, args);
+#endif
+    ZLog_OutPrefix(&out, level, file, line, func);
+    ZLog_OutVPrintf(&out, format, args);
+
+#ifdef Z_CHECK_HAS_ARENA
+    if (out.len >= out.size) {
+        /* too long for the stack buffer; redo it in an arena block if one fits */
+        longLine = ZLog_ArenaAlloc(out.len + 1);
+    }
+    if (NULL != longLine) {
+        ZLogOut_t longOut = { longLine, out.len + 1, 0 };
+        ZLog_OutPrefix(&longOut, level, file, line, func);
+        ZLog_OutVPrintf(&longOut, format, argsLong);
+        ZLog_OutLine(&longOut);
+        ZLog_ArenaFree(longLine);
+    }
+    else
+#endif
+    {
+        ZLog_OutLine(&out);
+    }
+#ifdef Z_CHECK_HAS_ARENA
+    va_end(argsLong);
+#endif
+}
+#elif !defined(Z_CHECK_HAS_ASYNC)
+static void ZLog_Emit(char * const message, const ZLogLevel_t level, const char * const file,
+                      const int line, const char * const func, const char * const format,
+                      va_list args) {
+    int rc;
+#ifdef Z_CHECK_HAS_ARENA
+    va_list argsLong;
+
+    va_copy(argsLong, args);
+#endif
+    rc = ZLOG_VSNPRINTF(message, MESSAGE_MAX_LEN - 1, format, args); /* Flawfinder: ignore */
+        /* Warning: use of "vsnprintf" and a user provided format
+           "Ignore" justification: leaving the message format to the caller is a required
+           feature. The code calling this is considered trusted. However, it is up to the
+           calling code to make sure the user cannot influence the format-string itself. */
+
+    if (0 > rc) {
+        ZLOG_SINK(level, file, line, func, FORMAT_FAILED);
+    }
+#ifdef Z_CHECK_HAS_ARENA
+    else if ((MESSAGE_MAX_LEN - 1) <= rc) {
+        ZLog_LongMessage(level, file, line, func, message, (size_t)rc + 1, format, argsLong);
+    }
+#endif
+    else {
+        ZLOG_SINK(level, file, line, func, message);
+    }
+#ifdef Z_CHECK_HAS_ARENA
+    va_end(argsLong);
+#endif
 }
+#endif /* EMIT_WHOLE_LINE */
+
+#ifndef Z_CHECK_FREESTANDING
+static void ZLog_SinkFlush(void) {
+    FILE *stream = NULL;
+
+#ifndef Z_CHECK_STATIC_CONFIG
+    if (ZLog_StdOut == m_ZLogFunc) {
+        stream = stdout;
+    }
+    else if (ZLog_StdErr == m_ZLogFunc) {
+        stream = stderr;
+    }
+    else if (ZLog_File == m_ZLogFunc) {
+        stream = m_logFile;
+    }
+#elif defined(STDOUT_SINK)
+    stream = stdout;
+#elif defined(STDERR_SINK)
+    stream = stderr;
+#elif defined(FILE_SINK)
+    stream = __atomic_load_n(&m_logFile, __ATOMIC_ACQUIRE);
 #endif
 
+    if (NULL != stream) {
+        (void)fflush(stream);
+    }
+#ifdef NET_SINK
+    ZLog_NetFlush();
+#endif
+#ifdef DIRECT_SINK
+    ZLog_DirectFlush();
+#endif
+#ifdef SPOOL_SINK
+    ZLog_SpoolFlush();
+#endif
+}
+
+static inline void ZLog_StdFile(FILE *outfile, const ZLogLevel_t level, const char * const file,
+                                const int line, const char * const func, const char * const message) {
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    const ZLogThread_t * const thread = ZLog_ThreadGet();
+
+    fprintf(outfile, Z_CHECK_LINE_FORMAT, m_moduleName, ZLog_LevelStr(level),
+            (unsigned long)thread->tid, thread->name, file, line, func, message);
+#else
+    fprintf(outfile, Z_CHECK_LINE_FORMAT,
+            m_moduleName, ZLog_LevelStr(level), file, line, func, message);
+#endif
+}
+#endif /* Z_CHECK_FREESTANDING */
+
+#ifdef STDOUT_SINK
+static void ZLog_StdOut(const ZLogLevel_t level, const char * const file, const int line,
+                        const char * const func, const char * const message) {
+    ZLog_StdFile(stdout, level, file, line, func, message);
+}
+#endif
+
+#ifdef STDERR_SINK
+static void ZLog_StdErr(const ZLogLevel_t level, const char * const file, const int line,
+                        const char * const func, const char * const message) {
+    ZLog_StdFile(stderr, level, file, line, func, message);
+}
+#endif
+
+#ifdef FILE_SINK
+static FILE * ZLog_FileOpen(const char * const path) {
+    FILE *logFile = fopen(path, "a"); /* Flawfinder: ignore */
+        /* Warning: check when opening files
+           "Ignore" justification: the path comes from the build configuration or the
+           application, never from logged data. */
+
+    if (NULL == logFile) {
+        /* don't have Z_LOG setup yet to use */
+        fprintf(stderr, "Warning: Cannot open log file %s; falling back to stderr\n", path);
+        logFile = stderr;
+    }
+#ifndef Z_CHECK_HAS_ASYNC
+    else {
+        /* without a writer thread to flush when idle, keep the file current line by line */
+        (void)setvbuf(logFile, NULL, _IOLBF, 0);
+    }
+#endif
+    return logFile;
+}
+
+static FILE * ZLog_FileGet(void) {
+    FILE *logFile = __atomic_load_n(&m_logFile, __ATOMIC_ACQUIRE);
+
+#ifdef Z_CHECK_STATIC_CONFIG
+    if (NULL == logFile) {
+        FILE * const opened = ZLog_FileOpen(Z_CHECK_LOG_FILE_PATH);
+        if (__atomic_compare_exchange_n(&m_logFile, &logFile, opened, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            logFile = opened;
+        }
+        else if (stderr != opened) {
+            /* another thread opened it first; logFile now holds theirs */
+            (void)fclose(opened);
+        }
+    }
+#endif
+    return logFile;
+}
+
+static void ZLog_File(const ZLogLevel_t level, const char * const file, const int line,
+                      const char * const func, const char * const message) {
+    ZLog_StdFile(ZLog_FileGet(), level, file, line, func, message);
+}
+#endif /* FILE_SINK */
+
+#ifdef WRITE_SINK
+#ifndef EMIT_STATIC_BUFFER
+static void ZLog_Write(const ZLogLevel_t level, const char * const file, const int line,
+                       const char * const func, const char * const message) {
+    char buf[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLogOut_t bounds every write to sizeof(buf). */
+    ZLogOut_t out = { buf, MESSAGE_MAX_LEN - 1, 0 }; /* keep a byte for the newline */
+    size_t i;
+
+    ZLog_OutPrefix(&out, level, file, line, func);
+    for (i = 0; '\0' != message[i]; i++) {
+        if (out.len < (out.size - 1)) {
+            buf[out.len] = message[i];
+        }
+        out.len++;
+    }
+    ZLog_OutLine(&out);
+}
+#endif /* EMIT_STATIC_BUFFER */
+
+#ifdef NOTED_WHOLE_LINE
+/* ZLog_Write() for ZLog_Errno() and ZLog_Check(): the caller's message and its notes are
+ * formatted straight into the line, so no message buffer sits on the stack beside it */
+static void ZLog_WriteNoted(const ZLogLevel_t level, const char * const file, const int line,
+                            const char * const func, const int errnum, const long * const status,
+                            const char * const format, va_list args) {
+    char buf[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLogOut_t bounds every write to sizeof(buf). */
+    ZLogOut_t out = { buf, MESSAGE_MAX_LEN - 1, 0 }; /* keep a byte for the newline */
+
+    ZLog_OutPrefix(&out, level, file, line, func);
+    ZLog_OutVPrintf(&out, format, args);
+    ZLog_OutNotes(&out, errnum, status);
+    ZLog_OutLine(&out);
+}
+#endif /* NOTED_WHOLE_LINE */
+
+#ifdef CAPTURE_SINK
+static void ZLog_CaptureWrite(const char * const buf, const size_t len) {
+#if Z_CHECK_CAPTURE_SIZE > 0
+    size_t at = __atomic_load_n(&m_captureLen, __ATOMIC_RELAXED);
+
+    do {
+        if (len > (Z_CHECK_CAPTURE_SIZE - at)) {
+            (void)__atomic_fetch_add(&m_captureDropped, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    } while (!__atomic_compare_exchange_n(&m_captureLen, &at, at + len, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    if (len <= (Z_CHECK_CAPTURE_SIZE - at)) {
+        memcpy(&m_capture[at], buf, len);
+    }
+#else
+    UNUSED_VARIABLE(buf);
+#endif
+    (void)__atomic_fetch_add(&m_captureLines, 1, __ATOMIC_RELAXED);
+    (void)__atomic_fetch_add(&m_captureBytes, len, __ATOMIC_RELAXED);
+}
+#endif /* CAPTURE_SINK */
+
+static void ZLog_OutLine(ZLogOut_t * const out) {
+    size_t len = (out->len < (out->size - 1)) ? out->len : (out->size - 1);
+
+    out->buf[len++] = '\n';
+    WRITE_FUNC(out->buf, len);
+}
+
+#ifndef COMPACT_FORMATTER
+static void ZLog_OutPrefix(ZLogOut_t * const out, const ZLogLevel_t level, const char * const file,
+                           const int line, const char * const func) {
+    int rc;
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    const ZLogThread_t * const thread = ZLog_ThreadGet();
+#endif
+
+#ifdef Z_CHECK_HAS_TRACE
+    ZLog_OutStamp(out);
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    rc = snprintf(out->buf + out->len, out->size - out->len, "%s: [%s] [%lu %s] %s:%d:%s: ",
+                  m_moduleName, ZLog_LevelStr(level), (unsigned long)thread->tid, thread->name,
+                  file, line, func);
+#else
+    rc = snprintf(out->buf + out->len, out->size - out->len, "%s: [%s] %s:%d:%s: ",
+                  m_moduleName, ZLog_LevelStr(level), file, line, func);
+#endif
+    out->len += (0 <= rc) ? (size_t)rc : 0;
+}
+
+#ifdef EMIT_WHOLE_LINE
+static void ZLog_OutVPrintf(ZLogOut_t * const out, const char * const format, va_list args) {
+    const size_t used = (out->len < (out->size - 1)) ? out->len : (out->size - 1);
+    const int rc = vsnprintf(out->buf + used, out->size - used, format, args); /* Flawfinder: ignore */
+        /* Warning: use of "vsnprintf" and a user provided format
+           "Ignore" justification: same as in ZLog(). */
+
+    if (0 <= rc) {
+        out->len = used + (size_t)rc;
+    }
+}
+#endif
+#else
+static void ZLog_OutPrefix(ZLogOut_t * const out, const ZLogLevel_t level, const char * const file,
+                           const int line, const char * const func) {
+    /* spelled out rather than formatted to keep a va_list off the stack */
+#ifdef Z_CHECK_HAS_TRACE
+    ZLog_OutStamp(out);
+#endif
+    ZLog_OutStr(out, m_moduleName, (size_t)-1, 0, false);
+    ZLog_OutStr(out, ": [", (size_t)-1, 0, false);
+    ZLog_OutStr(out, ZLog_LevelStr(level), (size_t)-1, 0, false);
+    ZLog_OutStr(out, "] ", (size_t)-1, 0, false);
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    ZLog_OutChar(out, '[');
+    ZLog_OutNum(out, (ZLogUInt_t)ZLog_ThreadGet()->tid, false, 10u, false, 0, false, ' ');
+    ZLog_OutChar(out, ' ');
+    ZLog_OutStr(out, ZLog_ThreadGet()->name, (size_t)-1, 0, false);
+    ZLog_OutStr(out, "] ", (size_t)-1, 0, false);
+#endif
+    ZLog_OutStr(out, file, (size_t)-1, 0, false);
+    ZLog_OutChar(out, ':');
+    ZLog_OutNum(out, (ZLogUInt_t)(unsigned)line, false, 10u, false, 0, false, ' ');
+    ZLog_OutChar(out, ':');
+    ZLog_OutStr(out, func, (size_t)-1, 0, false);
+    ZLog_OutStr(out, ": ", (size_t)-1, 0, false);
+}
+#endif /* COMPACT_FORMATTER */
+#endif /* WRITE_SINK */
+
+#if defined(COMPACT_FORMATTER) || defined(Z_CHECK_HAS_LOGB)
+static inline void ZLog_OutChar(ZLogOut_t * const out, const char c) {
+    if (out->len < (out->size - 1)) {
+        out->buf[out->len] = c;
+    }
+    out->len++;
+}
+#endif
+
+#ifdef COMPACT_FORMATTER
+/**
+ * Compact printf() subset, for freestanding builds and for Z_FMT_COMPACT.
+ *
+ * Always handles %d %i %u %c %s and %%; Z_CHECK_FMT_HAS_* add length modifiers, hex and
+ * width/precision. Anything else ends formatting with a marker, since the size of its argument
+ * is unknown and the remaining arguments can no longer be trusted.
+ */
+static void ZLog_OutVPrintf(ZLogOut_t * const out, const char * const format, va_list args) {
+    const char *f = format;
+    bool done = false;
+
+    while (!done && ('\0' != *f)) {
+        unsigned width = 0;
+        size_t precision = (size_t)-1;
+        bool leftAlign = false;
+        char pad = ' ';
+        unsigned longs = 0;
+
+        if ('%' != *f) {
+            ZLog_OutChar(out, *f++);
+            continue;
+        }
+        f++;
+
+#if Z_CHECK_FMT_HAS_WIDTH
+        for (; ('-' == *f) || ('0' == *f); f++) {
+            if ('-' == *f) {
+                leftAlign = true;
+            }
+            else {
+                pad = '0';
+            }
+        }
+        if ('*' == *f) {
+            const int arg = va_arg(args, int);
+            leftAlign = leftAlign || (0 > arg);
+            width = (0 > arg) ? (0u - (unsigned)arg) : (unsigned)arg;
+            f++;
+        }
+        for (; ('0' <= *f) && ('9' >= *f); f++) {
+            width = (width * 10u) + (unsigned)(*f - '0');
+        }
+        if ('.' == *f) {
+            f++;
+            precision = 0;
+            if ('*' == *f) {
+                const int arg = va_arg(args, int);
+                precision = (0 > arg) ? (size_t)-1 : (size_t)arg;
+                f++;
+            }
+            for (; ('0' <= *f) && ('9' >= *f); f++) {
+                precision = (precision * 10u) + (size_t)(*f - '0');
+            }
+        }
+#endif
+        for (; ('h' == *f) || ('l' == *f) || ('z' == *f); f++) {
+            /* h and hh arguments arrive promoted to int, so only l, ll and z matter */
+            longs += ('l' == *f) ? 1u : (('z' == *f) ? 3u : 0u);
+        }
+
+        switch (*f) {
+            case '%':
+                ZLog_OutChar(out, '%');
+                break;
+
+            case 'c':
+                ZLog_OutChar(out, (char)va_arg(args, int));
+                break;
+
+            case 's': {
+                const char * const str = va_arg(args, const char *);
+                ZLog_OutStr(out, (NULL != str) ? str : "(null)", precision, width, leftAlign);
+                break;
+            }
+
+            case 'd':
+            case 'i': {
+                ZLogUInt_t magnitude;
+                bool negative;
+#if Z_CHECK_FMT_HAS_LONG
+                long long value;
+                if (3u == longs) {
+                    value = (long long)va_arg(args, size_t);
+                }
+                else if (2u == longs) {
+                    value = va_arg(args, long long);
+                }
+                else if (1u == longs) {
+                    value = va_arg(args, long);
+                }
+                else {
+                    value = va_arg(args, int);
+                }
+#else
+                const int value = va_arg(args, int);
+#endif
+                negative = (0 > value);
+                magnitude = negative ? (0u - (ZLogUInt_t)value) : (ZLogUInt_t)value;
+                ZLog_OutNum(out, magnitude, negative, 10u, false, width, leftAlign, pad);
+                break;
+            }
+
+            case 'u':
+#if Z_CHECK_FMT_HAS_HEX
+            case 'x':
+            case 'X':
+#endif
+            {
+                const unsigned base = ('u' == *f) ? 10u : 16u;
+                ZLogUInt_t value;
+#if Z_CHECK_FMT_HAS_LONG
+                if (3u == longs) {
+                    value = va_arg(args, size_t);
+                }
+                else if (2u == longs) {
+                    value = va_arg(args, unsigned long long);
+                }
+                else if (1u == longs) {
+                    value = va_arg(args, unsigned long);
+                }
+                else {
+                    value = va_arg(args, unsigned);
+                }
+#else
+                value = va_arg(args, unsigned);
+#endif
+                ZLog_OutNum(out, value, false, base, ('X' == *f), width, leftAlign, pad);
+                break;
+            }
+
+#if Z_CHECK_FMT_HAS_HEX
+            case 'p': {
+                const void * const ptr = va_arg(args, void *);
+                ZLog_OutStr(out, "0x", (size_t)-1, 0, false);
+                ZLog_OutNum(out, (ZLogUInt_t)(uintptr_t)ptr, false, 16u, false, width,
+                            leftAlign, pad);
+                break;
+            }
+#endif
+
+            default:
+                ZLog_OutStr(out, "[z_check: unsupported conversion]", (size_t)-1, 0, false);
+                done = true;
+                break;
+        }
+        if ('\0' != *f) {
+            f++;
+        }
+    }
+    out->buf[(out->len < (out->size - 1)) ? out->len : (out->size - 1)] = '\0';
+}
+
+/* vsnprintf() replacement on top of ZLog_OutVPrintf() */
+static inline int ZLog_VFormat(char * const buf, const size_t size, const char * const format,
+                               va_list args) {
+    ZLogOut_t out = { buf, size, 0 };
+
+    ZLog_OutVPrintf(&out, format, args);
+    return (int)out.len;
+}
+
+static void ZLog_OutPad(ZLogOut_t * const out, const char pad, unsigned count) {
+    for (; 0 < count; count--) {
+        ZLog_OutChar(out, pad);
+    }
+}
+
+static void ZLog_OutStr(ZLogOut_t * const out, const char * const str, const size_t maxLen,
+                        const unsigned width, const bool leftAlign) {
+    size_t len = 0;
+    size_t i;
+
+    while ((len < maxLen) && ('\0' != str[len])) {
+        len++;
+    }
+    if (!leftAlign && (width > len)) {
+        ZLog_OutPad(out, ' ', width - (unsigned)len);
+    }
+    for (i = 0; i < len; i++) {
+        ZLog_OutChar(out, str[i]);
+    }
+    if (leftAlign && (width > len)) {
+        ZLog_OutPad(out, ' ', width - (unsigned)len);
+    }
+}
+
+static void ZLog_OutNum(ZLogOut_t * const out, ZLogUInt_t value, const bool negative,
+                        const unsigned base, const bool upper, const unsigned width,
+                        const bool leftAlign, const char pad) {
+    const char * const digitChars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char digits[24]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: holds at most the 20 digits of a 64-bit value. */
+    unsigned len = 0;
+    unsigned total;
+
+    do {
+        digits[len++] = digitChars[value % base];
+        value /= base;
+    } while (0u != value);
+
+    total = len + (negative ? 1u : 0u);
+    if (!leftAlign && (' ' == pad) && (width > total)) {
+        ZLog_OutPad(out, ' ', width - total);
+    }
+    if (negative) {
+        ZLog_OutChar(out, '-');
+    }
+    if (!leftAlign && ('0' == pad) && (width > total)) {
+        ZLog_OutPad(out, '0', width - total);
+    }
+    while (0u < len) {
+        ZLog_OutChar(out, digits[--len]);
+    }
+    if (leftAlign && (width > total)) {
+        ZLog_OutPad(out, ' ', width - total);
+    }
+}
+#endif /* COMPACT_FORMATTER */
+
+#ifdef SYSLOG_SINK
+static inline int ZLog_Level2Syslog(const ZLogLevel_t level) {
+    return (int)level;
+}
+
+static void ZLog_Syslog(const ZLogLevel_t level, const char * const file, const int line,
+                        const char * const func, const char * const message) {
+#ifdef Z_CHECK_STATIC_CONFIG
+    if (!__atomic_exchange_n(&m_syslogOpened, 1, __ATOMIC_RELAXED)) {
+        openlog(m_moduleName, LOG_CONS, LOG_LOCAL0);
+    }
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    syslog(ZLog_Level2Syslog(level), "[%s] [%lu %s] %s:%d:%s: %s", ZLog_LevelStr(level),
+           (unsigned long)ZLog_ThreadGet()->tid, ZLog_ThreadGet()->name, file, line, func, message);
+#else
+    syslog(ZLog_Level2Syslog(level), "[%s] %s:%d:%s: %s",
+           ZLog_LevelStr(level), file, line, func, message);
+#endif
+}
+#endif
+
+#if defined(Z_CHECK_HAS_ARENA) && !defined(Z_CHECK_HAS_ASYNC) && !defined(EMIT_WHOLE_LINE)
+static void ZLog_LongMessage(const ZLogLevel_t level, const char * const file, const int line,
+                             const char * const func, const char * const truncated,
+                             const size_t len, const char * const format, va_list args) {
+    char * const message = ZLog_ArenaAlloc(len);
+
+    if (NULL == message) {
+        /* arena exhausted or message too long for any class; settle for the stack copy */
+        ZLOG_SINK(level, file, line, func, truncated);
+    }
+    else {
+        (void)ZLOG_VSNPRINTF(message, len, format, args); /* Flawfinder: ignore */
+            /* Warning: use of "vsnprintf" and a user provided format
+               "Ignore" justification: same as in ZLog(). */
+        ZLOG_SINK(level, file, line, func, message);
+        ZLog_ArenaFree(message);
+    }
+}
+#endif
+
+#ifdef Z_CHECK_HAS_ARENA
+static ZLogArena_t * ZLog_ArenaGet(void) {
+    if (NULL == m_threadArena) {
+        (void)pthread_once(&m_arenaKeyOnce, ZLog_ArenaKeyInit);
+        m_threadArena = ZLog_ArenaClaim();
+        if (NULL != m_threadArena) {
+            __atomic_store_n(&m_threadArena->owned, 1, __ATOMIC_RELAXED);
+            (void)pthread_setspecific(m_arenaKey, m_threadArena);
+        }
+    }
+    return m_threadArena;
+}
+
+/* The arena given back last, whose blocks are carved and likely still cached, else a new one */
+static ZLogArena_t * ZLog_ArenaClaim(void) {
+    uint64_t head = __atomic_load_n(&m_arenaFree, __ATOMIC_ACQUIRE);
+    unsigned untouched = __atomic_load_n(&m_arenaUntouched, __ATOMIC_RELAXED);
+    ZLogArena_t *arena = NULL;
+
+    while ((NULL == arena) && (0 != (uint32_t)head)) {
+        ZLogArena_t * const top = &m_arenas[(uint32_t)head - 1u];
+        const uint64_t next = (((head >> 32) + 1u) << 32) |
+                              __atomic_load_n(&top->freeNext, __ATOMIC_RELAXED);
+
+        /* a stale next only matters if top was taken meanwhile, which moved the generation */
+        if (__atomic_compare_exchange_n(&m_arenaFree, &head, next, true, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE)) {
+            arena = top;
+        }
+    }
+    while ((NULL == arena) && (untouched < Z_CHECK_ARENA_MAX_THREADS)) {
+        if (__atomic_compare_exchange_n(&m_arenaUntouched, &untouched, untouched + 1u, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            arena = &m_arenas[untouched];
+        }
+    }
+    return arena;
+}
+
+static void ZLog_ArenaKeyInit(void) {
+    (void)pthread_key_create(&m_arenaKey, ZLog_ArenaRelease);
+}
+
+/**
+ * Give an exiting thread's arena to the next new one.
+ *
+ * Blocks still out with the writer keep coming back to the returned stacks, where the next owner
+ * finds them; its free lists and carved storage go along as they are. Runs on the exiting
+ * thread, so a log from a later destructor claims an arena afresh rather than using this one.
+ */
+static void ZLog_ArenaRelease(void *arena) {
+    ZLogArena_t * const released = arena;
+    const uint32_t index = (uint32_t)(released - m_arenas) + 1u;
+    uint64_t head = __atomic_load_n(&m_arenaFree, __ATOMIC_RELAXED);
+
+    m_threadArena = NULL;
+    __atomic_store_n(&released->owned, 0, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&released->freeNext, (unsigned)(uint32_t)head, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&m_arenaFree, &head,
+                                          (((head >> 32) + 1u) << 32) | index, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* Carve the next step of a class's blocks, if the arena has more and the budget allows */
+static void ZLog_ArenaGrow(ZLogArena_t * const arena, const unsigned sizeClass) {
+    const unsigned blocks = m_arenaClassBlocks[sizeClass];
+    const unsigned step = (blocks + (Z_CHECK_ARENA_GROW_STEPS - 1u)) / Z_CHECK_ARENA_GROW_STEPS;
+    const unsigned carved = arena->carved[sizeClass];
+    const unsigned count = ((blocks - carved) < step) ? (blocks - carved) : step;
+    unsigned char *next = arena->storage;
+    unsigned c;
+    unsigned i;
+
+    if ((0 == count) || !ZLog_ArenaBudgetTake((unsigned long)count * ARENA_CLASS_SIZE(sizeClass))) {
+        return;
+    }
+    for (c = 0; c < sizeClass; c++) {
+        next += m_arenaClassBlocks[c] * ARENA_CLASS_SIZE(c);
+    }
+    next += carved * ARENA_CLASS_SIZE(sizeClass);
+    for (i = 0; i < count; i++) {
+        ZLogBlock_t * const block = (ZLogBlock_t *)(void *)next;
+        block->arena = arena;
+        block->sizeClass = sizeClass;
+        block->next = arena->freeList[sizeClass];
+        arena->freeList[sizeClass] = block;
+        next += ARENA_CLASS_SIZE(sizeClass);
+    }
+    arena->carved[sizeClass] = carved + count;
+}
+
+static bool ZLog_ArenaBudgetTake(const unsigned long bytes) {
+#if Z_CHECK_ARENA_BUDGET > 0
+    unsigned long carved = __atomic_load_n(&m_arenaCarved, __ATOMIC_RELAXED);
+
+    do {
+        if (bytes > ((unsigned long)Z_CHECK_ARENA_BUDGET - carved)) {
+            (void)__atomic_fetch_add(&m_arenaOverBudget, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&m_arenaCarved, &carved, carved + bytes, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+    (void)__atomic_fetch_add(&m_arenaCarved, bytes, __ATOMIC_RELAXED);
+#endif
+    return true;
+}
+
+static void * ZLog_ArenaAlloc(const size_t size) {
+    ZLogArena_t * const arena = ZLog_ArenaGet();
+    void *ptr = NULL;
+    unsigned c;
+
+    if (NULL == arena) {
+        (void)__atomic_fetch_add(&m_arenaNoArena, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        for (c = 0; (c < ARENA_CLASSES) && (NULL == ptr); c++) {
+            ZLogBlock_t *block;
+
+            if ((size + sizeof(ZLogBlock_t)) > ARENA_CLASS_SIZE(c)) {
+                continue;
+            }
+            if (NULL == arena->freeList[c]) {
+                arena->freeList[c] = __atomic_exchange_n(&arena->returned[c], NULL,
+                                                         __ATOMIC_ACQUIRE);
+            }
+            if (NULL == arena->freeList[c]) {
+                ZLog_ArenaGrow(arena, c);
+            }
+            block = arena->freeList[c];
+            if (NULL != block) {
+                const unsigned long out = (arena->allocs[c] + 1) - arena->frees[c]
+                                        - ZLog_StatRead(&arena->remoteFrees[c]);
+                arena->freeList[c] = block->next;
+                ZLog_StatBump(&arena->allocs[c]);
+                if (out > arena->highWater[c]) {
+                    __atomic_store_n(&arena->highWater[c], out, __ATOMIC_RELAXED);
+                }
+                ptr = block + 1;
+            }
+        }
+        if (NULL == ptr) {
+            ZLog_StatBump(&arena->failures);
+        }
+    }
+    return ptr;
+}
+
+static void ZLog_ArenaFree(void * const ptr) {
+    ZLogBlock_t * const block = (ZLogBlock_t *)ptr - 1;
+    ZLogArena_t * const arena = block->arena;
+    const unsigned c = block->sizeClass;
+
+    if (arena == m_threadArena) {
+        block->next = arena->freeList[c];
+        arena->freeList[c] = block;
+        ZLog_StatBump(&arena->frees[c]);
+    }
+    else {
+        block->next = __atomic_load_n(&arena->returned[c], __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&arena->returned[c], &block->next, block, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            /* block->next was refreshed with the current top; try again */
+        }
+        (void)__atomic_fetch_add(&arena->remoteFrees[c], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static inline unsigned long ZLog_StatRead(const unsigned long * const stat) {
+    return __atomic_load_n(stat, __ATOMIC_RELAXED);
+}
+
+static inline void ZLog_StatBump(unsigned long * const stat) {
+    /* only for counters with a single writer; readers just need an untorn value */
+    __atomic_store_n(stat, *stat + 1, __ATOMIC_RELAXED);
+}
+#endif /* Z_CHECK_HAS_ARENA */
+
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_EmitAsync(const ZLogLevel_t level, const char * const file, const int line,
+                           const char * const func, const char * const format, va_list args) {
+    size_t capacity = RECORD_CAPACITY(0);
+    ZLogRecord_t *record = ZLog_RecordAlloc(&capacity);
+    va_list argsLong;
+
+    va_copy(argsLong, args);
+    if (NULL == record) {
+        (void)__atomic_fetch_add(&m_asyncDropped, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        const int rc = ZLOG_VSNPRINTF(record->message, capacity, format, args); /* Flawfinder: ignore */
+            /* Warning: use of "vsnprintf" and a user provided format
+               "Ignore" justification: same as in ZLog(). */
+
+        if (0 > rc) {
+            memcpy(record->message, FORMAT_FAILED, sizeof(FORMAT_FAILED));
+        }
+        else if ((size_t)rc >= capacity) {
+            /* try a bigger block; if there is none, the truncated record still goes out */
+            ZLogRecord_t *longRecord;
+
+            capacity = (size_t)rc + 1;
+            longRecord = ZLog_RecordAlloc(&capacity);
+            if (NULL != longRecord) {
+                ZLog_ArenaFree(record);
+                record = longRecord;
+                (void)ZLOG_VSNPRINTF(record->message, capacity, format, argsLong); /* Flawfinder: ignore */
+                    /* Warning: use of "vsnprintf" and a user provided format
+                       "Ignore" justification: same as in ZLog(). */
+            }
+        }
+        ZLog_Enqueue(record, level, file, line, func);
+    }
+    va_end(argsLong);
+}
+
+static void ZLog_EnqueueMsg(const ZLogLevel_t level, const char * const file, const int line,
+                            const char * const func, const char * const message) {
+    size_t capacity = strlen(message) + 1;
+    ZLogRecord_t * const record = ZLog_RecordAlloc(&capacity);
+
+    if (NULL == record) {
+        (void)__atomic_fetch_add(&m_asyncDropped, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        memcpy(record->message, message, capacity - 1);
+        record->message[capacity - 1] = '\0';
+        ZLog_Enqueue(record, level, file, line, func);
+    }
+}
+
+static ZLogRecord_t * ZLog_RecordAlloc(size_t * const capacity) {
+    ZLogRecord_t *record;
+
+    /* messages too long for the biggest class are cut to fit it */
+    if (*capacity > RECORD_CAPACITY(ARENA_CLASSES - 1)) {
+        *capacity = RECORD_CAPACITY(ARENA_CLASSES - 1);
+    }
+    record = ZLog_ArenaAlloc(sizeof(ZLogRecord_t) + *capacity);
+    if ((NULL == record) && (NULL != m_threadArena)) {
+        /* all of this thread's blocks are queued; wait for the writer to hand them back */
+        ZLog_AsyncDrain();
+        record = ZLog_ArenaAlloc(sizeof(ZLogRecord_t) + *capacity);
+    }
+#ifdef Z_CHECK_HAS_LOGB
+    if (NULL != record) {
+        record->format = NULL;
+#ifdef Z_CHECK_LOGB_IDS
+        record->site = NULL;
+#endif
+#ifdef Z_CHECK_HAS_TRACE
+        record->span = 0;
+#endif
+    }
+#endif
+    return record;
+}
+
+static void ZLog_AsyncDrain(void) {
+    const unsigned long target = __atomic_load_n(&m_asyncQueued, __ATOMIC_SEQ_CST);
+
+    (void)pthread_mutex_lock(&m_writerLock);
+    (void)__atomic_fetch_add(&m_flushWaiting, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&m_writerRunning, __ATOMIC_RELAXED) && ZLog_AsyncBehind(target)) {
+        (void)pthread_cond_signal(&m_writerWake);
+        (void)pthread_cond_wait(&m_writerDone, &m_writerLock);
+    }
+    (void)__atomic_fetch_sub(&m_flushWaiting, 1, __ATOMIC_SEQ_CST);
+    (void)pthread_mutex_unlock(&m_writerLock);
+}
+
+/* Records up to target not written yet, or written but held back by the sink */
+static inline bool ZLog_AsyncBehind(const unsigned long target) {
+#ifdef JOURNAL_SINK
+    if (ZLog_JournalPending()) {
+        return true;    /* the writer sends the batch when the queue runs dry */
+    }
+#endif
+    return __atomic_load_n(&m_asyncWritten, __ATOMIC_SEQ_CST) < target;
+}
+
+static void ZLog_Enqueue(ZLogRecord_t * const record, const ZLogLevel_t level,
+                         const char * const file, const int line, const char * const func) {
+    record->level = level;
+    record->file = file;
+    record->line = line;
+    record->func = func;
+#ifdef Z_CHECK_HAS_TRACE
+    ZLog_StampGet(&record->stamp);
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    record->thread = *ZLog_ThreadSelf();
+#ifdef Z_CHECK_LOGB_IDS
+    if (NULL != record->site) {
+        m_threadInfo.named = true;  /* the writer sends the name ahead of this frame */
+    }
+#endif
+#endif
+
+#ifdef Z_CHECK_STATIC_CONFIG
+    (void)pthread_once(&m_writerOnce, ZLog_AsyncStart);
+#endif
+    if (!__atomic_load_n(&m_writerRunning, __ATOMIC_ACQUIRE)) {
+        /* no writer (not started, stopped at exit, or failed to start); write it here */
+        ZLog_RecordSink(record);
+        ZLog_ArenaFree(record);
+    }
+    else {
+        (void)__atomic_fetch_add(&m_asyncQueued, 1, __ATOMIC_SEQ_CST);
+        ZLog_QueuePush(record);
+        if (__atomic_load_n(&m_writerSleeping, __ATOMIC_SEQ_CST)) {
+            (void)pthread_mutex_lock(&m_writerLock);
+            (void)pthread_cond_signal(&m_writerWake);
+            (void)pthread_mutex_unlock(&m_writerLock);
+        }
+    }
+}
+
+static void ZLog_QueuePush(ZLogRecord_t * const record) {
+    ZLogRecord_t *prev;
+
+    __atomic_store_n(&record->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&m_queueTail, record, __ATOMIC_ACQ_REL);
+    /* seq_cst so the writer either sees this link or is seen sleeping by ZLog_Enqueue() */
+    __atomic_store_n(&prev->next, record, __ATOMIC_SEQ_CST);
+}
+
+static ZLogRecord_t * ZLog_QueuePop(void) {
+    ZLogRecord_t *head = m_queueHead;
+    ZLogRecord_t *next = __atomic_load_n(&head->next, __ATOMIC_SEQ_CST);
+    ZLogRecord_t *record = NULL;
+
+    if (&m_queueStub == head) {
+        if (NULL != next) {
+            m_queueHead = next;
+            head = next;
+            next = __atomic_load_n(&head->next, __ATOMIC_SEQ_CST);
+        }
+    }
+    if (&m_queueStub == head) {
+        /* empty */
+    }
+    else if (NULL != next) {
+        m_queueHead = next;
+        record = head;
+    }
+    else if (head == __atomic_load_n(&m_queueTail, __ATOMIC_ACQUIRE)) {
+        /* head is the last record; put the stub behind it so head can be taken */
+        ZLog_QueuePush(&m_queueStub);
+        next = __atomic_load_n(&head->next, __ATOMIC_SEQ_CST);
+        if (NULL != next) {
+            m_queueHead = next;
+            record = head;
+        }
+    }
+    else {
+        /* a producer has swapped in at the tail but not linked yet; it will shortly */
+    }
+    return record;
+}
+
+static void ZLog_AsyncStart(void) {
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+    (void)pthread_mutex_lock(&m_writerLock);
+    m_writerStop = false;
+    __atomic_store_n(&m_writerRunning, (0 == pthread_create(&m_writer, NULL, ZLog_Writer, NULL)),
+                     __ATOMIC_RELEASE);
+    (void)pthread_mutex_unlock(&m_writerLock);
+#ifdef Z_CHECK_STATIC_CONFIG
+    (void)atexit(ZLog_AsyncStop);
+#endif
+}
+
+static void ZLog_AsyncStop(void) {
+    ZLogRecord_t *record;
+    int running;
+
+    ZLog_Flush();
+    (void)pthread_mutex_lock(&m_writerLock);
+    m_writerStop = true;
+    running = __atomic_load_n(&m_writerRunning, __ATOMIC_RELAXED);
+    (void)pthread_cond_signal(&m_writerWake);
+    (void)pthread_mutex_unlock(&m_writerLock);
+
+    if (running) {
+        (void)pthread_join(m_writer, NULL);
+        __atomic_store_n(&m_writerRunning, 0, __ATOMIC_RELEASE);
+    }
+    /* records that slipped in while the writer was stopping */
+    while (NULL != (record = ZLog_QueuePop())) {
+        ZLog_RecordSink(record);
+        ZLog_ArenaFree(record);
+    }
+#ifndef Z_CHECK_FREESTANDING
+    ZLog_SinkFlush();
+#endif
+#ifdef NET_SINK
+    ZLog_NetExit();
+#endif
+}
+
+/* The writer thread doesn't survive fork(). The child leaves the queued records to the parent
+ * and writes its own from the calling thread from now on. */
+static void ZLog_AsyncForkChild(void) {
+    __atomic_store_n(&m_queueStub.next, NULL, __ATOMIC_RELAXED);
+    m_queueHead = &m_queueStub;
+    __atomic_store_n(&m_queueTail, &m_queueStub, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_writerRunning, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_writerSleeping, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_flushWaiting, 0, __ATOMIC_RELAXED);
+    (void)pthread_cond_init(&m_writerWake, NULL);
+    (void)pthread_cond_init(&m_writerDone, NULL);
+    (void)pthread_mutex_unlock(&m_writerLock);
+}
+
+static void * ZLog_Writer(void *unused) {
+    unsigned long reportedDrops = ZLog_StatRead(&m_asyncDropped);
+    bool running = true;
+
+    UNUSED_VARIABLE(unused);
+#ifdef JOURNAL_SINK
+    ZLog_JournalWriterInit();
+#endif
+    while (running) {
+        ZLogRecord_t *record = ZLog_QueuePop();
+
+        if (NULL == record) {
+            ZLog_WriterIdle(&reportedDrops);
+
+            (void)pthread_mutex_lock(&m_writerLock);
+            __atomic_store_n(&m_writerSleeping, 1, __ATOMIC_SEQ_CST);
+            record = ZLog_QueuePop();
+            if ((NULL == record) && !m_writerStop) {
+                /* the timeout covers any wakeup lost to a producer that was mid-push */
+                struct timespec until;
+                (void)clock_gettime(CLOCK_REALTIME, &until);
+                until.tv_nsec += WRITER_IDLE_NS;
+                if (1000000000L <= until.tv_nsec) {
+                    until.tv_sec++;
+                    until.tv_nsec -= 1000000000L;
+                }
+                (void)pthread_cond_timedwait(&m_writerWake, &m_writerLock, &until);
+            }
+            __atomic_store_n(&m_writerSleeping, 0, __ATOMIC_RELAXED);
+            running = (NULL != record) || !m_writerStop;
+            (void)pthread_mutex_unlock(&m_writerLock);
+        }
+
+        if (NULL != record) {
+            ZLog_RecordSink(record);
+            ZLog_ArenaFree(record);
+#ifdef FILE_WRITEBACK
+            ZLog_FileWriteback();   /* a busy writer may not go idle for a long while */
+#endif
+            __atomic_store_n(&m_asyncWritten, m_asyncWritten + 1, __ATOMIC_SEQ_CST);
+            if (0 != __atomic_load_n(&m_flushWaiting, __ATOMIC_SEQ_CST)) {
+                (void)pthread_mutex_lock(&m_writerLock);
+                (void)pthread_cond_broadcast(&m_writerDone);
+                (void)pthread_mutex_unlock(&m_writerLock);
+            }
+        }
+    }
+    return NULL;
+}
+
+/* The writer thread's idle check, every WRITER_IDLE_NS while there is nothing to write */
+static void ZLog_WriterIdle(unsigned long * const reportedDrops) {
+    const unsigned long dropped = ZLog_StatRead(&m_asyncDropped);
+
+    if (dropped != *reportedDrops) {
+        char message[64]; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: snprintf() is bounded by sizeof(message). */
+        (void)snprintf(message, sizeof(message), "[z_check: dropped %lu records, arena full]",
+                       dropped - *reportedDrops);
+        ZLOG_SINK(Z_WARN, __FILENAME__, __LINE__, __func__, message);
+        *reportedDrops = dropped;
+    }
+#ifdef NET_SINK
+    ZLog_NetIdle();     /* frames wait out the linger; ZLog_Flush() seals them at once */
+#elif defined(DIRECT_SINK)
+    ZLog_DirectIdle();  /* the last block waits out the linger before it is padded and written */
+#else
+    ZLog_SinkFlush();
+#endif
+#ifdef FILE_WRITEBACK
+    ZLog_FileWriteback();
+#endif
+#ifdef JOURNAL_SINK
+    ZLog_JournalSendBatch();
+#endif
+
+    (void)pthread_mutex_lock(&m_writerLock);
+    (void)pthread_cond_broadcast(&m_writerDone);
+    (void)pthread_mutex_unlock(&m_writerLock);
+}
+
+static void ZLog_RecordSink(const ZLogRecord_t * const record) {
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    m_sinkThread = &record->thread;
+#endif
+#ifdef Z_CHECK_HAS_TRACE
+    m_sinkStamp = &record->stamp;
+    if (0 != record->span) {
+        ZLog_WriteSpan(record->span, record->site);
+    }
+    else
+#endif
+#ifdef Z_CHECK_LOGB_IDS
+    if (NULL != record->site) {
+        unsigned char frame[FRAME_MAX];
+
+        ZLog_WriteFrame(frame, record->level, record->site,
+                        (const unsigned char *)record->message, record->argsLen);
+    }
+    else
+#endif
+#ifdef Z_CHECK_HAS_LOGB
+    if (NULL != record->format) {
+        char message[MESSAGE_MAX_LEN]; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: ZLogOut_t bounds every write to sizeof(message). */
+        ZLogOut_t out = { message, sizeof(message), 0 };
+
+        ZLog_OutBinary(&out, record->format, (const unsigned char *)record->message,
+                       record->argsLen);
+        ZLOG_SINK(record->level, record->file, record->line, record->func, message);
+    }
+    else
+#endif
+    {
+        ZLOG_SINK(record->level, record->file, record->line, record->func, record->message);
+    }
+#ifdef Z_CHECK_HAS_TRACE
+    m_sinkStamp = NULL;
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    m_sinkThread = NULL;
+#endif
+}
+#endif /* Z_CHECK_HAS_ASYNC */
+
+#ifdef Z_CHECK_HAS_LOGB
+#ifdef Z_CHECK_HAS_ASYNC
+/* A record holding a copy of the arguments, for the caller to fill in and enqueue */
+static ZLogRecord_t * ZLog_RecordArgs(const unsigned char * const args, const size_t len) {
+    size_t capacity = len;
+    ZLogRecord_t *record = ZLog_RecordAlloc(&capacity);
+
+    if ((NULL != record) && (capacity < len)) {
+        /* arguments cannot be cut like text */
+        ZLog_ArenaFree(record);
+        record = NULL;
+    }
+    if (NULL == record) {
+        (void)__atomic_fetch_add(&m_asyncDropped, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        memcpy(record->message, args, len);
+        record->argsLen = len;
+    }
+    return record;
+}
+#else
+static void ZLog_EmitBinary(char * const message, const ZLogLevel_t level,
+                            const char * const file, const int line, const char * const func,
+                            const char * const format, const unsigned char * const args,
+                            const size_t len) {
+#ifdef EMIT_WHOLE_LINE
+    ZLogOut_t out = { message, MESSAGE_MAX_LEN - 1, 0 }; /* keep a byte for the newline */
+
+    ZLog_OutPrefix(&out, level, file, line, func);
+    ZLog_OutBinary(&out, format, args, len);
+    ZLog_OutLine(&out);
+#else
+    ZLogOut_t out = { message, MESSAGE_MAX_LEN, 0 };
+
+    ZLog_OutBinary(&out, format, args, len);
+    ZLOG_SINK(level, file, line, func, message);
+#endif
+}
+#endif /* Z_CHECK_HAS_ASYNC */
+
+/**
+ * Format Z_LOGB() arguments against their printf() format.
+ *
+ * Each conversion is rebuilt without its length modifier, since the tags carry the real types,
+ * and handed to snprintf() with the widened value. '*' widths and precisions are read from the
+ * arguments and written into the spec. A conversion whose argument is missing or of the wrong
+ * kind ends formatting with a marker.
+ */
+static void ZLog_OutBinary(ZLogOut_t * const out, const char * const format,
+                           const unsigned char * const args, const size_t len) {
+    const char *f = format;
+    size_t pos = 0;
+    bool done = false;
+
+    while (!done && ('\0' != *f)) {
+        char spec[48]; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: holds '%', 5 flags, two clamped numbers, "ll" and the
+               conversion, all written with bounded calls. */
+        size_t specLen = 1;
+        int width = -1;
+        int precision = -1;
+        bool mismatch = false;
+        char conv;
+        ZLogArg_t arg;
+
+        if ('%' != *f) {
+            ZLog_OutChar(out, *f++);
+            continue;
+        }
+        f++;
+        if ('%' == *f) {
+            ZLog_OutChar(out, *f++);
+            continue;
+        }
+
+        spec[0] = '%';
+        for (; ('\0' != *f) && (NULL != strchr("-+ #0", *f)); f++) {
+            if (specLen < 6) {
+                spec[specLen++] = *f;
+            }
+        }
+        if (ZLog_SpecNum(&f, args, len, &pos, &width) && (0 > width)) {
+            spec[specLen++] = '-';
+            width = -width;
+        }
+        if ('.' == *f) {
+            f++;
+            if (!ZLog_SpecNum(&f, args, len, &pos, &precision)) {
+                precision = 0;
+            }
+        }
+        for (; ('\0' != *f) && (NULL != strchr("hlLqjzt", *f)); f++) {
+            /* the tag says how wide the argument really is */
+        }
+        conv = *f;
+        if ('\0' != *f) {
+            f++;
+        }
+
+        if (0 <= width) {
+            specLen += (size_t)snprintf(&spec[specLen], sizeof(spec) - specLen, "%d", width);
+        }
+        if ((0 <= precision) && ('s' != conv)) {
+            specLen += (size_t)snprintf(&spec[specLen], sizeof(spec) - specLen, ".%d", precision);
+        }
+
+        if (!ZLog_ArgNext(args, len, &pos, &arg)) {
+            ZLog_OutSpec(out, "%s", "[z_check: missing argument]");
+            done = true;
+            continue;
+        }
+        switch (conv) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                mismatch = !ZLog_ArgIsInt(&arg);
+                if (!mismatch) {
+                    (void)snprintf(&spec[specLen], sizeof(spec) - specLen, "ll%c", conv);
+                    if (('d' == conv) || ('i' == conv)) {
+                        ZLog_OutSpec(out, spec, arg.s);
+                    }
+                    else {
+                        ZLog_OutSpec(out, spec, arg.u);
+                    }
+                }
+                break;
+
+            case 'c':
+                mismatch = !ZLog_ArgIsInt(&arg);
+                if (!mismatch) {
+                    (void)snprintf(&spec[specLen], sizeof(spec) - specLen, "%c", conv);
+                    ZLog_OutSpec(out, spec, (int)arg.s);
+                }
+                break;
+
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                mismatch = (Z_ARG_DOUBLE != arg.type);
+                if (!mismatch) {
+                    (void)snprintf(&spec[specLen], sizeof(spec) - specLen, "%c", conv);
+                    ZLog_OutSpec(out, spec, arg.d);
+                }
+                break;
+
+            case 'p':
+                mismatch = (Z_ARG_PTR != arg.type);
+                if (!mismatch) {
+                    (void)snprintf(&spec[specLen], sizeof(spec) - specLen, "%c", conv);
+                    ZLog_OutSpec(out, spec, arg.p);
+                }
+                break;
+
+            case 's':
+                mismatch = (Z_ARG_STR != arg.type);
+                if (!mismatch) {
+                    const size_t strLen = ((0 <= precision) && ((size_t)precision < arg.strLen))
+                                        ? (size_t)precision : arg.strLen;
+                    (void)snprintf(&spec[specLen], sizeof(spec) - specLen, ".*s");
+                    ZLog_OutSpec(out, spec, (int)strLen, arg.str);
+                }
+                break;
+
+            default:
+                ZLog_OutSpec(out, "%s", "[z_check: unsupported conversion]");
+                done = true;
+                break;
+        }
+        if (mismatch) {
+            ZLog_OutSpec(out, "%s", "[z_check: argument mismatch]");
+            done = true;
+        }
+    }
+    out->buf[(out->len < (out->size - 1)) ? out->len : (out->size - 1)] = '\0';
+}
+
+/* Read a width or precision, literal or '*'; clamped so the spec stays short */
+static bool ZLog_SpecNum(const char ** const f, const unsigned char * const args,
+                         const size_t len, size_t * const pos, int * const value) {
+    bool present = true;
+    long long number = 0;
+
+    if ('*' == **f) {
+        ZLogArg_t arg;
+        (*f)++;
+        present = ZLog_ArgNext(args, len, pos, &arg) && ZLog_ArgIsInt(&arg);
+        number = arg.s;
+    }
+    else if (('0' <= **f) && ('9' >= **f)) {
+        for (; ('0' <= **f) && ('9' >= **f); (*f)++) {
+            number = (number < 100000) ? ((number * 10) + (**f - '0')) : number;
+        }
+    }
+    else {
+        present = false;
+    }
+    if (number > 9999) {
+        number = 9999;
+    }
+    else if (number < -9999) {
+        number = -9999;
+    }
+    *value = (int)number;
+    return present;
+}
+
+static void ZLog_OutSpec(ZLogOut_t * const out, const char * const spec, ...) {
+    const size_t used = (out->len < (out->size - 1)) ? out->len : (out->size - 1);
+    va_list args;
+    int rc;
+
+    va_start(args, spec);
+    rc = vsnprintf(out->buf + used, out->size - used, spec, args); /* Flawfinder: ignore */
+        /* Warning: use of "vsnprintf" and a non-constant format
+           "Ignore" justification: spec is rebuilt by ZLog_OutBinary() from the caller's
+           format, which ZLog_BinaryCheck() has checked against these very arguments. */
+    va_end(args);
+
+    if (0 <= rc) {
+        out->len += (size_t)rc;
+    }
+}
+
+static bool ZLog_ArgNext(const unsigned char * const args, const size_t len, size_t * const pos,
+                         ZLogArg_t * const arg) {
+    const bool ok0 = (*pos < len);
+    const size_t left = ok0 ? (len - *pos - 1) : 0;
+    const unsigned char * const value = ok0 ? &args[*pos + 1] : args;
+    size_t size = 0;
+    bool ok = ok0;
+
+    memset(arg, 0, sizeof(*arg));
+    if (ok) {
+        arg->type = (ZLogArgType_t)args[*pos];
+        switch (arg->type) {
+            case Z_ARG_INT:
+            case Z_ARG_UINT: {
+                int v = 0;
+                size = sizeof(v);
+                if (size <= left) {
+                    memcpy(&v, value, size);
+                }
+                arg->s = (Z_ARG_INT == arg->type) ? v : (long long)(unsigned)v;
+                arg->u = (unsigned)v;
+                break;
+            }
+
+            case Z_ARG_LLONG:
+            case Z_ARG_ULLONG: {
+                long long v = 0;
+                size = sizeof(v);
+                if (size <= left) {
+                    memcpy(&v, value, size);
+                }
+                arg->s = v;
+                arg->u = (unsigned long long)v;
+                break;
+            }
+
+            case Z_ARG_DOUBLE:
+                size = sizeof(arg->d);
+                if (size <= left) {
+                    memcpy(&arg->d, value, size);
+                }
+                break;
+
+            case Z_ARG_PTR:
+                size = sizeof(arg->p);
+                if (size <= left) {
+                    memcpy(&arg->p, value, size);
+                }
+                break;
+
+            case Z_ARG_STR: {
+                unsigned short n = 0;
+                size = sizeof(n);
+                if (size <= left) {
+                    memcpy(&n, value, size);
+                    if (0xFFFFu == n) {
+                        arg->str = "(null)";
+                        arg->strLen = 6;
+                    }
+                    else {
+                        size += n;
+                        arg->str = (const char *)value + sizeof(n);
+                        arg->strLen = n;
+                    }
+                }
+                break;
+            }
+
+            default:
+                ok = false;
+                break;
+        }
+        ok = ok && (size <= left);
+        *pos += 1 + size;
+    }
+    return ok;
+}
+
+static inline bool ZLog_ArgIsInt(const ZLogArg_t * const arg) {
+    return (Z_ARG_INT == arg->type) || (Z_ARG_UINT == arg->type) ||
+           (Z_ARG_LLONG == arg->type) || (Z_ARG_ULLONG == arg->type);
+}
+#endif /* Z_CHECK_HAS_LOGB */
+
+#ifdef Z_CHECK_HAS_CALLSITES
+/**
+ * file matches the site's full path or any trailing run of its components; NULL and line 0
+ * match anything. Hand-rolled so freestanding builds need nothing from libc.
+ */
+static bool ZLog_CallsiteMatches(const ZLogCallsite_t * const site, const char * const file,
+                                 const int line) {
+    bool matches = (NULL == file);
+    const char *start;
+
+    for (start = site->file; !matches && (NULL != start); ) {
+        const char *a = start;
+        const char *b = file;
+
+        for (; ('\0' != *a) && (*a == *b); a++, b++) {
+        }
+        matches = ('\0' == *a) && ('\0' == *b);
+        for (; ('\0' != *start) && ('/' != *start); start++) {
+        }
+        start = ('/' == *start) ? (start + 1) : NULL;
+    }
+    return matches && ((0 == line) || (line == site->line));
+}
+#endif /* Z_CHECK_HAS_CALLSITES */
+
+#if defined(Z_CHECK_HAS_LOG_COST) || defined(Z_CHECK_HAS_TIMING)
+/* What __FILENAME__ makes of a __FILE__ stored in a site; by hand, for freestanding builds */
+static const char * ZLog_BaseName(const char * const path) {
+    const char *base = path;
+    const char *c;
+
+    for (c = path; '\0' != *c; c++) {
+        if ('/' == *c) {
+            base = c + 1;
+        }
+    }
+    return base;
+}
+#endif
+
+#ifdef Z_CHECK_HAS_LOG_COST
+/* [n] for n < 4, then four buckets per power of two, split by the two bits below the top one */
+static inline unsigned ZLog_CostBucket(const unsigned long long cycles) {
+    unsigned bucket = (unsigned)cycles;
+
+    if (4u <= cycles) {
+        const unsigned top = 63u - (unsigned)__builtin_clzll(cycles);
+
+        bucket = (4u * (top - 1u)) + (unsigned)((cycles >> (top - 2u)) & 3u);
+    }
+    return (bucket < Z_CHECK_LOG_COST_BUCKETS) ? bucket : (Z_CHECK_LOG_COST_BUCKETS - 1u);
+}
+
+/* Fewest cycles that land in the bucket */
+static inline unsigned long long ZLog_CostBucketFloor(const unsigned bucket) {
+    return (4u > bucket) ? bucket
+                         : ((4ull | (bucket & 3u)) << ((bucket / 4u) - 1u));
+}
+
+static unsigned long long ZLog_CostPercentile(const ZLogCost_t * const cost,
+                                              const unsigned long calls, const unsigned percent) {
+    const unsigned long long rank = (((unsigned long long)calls * percent) + 99u) / 100u;
+    unsigned long long seen = 0;
+    unsigned i;
+
+    for (i = 0; i < (Z_CHECK_LOG_COST_BUCKETS - 1u); i++) {
+        seen += __atomic_load_n(&cost->buckets[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            break;
+        }
+    }
+    return ZLog_CostBucketFloor(i);
+}
+
+/**
+ * The timed site with the most cycles after the given one, in order of cycles and then
+ * address; NULL after the last. Walking the registry once per rank keeps the report free of
+ * allocation.
+ */
+static const ZLogCallsite_t * ZLog_CostNext(const ZLogCallsite_t * const after) {
+    const unsigned long long limit =
+        (NULL != after) ? __atomic_load_n(&after->cost->cycles, __ATOMIC_RELAXED) : ~0ull;
+    const ZLogCallsite_t *best = NULL;
+    unsigned long long bestCycles = 0;
+    const ZLogCallsite_t *site;
+
+    for (site = __atomic_load_n(&m_callsites, __ATOMIC_ACQUIRE); NULL != site; site = site->next) {
+        const unsigned long long cycles =
+            (NULL != site->cost) ? __atomic_load_n(&site->cost->cycles, __ATOMIC_RELAXED) : 0;
+        const bool belowAfter = (NULL == after) || (cycles < limit) ||
+                                ((cycles == limit) && (site < after));
+        const bool aboveBest = (NULL == best) || (cycles > bestCycles) ||
+                               ((cycles == bestCycles) && (site > best));
+
+        if ((0 != cycles) && (0 != __atomic_load_n(&site->cost->calls, __ATOMIC_RELAXED)) &&
+            belowAfter && aboveBest) {
+            best = site;
+            bestCycles = cycles;
+        }
+    }
+    return best;
+}
+#endif /* Z_CHECK_HAS_LOG_COST */
+
+#ifdef Z_CHECK_HAS_TIMING
+static void ZLog_TimeRegister(ZLogTimeSite_t * const site) {
+    int state = 0;
+
+    /* as ZLog_CallsiteRegister(), without rules to apply */
+    if (__atomic_compare_exchange_n(&site->state, &state, 1, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        ZLogTimeSite_t *head = __atomic_load_n(&m_timeSites, __ATOMIC_RELAXED);
+
+        do {
+            site->next = head;
+        } while (!__atomic_compare_exchange_n(&m_timeSites, &head, site, true, __ATOMIC_RELEASE,
+                                              __ATOMIC_RELAXED));
+        __atomic_store_n(&site->state, 2, __ATOMIC_RELEASE);
+    }
+}
+
+/* [0] under 1 us, then one bucket per power of two, the last one open-ended */
+static inline unsigned ZLog_TimeBucket(const unsigned long us) {
+    const unsigned bucket =
+        (0 == us) ? 0u : ((unsigned)(sizeof(us) * 8u) - (unsigned)__builtin_clzl(us));
+
+    return (bucket < Z_CHECK_TIME_BUCKETS) ? bucket : (Z_CHECK_TIME_BUCKETS - 1u);
+}
+#endif /* Z_CHECK_HAS_TIMING */
+
+#ifdef Z_CHECK_LOGB_IDS
+static void ZLog_WriteFrame(unsigned char * const frame, const ZLogLevel_t level,
+                            const ZLogSite_t * const site, const unsigned char * const args,
+                            const size_t len) {
+    const uint32_t id = (uint32_t)(site - __start_z_check_sites);
+    unsigned char *head = frame;
+
+    if (!__atomic_exchange_n(&m_frameHeaderSent, true, __ATOMIC_RELAXED)) {
+        ZLog_WriteFrameHeader();
+    }
+    if (FRAME_ARGS_MAX >= len) {    /* always, for buffers built by Z_LOGB() */
+#ifdef Z_CHECK_HAS_THREAD_INFO
+        head += ZLog_PutThread(head);
+#endif
+#ifdef Z_CHECK_HAS_TRACE
+        head += ZLog_PutStamp(head);
+#endif
+        head[0] = FRAME_MARK;
+        head[1] = 'R';
+        head[2] = (unsigned char)level;
+        head[3] = (unsigned char)id;
+        head[4] = (unsigned char)(id >> 8);
+        head[5] = (unsigned char)(id >> 16);
+        head[6] = (unsigned char)(id >> 24);
+        head[7] = (unsigned char)len;
+        head[8] = (unsigned char)(len >> 8);
+        memcpy(&head[FRAME_HEAD], args, len);
+        WRITE_FUNC((const char *)frame, (size_t)(head - frame) + FRAME_HEAD + len);
+    }
+}
+
+/**
+ * Tell the decoder which binary the IDs belong to.
+ *
+ * Written once, before the first frame of the process. A frame from another thread may still
+ * come first; the decoder is handed the binary anyway, and only checks it against this.
+ */
+static void ZLog_WriteFrameHeader(void) {
+    unsigned char frame[4 + BUILD_ID_MAX + UINT8_MAX];
+    size_t nameLen = strlen(m_moduleName);
+    size_t len = 0;
+    size_t idLen;
+
+    if (UINT8_MAX < nameLen) {
+        nameLen = UINT8_MAX;
+    }
+    frame[len++] = FRAME_MARK;
+    frame[len++] = 'H';
+    idLen = ZLog_BuildId(&frame[len + 1]);
+    frame[len++] = (unsigned char)idLen;
+    len += idLen;
+    frame[len++] = (unsigned char)nameLen;
+    memcpy(&frame[len], m_moduleName, nameLen);
+    len += nameLen;
+    WRITE_FUNC((const char *)frame, len);
+}
+
+/* Copy out the GNU build-ID note of this module, if it was linked with one */
+static size_t ZLog_BuildId(unsigned char * const id) {
+    const unsigned char * const base = (const unsigned char *)&__ehdr_start;
+    const ELF_PHDR *phdrs;
+    uintptr_t bias = 0;
+    size_t len = 0;
+    size_t i;
+
+    if (NULL == base) {
+        return 0;
+    }
+    phdrs = (const ELF_PHDR *)(const void *)(base + __ehdr_start.e_phoff);
+    for (i = 0; i < __ehdr_start.e_phnum; i++) {
+        if ((PT_LOAD == phdrs[i].p_type) && (0 == phdrs[i].p_offset)) {
+            bias = (uintptr_t)base - (uintptr_t)phdrs[i].p_vaddr;    /* where the header is */
+        }
+    }
+    for (i = 0; i < __ehdr_start.e_phnum; i++) {
+        const size_t align = (8 == phdrs[i].p_align) ? 8 : 4;
+        const unsigned char *note = (const unsigned char *)(bias + phdrs[i].p_vaddr);
+        const unsigned char * const end = note + phdrs[i].p_memsz;
+
+        while ((PT_NOTE == phdrs[i].p_type) && (note < end) &&
+               ((size_t)(end - note) >= sizeof(ELF_NHDR))) {
+            ELF_NHDR nhdr;
+            const unsigned char *desc;
+
+            memcpy(&nhdr, note, sizeof(nhdr));
+            desc = note + sizeof(nhdr) + NOTE_ALIGN(nhdr.n_namesz, align);
+            if ((desc > end) || (nhdr.n_descsz > (size_t)(end - desc))) {
+                break;
+            }
+            if ((NT_GNU_BUILD_ID == nhdr.n_type) && (4 == nhdr.n_namesz) &&
+                (0 == memcmp(note + sizeof(nhdr), "GNU", 4))) {
+                len = (BUILD_ID_MAX < nhdr.n_descsz) ? BUILD_ID_MAX : nhdr.n_descsz;
+                memcpy(id, desc, len);
+            }
+            note = desc + NOTE_ALIGN(nhdr.n_descsz, align);
+        }
+    }
+    return len;
+}
+#endif /* Z_CHECK_LOGB_IDS */
+
+#ifdef Z_CHECK_HAS_TRACE
+static void ZLog_WriteSpan(const char kind, const ZLogSite_t * const site) {
+    const uint32_t id = (uint32_t)(site - __start_z_check_sites);
+    unsigned char frame[FRAME_THREAD + FRAME_STAMP + FRAME_SPAN];
+    size_t len = 0;
+
+    if (!__atomic_exchange_n(&m_frameHeaderSent, true, __ATOMIC_RELAXED)) {
+        ZLog_WriteFrameHeader();
+    }
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    len += ZLog_PutThread(frame);
+#endif
+    len += ZLog_PutStamp(&frame[len]);
+    frame[len++] = FRAME_MARK;
+    frame[len++] = (unsigned char)kind;
+    frame[len++] = (unsigned char)id;
+    frame[len++] = (unsigned char)(id >> 8);
+    frame[len++] = (unsigned char)(id >> 16);
+    frame[len++] = (unsigned char)(id >> 24);
+    WRITE_FUNC((const char *)frame, len);
+}
+
+/* Stamp frame for the unit that follows it in the same write */
+static size_t ZLog_PutStamp(unsigned char * const frame) {
+    ZLogStamp_t stamp;
+    unsigned i;
+
+    ZLog_StampGet(&stamp);
+    frame[0] = FRAME_MARK;
+    frame[1] = 'T';
+    for (i = 0; i < 4; i++) {
+        frame[2 + i] = (unsigned char)(stamp.thread >> (8 * i));
+    }
+    for (i = 0; i < 8; i++) {
+        frame[6 + i] = (unsigned char)(stamp.ns >> (8 * i));
+    }
+    return FRAME_STAMP;
+}
+
+static void ZLog_OutStamp(ZLogOut_t * const out) {
+    unsigned char stamp[FRAME_STAMP];
+    size_t i;
+
+    (void)ZLog_PutStamp(stamp);
+    for (i = 0; i < sizeof(stamp); i++) {
+        ZLog_OutChar(out, (char)stamp[i]);
+    }
+}
+
+static void ZLog_StampGet(ZLogStamp_t * const stamp) {
+#ifdef Z_CHECK_HAS_ASYNC
+    if (NULL != m_sinkStamp) {
+        /* writing a queued record: it carries its own */
+        *stamp = *m_sinkStamp;
+    }
+    else
+#endif
+    {
+#ifdef Z_CHECK_HAS_THREAD_INFO
+        stamp->thread = ZLog_ThreadSelf()->tid;
+#else
+        if (0 == m_thread) {
+            m_thread = __atomic_add_fetch(&m_threadCount, 1, __ATOMIC_RELAXED);
+        }
+        stamp->thread = m_thread;
+#endif
+        stamp->ns = ZLog_TimeNow();
+    }
+}
+#endif /* Z_CHECK_HAS_TRACE */
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+static inline ZLogThread_t * ZLog_ThreadSelf(void) {
+    if (!m_threadInfo.loaded) {
+        ZLog_ThreadLoad(NULL);
+    }
+    return &m_threadInfo;
+}
+
+/* The thread whose line is being written, which on the writer thread or the ring's drainer is
+ * the one that logged it */
+static inline const ZLogThread_t * ZLog_ThreadGet(void) {
+#if defined(Z_CHECK_HAS_ASYNC) || defined(Z_CHECK_HAS_SHARED_RING)
+    if (NULL != m_sinkThread) {
+        return m_sinkThread;
+    }
+#endif
+    return ZLog_ThreadSelf();
+}
+
+/**
+ * Ask the kernel who the calling thread is, or take the name given.
+ *
+ * /proc/thread-self links to "<pid>/task/<tid>", which gives the ID through readlink(), a POSIX
+ * call, where gettid() would need _GNU_SOURCE.
+ */
+static void ZLog_ThreadLoad(const char * const name) {
+    char link[64]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: readlink() is given one byte less than its size. */
+    const ssize_t len = readlink("/proc/thread-self", link, sizeof(link) - 1); /* Flawfinder: ignore */
+        /* Warning: readlink() does not terminate and races with the link changing
+           "Ignore" justification: terminated below, and the link is the kernel's own. */
+    const char *c = link;
+    unsigned long tid = 0;
+
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+    if (0 < len) {
+        link[len] = '\0';
+        if (NULL != strrchr(link, '/')) {
+            c = strrchr(link, '/') + 1;
+        }
+        for (; ('0' <= *c) && ('9' >= *c); c++) {
+            tid = (tid * 10u) + (unsigned long)(*c - '0');
+        }
+    }
+    m_threadInfo.tid = (uint32_t)tid;
+
+    memset(m_threadInfo.name, 0, sizeof(m_threadInfo.name));
+    if (NULL != name) {
+        strncpy(m_threadInfo.name, name, sizeof(m_threadInfo.name) - 1); /* Flawfinder: ignore */
+            /* Warning: strncpy() may leave the string unterminated
+               "Ignore" justification: the last byte was zeroed above and is not written. */
+    }
+#ifdef __linux__
+    else if (0 != prctl(PR_GET_NAME, m_threadInfo.name)) {
+        m_threadInfo.name[0] = '\0';
+    }
+#endif
+    m_threadInfo.name[sizeof(m_threadInfo.name) - 1] = '\0';
+    m_threadInfo.named = false;
+    m_threadInfo.loaded = true;
+}
+
+/* The child's one thread has a new ID; read it again on its next record */
+static void ZLog_ThreadForkChild(void) {
+    m_threadInfo.loaded = false;
+}
+
+#ifdef Z_CHECK_LOGB_IDS
+/**
+ * Thread frame for the unit that follows it in the same write.
+ *
+ * The name goes with the thread's first unit and again after a rename. Trace stamps carry the ID
+ * anyway; without them every record needs it, so the frame goes out each time, with no name.
+ */
+static size_t ZLog_PutThread(unsigned char * const frame) {
+    const ZLogThread_t * const thread = ZLog_ThreadGet();
+    const size_t nameLen = thread->named ? 0 : strlen(thread->name);
+    unsigned i;
+
+#ifdef Z_CHECK_HAS_TRACE
+    if (thread->named) {
+        return 0;
+    }
+#endif
+    frame[0] = FRAME_MARK;
+    frame[1] = 'N';
+    for (i = 0; i < 4; i++) {
+        frame[2 + i] = (unsigned char)(thread->tid >> (8 * i));
+    }
+    frame[6] = (unsigned char)nameLen;
+    memcpy(&frame[7], thread->name, nameLen);
+    if (thread == &m_threadInfo) {
+        m_threadInfo.named = true;
+    }
+    return 7 + nameLen;
+}
+#endif /* Z_CHECK_LOGB_IDS */
+#endif /* Z_CHECK_HAS_THREAD_INFO */
+
+#ifdef FORK_HANDLERS
+/* On the first start of any part that needs them, once for the process and its children */
+static void ZLog_ForkInit(void) {
+    (void)pthread_atfork(ZLog_ForkPrepare, ZLog_ForkParent, ZLog_ForkChild);
+}
+
+/* The locks are held across fork() so the child never inherits one locked by a thread it
+ * doesn't have; each part's child reset releases its own */
+static void ZLog_ForkPrepare(void) {
+#ifdef NET_SINK
+    ZLog_NetForkPrepare();
+#endif
+#ifdef DIRECT_SINK
+    ZLog_DirectForkPrepare();
+#endif
+#ifdef SPOOL_SINK
+    ZLog_SpoolForkPrepare();
+#endif
+#ifdef Z_CHECK_HAS_ASYNC
+    (void)pthread_mutex_lock(&m_writerLock);
+#endif
+}
+
+static void ZLog_ForkParent(void) {
+#ifdef Z_CHECK_HAS_ASYNC
+    (void)pthread_mutex_unlock(&m_writerLock);
+#endif
+#ifdef SPOOL_SINK
+    ZLog_SpoolForkParent();
+#endif
+#ifdef DIRECT_SINK
+    ZLog_DirectForkParent();
+#endif
+#ifdef NET_SINK
+    ZLog_NetForkParent();
+#endif
+}
+
+static void ZLog_ForkChild(void) {
+#ifdef Z_CHECK_HAS_ASYNC
+    ZLog_AsyncForkChild();
+#endif
+#ifdef SPOOL_SINK
+    ZLog_SpoolForkChild();
+#endif
+#ifdef DIRECT_SINK
+    ZLog_DirectForkChild();
+#endif
+#ifdef NET_SINK
+    ZLog_NetForkChild();
+#endif
+#ifdef Z_CHECK_HAS_SHARED_RING
+    ZLog_RingForkChild();
+#endif
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    ZLog_ThreadForkChild();
+#endif
+}
+#endif /* FORK_HANDLERS */
+
+
+/******************************************************************************
+ *                                                                   Net sink */
+#ifdef NET_SINK
+    #define NET_HEADER 16       /* length, pid, sequence number */
+    #define NET_NS_PER_MS 1000000ull
+    #define NET_EXIT_MS 1000    /* longest exit waits for the collector to take what is left */
+
+#ifdef Z_CHECK_FREESTANDING
+    #error "Z_NET sends with sockets, which freestanding Z_CHECK does not assume"
+#endif
+    Z_CT_ASSERT_DECL(Z_CHECK_NET_SPOOL >= Z_CHECK_NET_BATCH + 16);
+
+static void ZLog_NetLinger(const unsigned long long now);
+static void ZLog_NetStart(void);
+static void ZLog_NetSeal(const char * const lines, const size_t len);
+static inline size_t ZLog_NetFrameLen(const size_t at) PURE_FUNC;
+static void ZLog_NetPump(const unsigned long long now);
+static void ZLog_NetConnect(const unsigned long long now);
+static void ZLog_NetFail(const unsigned long long now);
+
+    /* Everything below is under m_netLock. Lines gather in m_netBatch; sealed frames queue in
+     * m_netSpool from m_netHead to m_netTail, of which m_netSentOff bytes have gone out. */
+    static pthread_mutex_t m_netLock = PTHREAD_MUTEX_INITIALIZER;
+    static char m_netBatch[Z_CHECK_NET_BATCH]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_NetWrite() only appends lines that fit. */
+    static size_t m_netBatchLen = 0;
+    static unsigned long long m_netBatchAt = 0;     /* when the batch's first line came */
+    static char m_netSpool[Z_CHECK_NET_SPOOL]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_NetSeal() only appends frames that fit. */
+    static size_t m_netHead = 0;
+    static size_t m_netTail = 0;
+    static size_t m_netSentOff = 0;
+    static int m_netFd = -1;
+    static bool m_netConnecting = false;
+    static bool m_netStarted = false;
+    static unsigned long long m_netRetryAt = 0;
+    static unsigned long m_netBackoffMs = Z_CHECK_NET_RETRY_MS;
+    static uint32_t m_netPid = 0;
+    static ZLogNetStats_t m_netStats = {0};
+
+void ZLog_NetStatsGet(ZLogNetStats_t * const stats) {
+    (void)pthread_mutex_lock(&m_netLock);
+    *stats = m_netStats;
+    stats->spooled = (unsigned long)(m_netTail - m_netHead);
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+
+/* Lines join the batch until the next won't fit or the first has waited Z_CHECK_NET_LINGER_MS;
+ * a line longer than a whole batch goes out as a frame of its own. */
+static void ZLog_NetWrite(const char * const buf, const size_t len) {
+    unsigned long long now;
+
+    (void)pthread_mutex_lock(&m_netLock);
+    if (!m_netStarted) {
+        ZLog_NetStart();
+    }
+    now = ZLog_TimeNow();
+    m_netStats.lines++;
+    if (len > (Z_CHECK_NET_BATCH - m_netBatchLen)) {
+        ZLog_NetSeal(m_netBatch, m_netBatchLen);
+        m_netBatchLen = 0;
+    }
+    if (len > Z_CHECK_NET_BATCH) {
+        ZLog_NetSeal(buf, len);
+    }
+    else {
+        if (0 == m_netBatchLen) {
+            m_netBatchAt = now;
+        }
+        memcpy(&m_netBatch[m_netBatchLen], buf, len);
+        m_netBatchLen += len;
+    }
+    ZLog_NetLinger(now);
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+
+/* Seal what has gathered and send what the socket takes without waiting */
+static void ZLog_NetFlush(void) {
+    (void)pthread_mutex_lock(&m_netLock);
+    ZLog_NetSeal(m_netBatch, m_netBatchLen);
+    m_netBatchLen = 0;
+    ZLog_NetPump(ZLog_TimeNow());
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_NetIdle(void) {
+    (void)pthread_mutex_lock(&m_netLock);
+    ZLog_NetLinger(ZLog_TimeNow());
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+#endif
+
+/* Seal the batch if its first line has waited long enough, then send */
+static void ZLog_NetLinger(const unsigned long long now) {
+    if ((0 != m_netBatchLen) &&
+        ((now - m_netBatchAt) >= (Z_CHECK_NET_LINGER_MS * NET_NS_PER_MS))) {
+        ZLog_NetSeal(m_netBatch, m_netBatchLen);
+        m_netBatchLen = 0;
+    }
+    ZLog_NetPump(now);
+}
+
+/* Give the collector up to NET_EXIT_MS to take the rest, unless the next retry is later */
+static void ZLog_NetExit(void) {
+    unsigned long long now;
+    unsigned long long until;
+
+    (void)pthread_mutex_lock(&m_netLock);
+    ZLog_NetSeal(m_netBatch, m_netBatchLen);
+    m_netBatchLen = 0;
+    now = ZLog_TimeNow();
+    until = now + (NET_EXIT_MS * NET_NS_PER_MS);
+    ZLog_NetPump(now);
+    while ((m_netHead != m_netTail) && (now < until) &&
+           ((-1 != m_netFd) || (m_netRetryAt < until))) {
+        struct pollfd wait = { m_netFd, POLLOUT, 0 };
+
+        (void)poll(&wait, (-1 != m_netFd) ? 1u : 0u, 10);
+        now = ZLog_TimeNow();
+        ZLog_NetPump(now);
+    }
+    if (-1 != m_netFd) {
+        (void)close(m_netFd);
+        m_netFd = -1;
+    }
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+
+/* With Z_CHECK_HAS_ASYNC, ZLog_AsyncStop() calls ZLog_NetExit() once the queue is empty */
+static void ZLog_NetStart(void) {
+    m_netStarted = true;
+    m_netPid = (uint32_t)getpid();
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+#ifndef Z_CHECK_HAS_ASYNC
+    (void)atexit(ZLog_NetExit);
+#endif
+}
+
+/* A frame that won't fit the spool is dropped, leaving a gap in the sequence numbers */
+static void ZLog_NetSeal(const char * const lines, const size_t len) {
+    const size_t frameLen = NET_HEADER + len;
+    uint64_t sequence;
+    char *frame;
+    unsigned i;
+
+    if (0 == len) {
+        return;
+    }
+    sequence = m_netStats.frames++;
+    if ((frameLen > (Z_CHECK_NET_SPOOL - m_netTail)) && (0 != m_netHead)) {
+        memmove(m_netSpool, &m_netSpool[m_netHead], m_netTail - m_netHead);
+        m_netTail -= m_netHead;
+        m_netHead = 0;
+    }
+    if (frameLen > (Z_CHECK_NET_SPOOL - m_netTail)) {
+        m_netStats.dropped++;
+        return;
+    }
+    frame = &m_netSpool[m_netTail];
+    for (i = 0; i < 4; i++) {
+        frame[i] = (char)((frameLen - 4) >> (24 - (8 * i)));
+        frame[4 + i] = (char)(m_netPid >> (24 - (8 * i)));
+    }
+    for (i = 0; i < 8; i++) {
+        frame[8 + i] = (char)(sequence >> (56 - (8 * i)));
+    }
+    memcpy(&frame[NET_HEADER], lines, len);
+    m_netTail += frameLen;
+}
+
+/* Send from the spool until it is empty or the socket would block. TCP takes the spool as one
+ * stream, UDP a frame per datagram; only whole frames count as sent. */
+static void ZLog_NetPump(const unsigned long long now) {
+    if (-1 == m_netFd) {
+        ZLog_NetConnect(now);
+    }
+    if (m_netConnecting) {
+        struct pollfd ready = { m_netFd, POLLOUT, 0 };
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+
+        if (0 == poll(&ready, 1, 0)) {
+            return;
+        }
+        if ((0 != getsockopt(m_netFd, SOL_SOCKET, SO_ERROR, &error, &errorLen)) || (0 != error)) {
+            ZLog_NetFail(now);
+            return;
+        }
+        m_netConnecting = false;
+        m_netBackoffMs = Z_CHECK_NET_RETRY_MS;
+        m_netStats.connects++;
+    }
+    while ((-1 != m_netFd) && (m_netHead != m_netTail)) {
+        const size_t frameLen = ZLog_NetFrameLen(m_netHead);
+        const size_t want = Z_CHECK_NET_UDP ? frameLen : (m_netTail - m_netHead - m_netSentOff);
+        const ssize_t sent = send(m_netFd, &m_netSpool[m_netHead + m_netSentOff], want,
+                                  MSG_NOSIGNAL);
+
+        if (0 > sent) {
+            if (EAGAIN == errno) {  /* EWOULDBLOCK too, on Linux */
+                break;
+            }
+            if (EMSGSIZE == errno) {
+                m_netHead += frameLen;      /* too big for any datagram; counts as a gap */
+                m_netStats.dropped++;
+            }
+            else if (EINTR != errno) {
+                ZLog_NetFail(now);
+            }
+            continue;
+        }
+        m_netSentOff += (size_t)sent;
+        while ((m_netHead != m_netTail) && (ZLog_NetFrameLen(m_netHead) <= m_netSentOff)) {
+            m_netSentOff -= ZLog_NetFrameLen(m_netHead);
+            m_netHead += ZLog_NetFrameLen(m_netHead);
+            m_netStats.sent++;
+        }
+    }
+    if (m_netHead == m_netTail) {
+        m_netHead = 0;
+        m_netTail = 0;
+    }
+}
+
+/* The whole frame at m_netSpool[at], its length field included */
+static inline size_t ZLog_NetFrameLen(const size_t at) {
+    const unsigned char * const frame = (const unsigned char *)&m_netSpool[at];
+
+    return 4 + (((size_t)frame[0] << 24) | ((size_t)frame[1] << 16) | ((size_t)frame[2] << 8) |
+                (size_t)frame[3]);
+}
+
+static void ZLog_NetConnect(const unsigned long long now) {
+    struct sockaddr_in addr;
+
+    if (now < m_netRetryAt) {
+        return;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(Z_CHECK_NET_PORT);
+    if (1 != inet_pton(AF_INET, Z_CHECK_NET_ADDR, &addr.sin_addr)) {
+        m_netRetryAt = ~0ull;   /* not an address; this will never connect */
+        return;
+    }
+    m_netFd = socket(AF_INET, Z_CHECK_NET_UDP ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (-1 == m_netFd) {
+        ZLog_NetFail(now);
+        return;
+    }
+    (void)fcntl(m_netFd, F_SETFD, FD_CLOEXEC);
+    (void)fcntl(m_netFd, F_SETFL, fcntl(m_netFd, F_GETFL) | O_NONBLOCK);
+    if (0 == connect(m_netFd, (const struct sockaddr *)&addr, sizeof(addr))) {
+        m_netBackoffMs = Z_CHECK_NET_RETRY_MS;
+        m_netStats.connects++;
+    }
+    else if (EINPROGRESS == errno) {
+        m_netConnecting = true;
+    }
+    else {
+        ZLog_NetFail(now);
+    }
+}
+
+/* Drop the connection and wait before the next; a frame partly sent goes again whole */
+static void ZLog_NetFail(const unsigned long long now) {
+    if (-1 != m_netFd) {
+        (void)close(m_netFd);
+        m_netFd = -1;
+    }
+    m_netConnecting = false;
+    m_netSentOff = 0;
+    m_netStats.failures++;
+    m_netRetryAt = now + (m_netBackoffMs * NET_NS_PER_MS);
+    m_netBackoffMs = ((2 * m_netBackoffMs) < Z_CHECK_NET_RETRY_MAX_MS) ? (2 * m_netBackoffMs)
+                                                                       : Z_CHECK_NET_RETRY_MAX_MS;
+}
+
+/* The lock is held across fork(), as ZLog_ForkPrepare() holds the others */
+static void ZLog_NetForkPrepare(void) {
+    (void)pthread_mutex_lock(&m_netLock);
+}
+
+static void ZLog_NetForkParent(void) {
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+
+/* What is batched and spooled is the parent's to send. The child connects on its own, under
+ * its own pid, numbering its frames from 0. */
+static void ZLog_NetForkChild(void) {
+    if (-1 != m_netFd) {
+        (void)close(m_netFd);
+        m_netFd = -1;
+    }
+    m_netConnecting = false;
+    m_netBatchLen = 0;
+    m_netHead = 0;
+    m_netTail = 0;
+    m_netSentOff = 0;
+    m_netRetryAt = 0;
+    m_netBackoffMs = Z_CHECK_NET_RETRY_MS;
+    m_netPid = (uint32_t)getpid();
+    memset(&m_netStats, 0, sizeof(m_netStats));
+    (void)pthread_mutex_unlock(&m_netLock);
+}
+#endif /* NET_SINK */
+
+
+/******************************************************************************
+ *                                                               Journal sink */
+#ifdef JOURNAL_SINK
+    #define JOURNAL_NAME_MAX 200    /* longest module, file or function name sent */
+    /* The fields ahead of the message, up to the message's binary length */
+    #define JOURNAL_HEAD_MAX (128 + (3 * JOURNAL_NAME_MAX) + 64)
+    #if defined(_GNU_SOURCE) && defined(__linux__)
+    #define JOURNAL_GNU             /* memfd_create(), its seals and sendmmsg() are declared */
+    #endif
+
+/* One journal entry: the text fields and the message's binary length in head, then the
+ * message and its closing newline in place */
+typedef struct ZLogJournalEntry_s
+{
+    char head[JOURNAL_HEAD_MAX];
+    struct iovec iov[3];
+    size_t len;                 /* of all three */
+} ZLogJournalEntry_t;
+
+#ifdef Z_CHECK_FREESTANDING
+    #error "Z_JOURNAL sends with sockets, which freestanding Z_CHECK does not assume"
+#endif
+    Z_CT_ASSERT_DECL(Z_CHECK_JOURNAL_BATCH > 0);
+    Z_CT_ASSERT_DECL(sizeof(Z_CHECK_JOURNAL_SOCKET) <= sizeof(((struct sockaddr_un *)0)->sun_path));
+
+static void ZLog_JournalEntry(ZLogJournalEntry_t * const entry, const ZLogLevel_t level,
+                              const char * const file, const int line, const char * const func,
+                              const char * const message);
+static void ZLog_JournalSend(const struct iovec * const iov, const size_t count,
+                             const size_t len);
+static bool ZLog_JournalMemfd(const int sock, const struct iovec * const iov, const size_t count,
+                              const size_t len);
+static int ZLog_JournalSocket(void);
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_JournalGather(const ZLogJournalEntry_t * const entry);
+#endif
+
+    static const struct sockaddr_un m_journalAddr = {
+        .sun_family = AF_UNIX, .sun_path = Z_CHECK_JOURNAL_SOCKET
+    };
+    static int m_journalFd = -1;        /* opened on the first entry */
+    static ZLogJournalStats_t m_journalStats = {0};
+    #ifdef Z_CHECK_HAS_ASYNC
+    /* Entries the writer thread has gathered, end to end, until the queue runs dry */
+    static THREAD_LOCAL bool m_journalWriter = false;   /* true on the writer thread */
+    static char m_journalBatch[Z_CHECK_JOURNAL_BATCH_BYTES]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_JournalGather() only copies in entries that fit. */
+    static size_t m_journalBatchLen[Z_CHECK_JOURNAL_BATCH];
+    static unsigned m_journalBatchCount = 0;    /* written by the writer only */
+    static size_t m_journalBatchUsed = 0;
+    #endif
+    #ifndef JOURNAL_GNU
+    static unsigned long m_journalMemfdCount = 0;   /* names the shm_open() files */
+    #endif
+
+void ZLog_JournalStatsGet(ZLogJournalStats_t * const stats) {
+    stats->entries = __atomic_load_n(&m_journalStats.entries, __ATOMIC_RELAXED);
+    stats->sent = __atomic_load_n(&m_journalStats.sent, __ATOMIC_RELAXED);
+    stats->memfds = __atomic_load_n(&m_journalStats.memfds, __ATOMIC_RELAXED);
+    stats->batches = __atomic_load_n(&m_journalStats.batches, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&m_journalStats.dropped, __ATOMIC_RELAXED);
+}
+
+static void ZLog_Journal(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const message) {
+    ZLogJournalEntry_t entry;
+
+    ZLog_JournalEntry(&entry, level, file, line, func, message);
+    (void)__atomic_fetch_add(&m_journalStats.entries, 1, __ATOMIC_RELAXED);
+#ifdef Z_CHECK_HAS_ASYNC
+    if (m_journalWriter) {
+        ZLog_JournalGather(&entry);
+        return;
+    }
+#endif
+    ZLog_JournalSend(entry.iov, 3, entry.len);
+}
+
+/* Text fields can't hold a newline, so the message goes in the binary form: its name, a
+ * newline, its length as 64-bit little-endian, itself and a newline */
+static void ZLog_JournalEntry(ZLogJournalEntry_t * const entry, const ZLogLevel_t level,
+                              const char * const file, const int line, const char * const func,
+                              const char * const message) {
+    static const char newline[] = "\n";
+    const size_t len = strlen(message);
+    size_t used;
+    unsigned i;
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    const ZLogThread_t * const thread = ZLog_ThreadGet();
+
+    used = (size_t)snprintf(entry->head, JOURNAL_HEAD_MAX - 16,
+                            "PRIORITY=%d\nSYSLOG_IDENTIFIER=%.*s\nCODE_FILE=%.*s\nCODE_LINE=%d\n"
+                            "CODE_FUNC=%.*s\nTID=%lu\nTHREAD_NAME=%s\nMESSAGE\n", (int)level,
+                            JOURNAL_NAME_MAX, m_moduleName, JOURNAL_NAME_MAX, file, line,
+                            JOURNAL_NAME_MAX, func, (unsigned long)thread->tid, thread->name);
+#else
+    used = (size_t)snprintf(entry->head, JOURNAL_HEAD_MAX - 16,
+                            "PRIORITY=%d\nSYSLOG_IDENTIFIER=%.*s\nCODE_FILE=%.*s\nCODE_LINE=%d\n"
+                            "CODE_FUNC=%.*s\nMESSAGE\n", (int)level, JOURNAL_NAME_MAX,
+                            m_moduleName, JOURNAL_NAME_MAX, file, line, JOURNAL_NAME_MAX, func);
+#endif
+    for (i = 0; i < 8; i++) {
+        entry->head[used + i] = (char)((uint64_t)len >> (8 * i));
+    }
+    used += 8;
+
+    entry->iov[0].iov_base = entry->head;
+    entry->iov[0].iov_len = used;
+    entry->iov[1].iov_base = (void *)message;
+    entry->iov[1].iov_len = len;
+    entry->iov[2].iov_base = (void *)newline;
+    entry->iov[2].iov_len = 1;
+    entry->len = used + len + 1;
+}
+
+/* One entry, as a datagram if it may and the socket takes it, otherwise in a memory file */
+static void ZLog_JournalSend(const struct iovec * const iov, const size_t count,
+                             const size_t len) {
+    const int sock = ZLog_JournalSocket();
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void *)&m_journalAddr;
+    msg.msg_namelen = sizeof(m_journalAddr);
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = count;
+
+    if (-1 == sock) {
+        (void)__atomic_fetch_add(&m_journalStats.dropped, 1, __ATOMIC_RELAXED);
+    }
+    else if (((0 == Z_CHECK_JOURNAL_MEMFD_OVER) || (len <= Z_CHECK_JOURNAL_MEMFD_OVER)) &&
+             (0 <= sendmsg(sock, &msg, MSG_NOSIGNAL))) {
+        (void)__atomic_fetch_add(&m_journalStats.sent, 1, __ATOMIC_RELAXED);
+    }
+    else if (((0 != Z_CHECK_JOURNAL_MEMFD_OVER) && (len > Z_CHECK_JOURNAL_MEMFD_OVER)) ||
+             (EMSGSIZE == errno) || (ENOBUFS == errno)) {
+        const bool sent = ZLog_JournalMemfd(sock, iov, count, len);
+
+        (void)__atomic_fetch_add(sent ? &m_journalStats.sent : &m_journalStats.dropped, 1,
+                                 __ATOMIC_RELAXED);
+        (void)__atomic_fetch_add(&m_journalStats.memfds, sent ? 1 : 0, __ATOMIC_RELAXED);
+    }
+    else {
+        (void)__atomic_fetch_add(&m_journalStats.dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* The entry goes in a file in memory, and the datagram carries only its descriptor. journald
+ * wants a sealed memfd, or a file on tmpfs, which is where shm_open() puts them. */
+static bool ZLog_JournalMemfd(const int sock, const struct iovec * const iov, const size_t count,
+                              const size_t len) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    bool sent;
+    int fd;
+
+#ifdef JOURNAL_GNU
+    fd = memfd_create("z_check-journal", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    {
+        char name[64]; /* Flawfinder: ignore */
+            /* Warning: Statically-sized array
+               "Ignore" justification: snprintf() is bounded by sizeof(name). */
+        (void)snprintf(name, sizeof(name), "/z_check-journal-%lu-%lu", (unsigned long)getpid(),
+                       __atomic_fetch_add(&m_journalMemfdCount, 1, __ATOMIC_RELAXED));
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (-1 != fd) {
+            (void)shm_unlink(name);
+        }
+    }
+#endif
+    if (-1 == fd) {
+        return false;
+    }
+    if ((ssize_t)len != writev(fd, iov, (int)count)) {
+        (void)close(fd);
+        return false;
+    }
+#ifdef JOURNAL_GNU
+    (void)fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+#endif
+
+    memset(&control, 0, sizeof(control));
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void *)&m_journalAddr;
+    msg.msg_namelen = sizeof(m_journalAddr);
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    sent = (0 <= sendmsg(sock, &msg, MSG_NOSIGNAL));
+    (void)close(fd);
+    return sent;
+}
+
+static int ZLog_JournalSocket(void) {
+    int sock = __atomic_load_n(&m_journalFd, __ATOMIC_ACQUIRE);
+
+    if (-1 == sock) {
+        const int opened = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+        if (-1 == opened) {
+            return -1;
+        }
+        (void)fcntl(opened, F_SETFD, FD_CLOEXEC);
+        if (__atomic_compare_exchange_n(&m_journalFd, &sock, opened, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            sock = opened;
+        }
+        else {
+            /* another thread opened one first; sock now holds theirs */
+            (void)close(opened);
+        }
+    }
+    return sock;
+}
+
+#ifdef Z_CHECK_HAS_ASYNC
+/* Entries logged on the calling thread from now on are gathered into batches */
+static void ZLog_JournalWriterInit(void) {
+    m_journalWriter = true;
+}
+
+/* The writer has gathered entries it hasn't sent yet */
+static inline bool ZLog_JournalPending(void) {
+    return 0 != __atomic_load_n(&m_journalBatchCount, __ATOMIC_SEQ_CST);
+}
+
+/* Writer thread only. An entry too big for the batch, or bound for a memory file, goes alone. */
+static void ZLog_JournalGather(const ZLogJournalEntry_t * const entry) {
+    unsigned i;
+
+    if (entry->len > (Z_CHECK_JOURNAL_BATCH_BYTES - m_journalBatchUsed)) {
+        ZLog_JournalSendBatch();
+    }
+    if ((entry->len > Z_CHECK_JOURNAL_BATCH_BYTES) ||
+        ((0 != Z_CHECK_JOURNAL_MEMFD_OVER) && (entry->len > Z_CHECK_JOURNAL_MEMFD_OVER))) {
+        ZLog_JournalSend(entry->iov, 3, entry->len);
+        return;
+    }
+    for (i = 0; i < 3; i++) {
+        memcpy(&m_journalBatch[m_journalBatchUsed], entry->iov[i].iov_base, entry->iov[i].iov_len);
+        m_journalBatchUsed += entry->iov[i].iov_len;
+    }
+    m_journalBatchLen[m_journalBatchCount] = entry->len;
+    __atomic_store_n(&m_journalBatchCount, m_journalBatchCount + 1, __ATOMIC_SEQ_CST);
+    if (Z_CHECK_JOURNAL_BATCH == m_journalBatchCount) {
+        ZLog_JournalSendBatch();
+    }
+}
+
+/* Writer thread only, when the batch is full and when the queue runs dry, so ZLog_Flush() waits
+ * for it. An entry the socket refuses in the batch goes again alone, by memory file if need be. */
+static void ZLog_JournalSendBatch(void) {
+    struct iovec iov[Z_CHECK_JOURNAL_BATCH];
+    size_t at = 0;
+    unsigned i;
+
+    if (0 == m_journalBatchCount) {
+        return;
+    }
+    for (i = 0; i < m_journalBatchCount; i++) {
+        iov[i].iov_base = &m_journalBatch[at];
+        iov[i].iov_len = m_journalBatchLen[i];
+        at += m_journalBatchLen[i];
+    }
+    (void)__atomic_fetch_add(&m_journalStats.batches, 1, __ATOMIC_RELAXED);
+#ifdef JOURNAL_GNU
+    {
+        struct mmsghdr msgs[Z_CHECK_JOURNAL_BATCH];
+        const int sock = ZLog_JournalSocket();
+
+        memset(msgs, 0, sizeof(msgs));
+        for (i = 0; i < m_journalBatchCount; i++) {
+            msgs[i].msg_hdr.msg_name = (void *)&m_journalAddr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(m_journalAddr);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        i = 0;
+        while (i < m_journalBatchCount) {
+            const int sent = (-1 == sock) ? -1
+                           : sendmmsg(sock, &msgs[i], m_journalBatchCount - i, MSG_NOSIGNAL);
+
+            if (0 < sent) {
+                (void)__atomic_fetch_add(&m_journalStats.sent, (unsigned long)sent,
+                                         __ATOMIC_RELAXED);
+                i += (unsigned)sent;
+            }
+            else {
+                ZLog_JournalSend(&iov[i], 1, iov[i].iov_len);
+                i++;
+            }
+        }
+    }
+#else
+    for (i = 0; i < m_journalBatchCount; i++) {
+        ZLog_JournalSend(&iov[i], 1, iov[i].iov_len);
+    }
+#endif
+    m_journalBatchUsed = 0;
+    __atomic_store_n(&m_journalBatchCount, 0, __ATOMIC_SEQ_CST);
+}
+#endif /* Z_CHECK_HAS_ASYNC */
+#endif /* JOURNAL_SINK */
+
+
+/******************************************************************************
+ *                                                                Shared ring */
+#ifdef Z_CHECK_HAS_SHARED_RING
+    #define RING_SLOTS ((uint64_t)Z_CHECK_SHARED_RING_SLOTS)
+    #define RING_NAME_MAX (Z_CHECK_SHARED_RING_DATA / 4)   /* longest file or function copied */
+    #define RING_STALL_NS ((unsigned long long)Z_CHECK_SHARED_RING_STALL_MS * 1000000ull)
+    /* A slot's claim word: the low half of the position claimed, and the claiming pid, or 0 once
+     * the drainer has taken the claim from a writer that never named itself */
+    #define RING_CLAIM(pos, pid) (((uint64_t)(uint32_t)(pos) << 32) | (uint64_t)(pid))
+    #define RING_CLAIM_POS(claim) ((uint32_t)((claim) >> 32))
+    #define RING_CLAIM_PID(claim) ((uint32_t)(claim))
+
+/**
+ * A line in the shared ring, its strings end to end in data.
+ *
+ * seq says who may touch the slot (Vyukov's bounded queue): at position pos it is pos while
+ * the slot waits for a writer, pos + 1 once the line is published, and pos + slots again once
+ * the drainer is done with it. claim says who is writing it, so the drainer can tell a dead
+ * writer from a slow one.
+ */
+typedef struct ZLogRingSlot_s
+{
+    uint64_t seq;
+    uint64_t claim;             /* RING_CLAIM() */
+    int line;
+    ZLogLevel_t level;
+    uint16_t funcOff;           /* file is at 0 */
+    uint16_t messageOff;
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    ZLogThread_t thread;
+#endif
+    char data[Z_CHECK_SHARED_RING_DATA];
+} __attribute__((aligned(64))) ZLogRingSlot_t;
+
+/* The ring, mapped shared into the process that created it and every process forked after */
+typedef struct ZLogRing_s
+{
+    uint64_t head __attribute__((aligned(64)));     /* next position to claim */
+    uint64_t tail __attribute__((aligned(64)));     /* next position to drain; drainer writes */
+    uint32_t drainer;                               /* pid of the draining process, 0 for none */
+    ZLogSharedRingStats_t stats;                    /* written atomically by anyone */
+    ZLogRingSlot_t slots[Z_CHECK_SHARED_RING_SLOTS];
+} ZLogRing_t;
+
+#ifdef Z_CHECK_FREESTANDING
+    #error "Z_CHECK_HAS_SHARED_RING maps shared memory, which freestanding Z_CHECK does not assume"
+#endif
+#ifndef MAP_ANONYMOUS
+    #error "Z_CHECK_HAS_SHARED_RING needs MAP_ANONYMOUS; <sys/mman.h> has it with _DEFAULT_SOURCE"
+#endif
+#if defined(Z_CHECK_LOGB_IDS) || defined(Z_CHECK_LOW_STACK)
+    #error "The shared ring carries whole messages; drop Z_CHECK_LOGB_IDS and Z_CHECK_LOW_STACK"
+#endif
+    Z_CT_ASSERT_DECL(Z_CHECK_SHARED_RING_SLOTS > 0);
+    Z_CT_ASSERT_DECL((Z_CHECK_SHARED_RING_DATA >= 64) && (Z_CHECK_SHARED_RING_DATA <= 0xFFFF));
+
+static size_t ZLog_RingCopy(char * const dst, const char * const src, const size_t max);
+static unsigned long ZLog_RingDrain(ZLogRing_t * const ring);
+static bool ZLog_RingOwn(ZLogRing_t * const ring);
+static bool ZLog_RingRecover(ZLogRingSlot_t * const slot, const uint64_t pos);
+static bool ZLog_RingPidGone(const uint32_t pid);
+#ifdef __linux__
+static bool ZLog_RingPidDead(const uint32_t pid);
+#endif
+
+    static ZLogRing_t *m_ring = NULL;
+    static uint32_t m_ringPid = 0;      /* getpid(), refreshed in forked children */
+    /* Everything below is under m_ringLock, which keeps this process's threads from draining
+     * at once; other processes are kept out by the ring's drainer pid */
+    static pthread_mutex_t m_ringLock = PTHREAD_MUTEX_INITIALIZER;
+    static uint64_t m_ringStallPos = 0;
+    static unsigned long long m_ringStallAt = 0;    /* when m_ringStallPos was first seen stuck */
+
+int ZLog_SharedRingCreate(void) {
+    ZLogRing_t *ring;
+    int err;
+    uint64_t i;
+
+    (void)pthread_mutex_lock(&m_ringLock);
+    if (NULL != m_ring) {
+        (void)pthread_mutex_unlock(&m_ringLock);
+        return 0;
+    }
+    /* anonymous, so forked children inherit it and nothing else can find it */
+    ring = mmap(NULL, sizeof(*ring), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == ring) {
+        err = errno;
+        (void)pthread_mutex_unlock(&m_ringLock);
+        errno = err;
+        return -1;
+    }
+
+    /* the new pages are zeros; slots wait for their first position, last claimed a lap before */
+    for (i = 0; i < RING_SLOTS; i++) {
+        ring->slots[i].seq = i;
+        ring->slots[i].claim = RING_CLAIM(i - RING_SLOTS, 0u);
+    }
+    m_ringPid = (uint32_t)getpid();
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+    __atomic_store_n(&m_ring, ring, __ATOMIC_RELEASE);
+    (void)pthread_mutex_unlock(&m_ringLock);
+    return 0;
+}
+
+unsigned long ZLog_SharedRingDrain(void) {
+    ZLogRing_t * const ring = __atomic_load_n(&m_ring, __ATOMIC_ACQUIRE);
+    unsigned long drained = 0;
+
+    if ((NULL != ring) && ZLog_RingOwn(ring)) {
+        drained = ZLog_RingDrain(ring);
+    }
+    if (0 != drained) {
+        ZLog_SinkFlush();
+    }
+    return drained;
+}
+
+void ZLog_SharedRingStatsGet(ZLogSharedRingStats_t * const stats) {
+    const ZLogRing_t * const ring = __atomic_load_n(&m_ring, __ATOMIC_ACQUIRE);
+
+    memset(stats, 0, sizeof(*stats));
+    if (NULL != ring) {
+        stats->claimed = (unsigned long)__atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        stats->appended = __atomic_load_n(&ring->stats.appended, __ATOMIC_RELAXED);
+        stats->drained = __atomic_load_n(&ring->stats.drained, __ATOMIC_RELAXED);
+        stats->dropped = __atomic_load_n(&ring->stats.dropped, __ATOMIC_RELAXED);
+        stats->recovered = __atomic_load_n(&ring->stats.recovered, __ATOMIC_RELAXED);
+        stats->lost = __atomic_load_n(&ring->stats.lost, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Copy a line into the next slot of the shared ring, or hand it to the target without a ring.
+ *
+ * The slot is claimed by moving the head past it, named by the claim word, filled, and published
+ * through its seq. A full ring drops the line rather than wait for the drainer.
+ */
+static void ZLog_RingPut(const ZLogLevel_t level, const char * const file, const int line,
+                         const char * const func, const char * const message) {
+    ZLogRing_t * const ring = __atomic_load_n(&m_ring, __ATOMIC_ACQUIRE);
+    ZLogRingSlot_t *slot = NULL;
+    uint64_t pos;
+    uint64_t claim;
+    int64_t lag;
+    size_t at;
+
+    if (NULL == ring) {
+        TARGET_SINK(level, file, line, func, message);
+        return;
+    }
+
+    pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    while (NULL == slot) {
+        slot = &ring->slots[pos % RING_SLOTS];
+        lag = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (0 > lag) {
+            /* the slot still holds the line from a lap ago: the ring is full */
+            (void)__atomic_fetch_add(&ring->stats.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        if ((0 != lag) || !__atomic_compare_exchange_n(&ring->head, &pos, pos + 1u, true,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            /* another writer took it; a failed exchange has reloaded pos */
+            pos = (0 != lag) ? __atomic_load_n(&ring->head, __ATOMIC_RELAXED) : pos;
+            slot = NULL;
+        }
+    }
+
+    /* name the claim, unless the drainer took it (and the slot may since have gone round again)
+     * while this thread stalled right here */
+    claim = __atomic_load_n(&slot->claim, __ATOMIC_RELAXED);
+    if ((0 <= (int32_t)(RING_CLAIM_POS(claim) - (uint32_t)pos)) ||
+        !__atomic_compare_exchange_n(&slot->claim, &claim, RING_CLAIM(pos, m_ringPid), false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        (void)__atomic_fetch_add(&ring->stats.lost, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    slot->level = level;
+    slot->line = line;
+    at = ZLog_RingCopy(slot->data, file, RING_NAME_MAX) + 1u;
+    slot->funcOff = (uint16_t)at;
+    at += ZLog_RingCopy(slot->data + at, func, RING_NAME_MAX) + 1u;
+    slot->messageOff = (uint16_t)at;
+    (void)ZLog_RingCopy(slot->data + at, message, sizeof(slot->data) - at - 1u);
+#ifdef Z_CHECK_HAS_THREAD_INFO
+    slot->thread = *ZLog_ThreadGet();
+#endif
+    __atomic_store_n(&slot->seq, pos + 1u, __ATOMIC_RELEASE);
+    (void)__atomic_fetch_add(&ring->stats.appended, 1, __ATOMIC_RELAXED);
+}
+
+/* Copy up to max bytes of src and terminate them; returns the bytes copied */
+static size_t ZLog_RingCopy(char * const dst, const char * const src, const size_t max) {
+    size_t len;
+
+    for (len = 0; (len < max) && ('\0' != src[len]); len++) {
+        dst[len] = src[len];
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+/* On ZLog_Flush(), only the process draining the ring drains it; the others leave it be */
+static void ZLog_RingFlush(void) {
+    ZLogRing_t * const ring = __atomic_load_n(&m_ring, __ATOMIC_ACQUIRE);
+
+    if ((NULL != ring) && (m_ringPid == __atomic_load_n(&ring->drainer, __ATOMIC_ACQUIRE))) {
+        (void)ZLog_RingDrain(ring);
+    }
+}
+
+/**
+ * Hand the published lines to the target in the order their slots were claimed, freeing each
+ * slot after it.
+ *
+ * A slot claimed but not yet published ends the drain until the next call, unless
+ * ZLog_RingRecover() frees it.
+ */
+static unsigned long ZLog_RingDrain(ZLogRing_t * const ring) {
+    unsigned long drained = 0;
+    uint64_t pos;
+#ifdef Z_CHECK_STATIC_CONFIG
+    bool more = true;
+#else
+    bool more = (NULL != m_ZLogFunc);   /* closed: leave the lines for later */
+#endif
+
+    (void)pthread_mutex_lock(&m_ringLock);
+    pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    while (more) {
+        ZLogRingSlot_t * const slot = &ring->slots[pos % RING_SLOTS];
+
+        if ((pos + 1u) == __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE)) {
+#ifdef Z_CHECK_HAS_THREAD_INFO
+            m_sinkThread = &slot->thread;
+#endif
+            TARGET_SINK(slot->level, slot->data, slot->line, slot->data + slot->funcOff,
+                        slot->data + slot->messageOff);
+#ifdef Z_CHECK_HAS_THREAD_INFO
+            m_sinkThread = NULL;
+#endif
+            drained++;
+        }
+        else if ((pos == __atomic_load_n(&ring->head, __ATOMIC_RELAXED)) ||
+                 !ZLog_RingRecover(slot, pos)) {
+            more = false;
+        }
+        else {
+            (void)__atomic_fetch_add(&ring->stats.recovered, 1, __ATOMIC_RELAXED);
+        }
+
+        if (more) {
+            __atomic_store_n(&slot->seq, pos + RING_SLOTS, __ATOMIC_RELEASE);
+            pos++;
+            __atomic_store_n(&ring->tail, pos, __ATOMIC_RELEASE);
+        }
+    }
+    (void)pthread_mutex_unlock(&m_ringLock);
+    (void)__atomic_fetch_add(&ring->stats.drained, drained, __ATOMIC_RELAXED);
+    return drained;
+}
+
+/* Make this process the ring's drainer, unless another live one already is */
+static bool ZLog_RingOwn(ZLogRing_t * const ring) {
+    uint32_t drainer = __atomic_load_n(&ring->drainer, __ATOMIC_ACQUIRE);
+
+    while (m_ringPid != drainer) {
+        if ((0 != drainer) && !ZLog_RingPidGone(drainer)) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&ring->drainer, &drainer, m_ringPid, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            drainer = m_ringPid;
+        }
+    }
+    return true;
+}
+
+/**
+ * Whether a slot claimed but not published can be freed.
+ *
+ * A claim that names its process is freed once that process is gone. One that never got as far
+ * as naming it is taken from its writer after Z_CHECK_SHARED_RING_STALL_MS; if the writer is
+ * still alive, it finds the claim taken when it tries to name it, and drops its line.
+ */
+static bool ZLog_RingRecover(ZLogRingSlot_t * const slot, const uint64_t pos) {
+    uint64_t claim = __atomic_load_n(&slot->claim, __ATOMIC_RELAXED);
+    bool freed = false;
+
+    if ((uint32_t)pos == RING_CLAIM_POS(claim)) {
+        freed = ZLog_RingPidGone(RING_CLAIM_PID(claim));
+    }
+    else if ((pos != m_ringStallPos) || (0 == m_ringStallAt)) {
+        m_ringStallPos = pos;
+        m_ringStallAt = ZLog_TimeNow();
+    }
+    else if ((ZLog_TimeNow() - m_ringStallAt) >= RING_STALL_NS) {
+        freed = __atomic_compare_exchange_n(&slot->claim, &claim, RING_CLAIM(pos, 0u), false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    return freed;
+}
+
+/* Gone means no such process, or, where /proc says, one that died and waits to be reaped: a
+ * zombie keeps its pid but will never publish */
+static bool ZLog_RingPidGone(const uint32_t pid) {
+    const int err = errno;
+    bool gone = (0 != pid) && (0 != kill((pid_t)pid, 0)) && (ESRCH == errno);
+
+#ifdef __linux__
+    gone = gone || ((0 != pid) && ZLog_RingPidDead(pid));
+#endif
+    errno = err;
+    return gone;
+}
+
+#ifdef __linux__
+/* The state in /proc/<pid>/stat, which follows the command name's closing parenthesis */
+static bool ZLog_RingPidDead(const uint32_t pid) {
+    char buf[160]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: snprintf() and read() are bounded by sizeof(buf). */
+    const char *paren;
+    ssize_t len;
+    int fd;
+
+    (void)snprintf(buf, sizeof(buf), "/proc/%lu/stat", (unsigned long)pid);
+    fd = open(buf, O_RDONLY); /* Flawfinder: ignore */
+        /* Warning: check when opening files
+           "Ignore" justification: the path is built from a pid. */
+    if (-1 == fd) {
+        return false;   /* no /proc to ask; kill() says the process is there */
+    }
+    len = read(fd, buf, sizeof(buf) - 1u); /* Flawfinder: ignore */
+    (void)close(fd);
+    if (0 >= len) {
+        return false;
+    }
+    buf[len] = '\0';
+    paren = strrchr(buf, ')');
+    return (NULL != paren) && (' ' == paren[1]) && (('Z' == paren[2]) || ('X' == paren[2]));
+}
+#endif
+
+/* The child has a pid of its own, and none of the parent's threads draining */
+static void ZLog_RingForkChild(void) {
+    m_ringPid = (uint32_t)getpid();
+    (void)pthread_mutex_init(&m_ringLock, NULL);
+}
+#endif /* Z_CHECK_HAS_SHARED_RING */
+
+
+/******************************************************************************
+ *                                                                 Spool sink */
+#ifdef SPOOL_SINK
+    #define SPOOL_DIGITS 16     /* in a segment's number */
+    #define SPOOL_PATH_MAX (sizeof(Z_CHECK_SPOOL_DIR) + SPOOL_DIGITS + 16)
+    #define SPOOL_FAILS 8       /* failed commits kept for ZLog_SpoolWait() */
+    /* What a directory entry is, going by its name; indexes m_spoolSuffix */
+    #define SPOOL_OTHER 0
+    #define SPOOL_OPEN 1
+    #define SPOOL_SEALED 2
+    #define SPOOL_SHIPPED 3
+
+#ifdef Z_CHECK_FREESTANDING
+    #error "Z_SPOOL writes files, which freestanding Z_CHECK does not assume"
+#endif
+#if defined(Z_CHECK_HAS_ASYNC) || defined(Z_CHECK_HAS_SHARED_RING)
+    #error "Z_SPOOL tickets belong to the thread that logs; drop Z_CHECK_HAS_ASYNC and the ring"
+#endif
+    Z_CT_ASSERT_DECL(Z_CHECK_SPOOL_BUFFER >= 4096);
+    Z_CT_ASSERT_DECL(Z_CHECK_SPOOL_SEGMENT > 0);
+
+static void ZLog_SpoolSync(const uint64_t ticket);
+static void ZLog_SpoolAwait(void);
+static void ZLog_SpoolStart(void);
+static void * ZLog_SpoolCommitter(void *unused);
+static void ZLog_SpoolCommit(void);
+static bool ZLog_SpoolFailed(const uint64_t ticket) PURE_FUNC;
+static bool ZLog_SpoolAppend(const char * const batch, const size_t len);
+static bool ZLog_SpoolOpen(void);
+static bool ZLog_SpoolNumberUsed(const unsigned long long number);
+static void ZLog_SpoolSeal(void);
+static void ZLog_SpoolScan(const bool recover);
+static void ZLog_SpoolRecover(const unsigned long long number);
+static void ZLog_SpoolRename(const unsigned long long number, const int from, const int to);
+static bool ZLog_SpoolSyncDir(void);
+static int ZLog_SpoolName(const char * const name, unsigned long long * const number);
+static void ZLog_SpoolPath(char * const path, const unsigned long long number, const int kind);
+static void ZLog_SpoolExit(void);
+
+    /* Everything below is under m_spoolLock. Lines gather in m_spoolBuf[m_spoolFill] while a
+     * commit writes the other buffer; tickets up to m_spoolSynced are committed, or failed. */
+    static pthread_mutex_t m_spoolLock = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_cond_t m_spoolWake = PTHREAD_COND_INITIALIZER;   /* the commit thread's */
+    static pthread_cond_t m_spoolDone = PTHREAD_COND_INITIALIZER;   /* a commit has ended */
+    static char m_spoolBuf[2][Z_CHECK_SPOOL_BUFFER]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_SpoolWrite() only appends lines that fit. */
+    static size_t m_spoolLen = 0;
+    static unsigned m_spoolFill = 0;
+    static struct timespec m_spoolDue;          /* CLOCK_REALTIME, when the gathering lines go */
+    static bool m_spoolBusy = false;            /* a commit is writing the other buffer */
+    static bool m_spoolStarted = false;
+    static bool m_spoolRunning = false;         /* the commit thread is */
+    static bool m_spoolStop = false;
+    static bool m_spoolExit = false;            /* exit handler installed; a child inherits it */
+    static pthread_t m_spoolThread;
+    static unsigned m_spoolWaiting = 0;         /* threads waiting for a commit to end */
+    static uint64_t m_spoolSeq = 0;             /* the last ticket handed out */
+    static uint64_t m_spoolSynced = 0;
+    static uint64_t m_spoolFailed[SPOOL_FAILS][2];  /* first and last ticket of failed commits */
+    static unsigned m_spoolFailCount = 0;
+    static int m_spoolErrno = 0;                /* of the last failure */
+    static ZLogSpoolStats_t m_spoolStats = {0};
+    static THREAD_LOCAL uint64_t m_spoolTicket = 0;
+    /* The segment, touched only by the commit running, with the lock dropped */
+    static const char * const m_spoolSuffix[] = {
+        [SPOOL_OTHER] = "", [SPOOL_OPEN] = ".open", [SPOOL_SEALED] = ".log",
+        [SPOOL_SHIPPED] = ".shipped"
+    };
+    static int m_spoolFd = -1;
+    static unsigned long long m_spoolNumber = 0;    /* of the segment, or the highest seen */
+    static size_t m_spoolSegmentLen = 0;
+    static bool m_spoolScanned = false;         /* this process has gone through the directory */
+    static unsigned long m_spoolSegments = 0;   /* written atomically */
+
+unsigned long long ZLog_SpoolTicket(void) {
+    return m_spoolTicket;
+}
+
+int ZLog_SpoolWait(const unsigned long long ticket) {
+    int err = 0;
+
+    (void)pthread_mutex_lock(&m_spoolLock);
+    if (ticket > m_spoolSeq) {
+        err = EINVAL;
+    }
+    else {
+        ZLog_SpoolSync(ticket);
+        err = ZLog_SpoolFailed(ticket) ? m_spoolErrno : 0;
+    }
+    (void)pthread_mutex_unlock(&m_spoolLock);
+    if (0 != err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void ZLog_SpoolStatsGet(ZLogSpoolStats_t * const stats) {
+    (void)pthread_mutex_lock(&m_spoolLock);
+    *stats = m_spoolStats;
+    stats->lines = (unsigned long)m_spoolSeq;
+    (void)pthread_mutex_unlock(&m_spoolLock);
+    stats->segments = __atomic_load_n(&m_spoolSegments, __ATOMIC_RELAXED);
+}
+
+/* Lines gather while the last commit runs; a caller finding no room waits for the next */
+static void ZLog_SpoolWrite(const char * const buf, const size_t len) {
+    const size_t take = (len < Z_CHECK_SPOOL_BUFFER) ? len : Z_CHECK_SPOOL_BUFFER;
+
+    (void)pthread_mutex_lock(&m_spoolLock);
+    if (!m_spoolStarted) {
+        ZLog_SpoolStart();
+    }
+    if (take > (Z_CHECK_SPOOL_BUFFER - m_spoolLen)) {
+        m_spoolStats.stalls++;
+        m_spoolWaiting++;
+        while (take > (Z_CHECK_SPOOL_BUFFER - m_spoolLen)) {
+            ZLog_SpoolAwait();
+        }
+        m_spoolWaiting--;
+    }
+    if (0 == m_spoolLen) {
+        (void)clock_gettime(CLOCK_REALTIME, &m_spoolDue);
+        m_spoolDue.tv_sec += (time_t)(Z_CHECK_SPOOL_COMMIT_MS / 1000);
+        m_spoolDue.tv_nsec += (long)(Z_CHECK_SPOOL_COMMIT_MS % 1000) * 1000000L;
+        if (1000000000L <= m_spoolDue.tv_nsec) {
+            m_spoolDue.tv_sec++;
+            m_spoolDue.tv_nsec -= 1000000000L;
+        }
+    }
+    memcpy(&m_spoolBuf[m_spoolFill][m_spoolLen], buf, take);
+    m_spoolLen += take;
+    m_spoolStats.bytes += take;
+    m_spoolTicket = ++m_spoolSeq;
+    if (m_spoolLen >= (Z_CHECK_SPOOL_BUFFER / 2)) {
+        (void)pthread_cond_signal(&m_spoolWake);
+    }
+    (void)pthread_mutex_unlock(&m_spoolLock);
+}
+
+/* Wait for everything logged so far */
+static void ZLog_SpoolFlush(void) {
+    (void)pthread_mutex_lock(&m_spoolLock);
+    ZLog_SpoolSync(m_spoolSeq);
+    (void)pthread_mutex_unlock(&m_spoolLock);
+}
+
+/* Under m_spoolLock: wait until the commit of a ticket has ended, however it went */
+static void ZLog_SpoolSync(const uint64_t ticket) {
+    if (m_spoolSynced < ticket) {
+        m_spoolWaiting++;
+        while (m_spoolSynced < ticket) {
+            ZLog_SpoolAwait();
+        }
+        m_spoolWaiting--;
+    }
+}
+
+/* Under m_spoolLock, with m_spoolWaiting counting the caller: let a commit end, the commit
+ * thread's, or one run right here if there is no thread and none running */
+static void ZLog_SpoolAwait(void) {
+    if (!m_spoolRunning && !m_spoolBusy) {
+        ZLog_SpoolCommit();
+    }
+    else {
+        (void)pthread_cond_signal(&m_spoolWake);
+        (void)pthread_cond_wait(&m_spoolDone, &m_spoolLock);
+    }
+}
+
+/* On the first line in each process: the commit thread, and handlers for fork and exit */
+static void ZLog_SpoolStart(void) {
+    m_spoolStarted = true;
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+    if (!m_spoolExit) {
+        m_spoolExit = true;
+        (void)atexit(ZLog_SpoolExit);
+    }
+    m_spoolRunning = (0 == pthread_create(&m_spoolThread, NULL, ZLog_SpoolCommitter, NULL));
+}
+
+/**
+ * The commit thread: commit the lines gathered as soon as anyone waits on them, once half the
+ * buffer is full, or when the first of them has waited Z_CHECK_SPOOL_COMMIT_MS.
+ *
+ * Whoever comes to wait while a commit runs is covered by the next one, so the busier the
+ * callers, the more lines each fdatasync() takes.
+ */
+static void * ZLog_SpoolCommitter(void *unused) {
+    bool due = false;
+
+    UNUSED_VARIABLE(unused);
+    (void)pthread_mutex_lock(&m_spoolLock);
+    while (!m_spoolStop || (0 != m_spoolLen)) {
+        due = due || m_spoolStop || (0 != m_spoolWaiting) ||
+              (m_spoolLen >= (Z_CHECK_SPOOL_BUFFER / 2));
+        if ((0 != m_spoolLen) && due) {
+            ZLog_SpoolCommit();
+            due = false;
+        }
+        else if (0 != m_spoolLen) {
+            due = (ETIMEDOUT == pthread_cond_timedwait(&m_spoolWake, &m_spoolLock, &m_spoolDue));
+        }
+        else {
+            (void)pthread_cond_wait(&m_spoolWake, &m_spoolLock);
+        }
+    }
+    (void)pthread_mutex_unlock(&m_spoolLock);
+    return NULL;
+}
+
+/**
+ * Under m_spoolLock: commit the lines gathered so far, and release whoever waits on them.
+ *
+ * The buffers swap and the lock is dropped while the batch is written and synced, so lines
+ * keep gathering in the other buffer meanwhile. A failed commit is kept as a range of tickets
+ * for ZLog_SpoolWait(); with SPOOL_FAILS kept, the two oldest merge, and whatever made it in
+ * between is reported failed too.
+ */
+static void ZLog_SpoolCommit(void) {
+    const char * const batch = m_spoolBuf[m_spoolFill];
+    const size_t len = m_spoolLen;
+    const uint64_t last = m_spoolSeq;
+    bool ok;
+    int err;
+
+    m_spoolBusy = true;
+    m_spoolFill ^= 1u;
+    m_spoolLen = 0;
+    (void)pthread_mutex_unlock(&m_spoolLock);
+    ok = ZLog_SpoolAppend(batch, len);
+    err = errno;
+    (void)pthread_mutex_lock(&m_spoolLock);
+
+    m_spoolStats.commits++;
+    if (!ok) {
+        if (SPOOL_FAILS == m_spoolFailCount) {
+            m_spoolFailed[1][0] = m_spoolFailed[0][0];
+            memmove(m_spoolFailed[0], m_spoolFailed[1],
+                    (SPOOL_FAILS - 1u) * sizeof(m_spoolFailed[0]));
+            m_spoolFailCount--;
+        }
+        m_spoolFailed[m_spoolFailCount][0] = m_spoolSynced + 1u;
+        m_spoolFailed[m_spoolFailCount][1] = last;
+        m_spoolFailCount++;
+        m_spoolErrno = (0 != err) ? err : EIO;
+        m_spoolStats.failures++;
+    }
+    m_spoolSynced = last;
+    m_spoolBusy = false;
+    (void)pthread_cond_broadcast(&m_spoolDone);
+}
+
+/* Whether the commit of a ticket failed, going by the ranges kept */
+static bool ZLog_SpoolFailed(const uint64_t ticket) {
+    unsigned i;
+
+    for (i = 0; i < m_spoolFailCount; i++) {
+        if ((m_spoolFailed[i][0] <= ticket) && (ticket <= m_spoolFailed[i][1])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Write a batch to the segment and sync it, opening a segment first if there is none.
+ *
+ * After a failed write or sync, what the segment holds is unknown (the kernel may since have
+ * dropped the pages it could not write, and a second fdatasync() would not say so), so it is
+ * sealed as it is and the next batch starts a new one. The shipper skips a torn last line.
+ */
+static bool ZLog_SpoolAppend(const char * const batch, const size_t len) {
+    bool ok = (-1 != m_spoolFd) || ZLog_SpoolOpen();
+    size_t done = 0;
+
+    while (ok && (done < len)) {
+        const ssize_t wrote = write(m_spoolFd, &batch[done], len - done);
+
+        if (0 < wrote) {
+            done += (size_t)wrote;
+        }
+        else if ((0 == wrote) || (EINTR != errno)) {
+            ok = false;
+        }
+    }
+    ok = ok && (0 == fdatasync(m_spoolFd));
+    m_spoolSegmentLen += done;
+    if (!ok || (m_spoolSegmentLen >= Z_CHECK_SPOOL_SEGMENT)) {
+        const int err = errno;
+
+        ZLog_SpoolSeal();
+        errno = err;
+    }
+    return ok;
+}
+
+/**
+ * Open the next segment, the first time in a process after going through the directory.
+ *
+ * The number comes from an exclusive create, and is given up for the next if another process
+ * has meanwhile sealed a segment of that number. The new name is synced into the directory
+ * before any line counts on it, and the segment is locked, which tells other processes that
+ * go through the directory it is not a leftover.
+ */
+static bool ZLog_SpoolOpen(void) {
+    char path[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_SpoolPath() is bounded by SPOOL_PATH_MAX. */
+    struct flock lock;
+    bool taken = true;
+
+    if (!m_spoolScanned) {
+        (void)mkdir(Z_CHECK_SPOOL_DIR, 0755);
+        ZLog_SpoolScan(true);
+        m_spoolScanned = true;
+    }
+    while (taken) {
+        m_spoolNumber++;
+        ZLog_SpoolPath(path, m_spoolNumber, SPOOL_OPEN);
+        m_spoolFd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+        if (-1 == m_spoolFd) {
+            if (EEXIST != errno) {
+                return false;
+            }
+        }
+        else if (ZLog_SpoolNumberUsed(m_spoolNumber)) {
+            (void)close(m_spoolFd);
+            (void)unlink(path);
+            m_spoolFd = -1;
+        }
+        else {
+            taken = false;
+        }
+    }
+    (void)fcntl(m_spoolFd, F_SETFD, FD_CLOEXEC);
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    (void)fcntl(m_spoolFd, F_SETLK, &lock);
+    (void)__atomic_fetch_add(&m_spoolSegments, 1, __ATOMIC_RELAXED);
+    return ZLog_SpoolSyncDir();
+}
+
+/* Whether a sealed or shipped segment already has a number */
+static bool ZLog_SpoolNumberUsed(const unsigned long long number) {
+    char path[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_SpoolPath() is bounded by SPOOL_PATH_MAX. */
+    struct stat info;
+    bool used;
+
+    ZLog_SpoolPath(path, number, SPOOL_SEALED);
+    used = (0 == stat(path, &info));
+    ZLog_SpoolPath(path, number, SPOOL_SHIPPED);
+    return used || (0 == stat(path, &info));
+}
+
+/* Close the segment and rename it for the shipper, deleting what it has shipped */
+static void ZLog_SpoolSeal(void) {
+    if (-1 == m_spoolFd) {
+        return;
+    }
+    (void)close(m_spoolFd);
+    m_spoolFd = -1;
+    m_spoolSegmentLen = 0;
+    ZLog_SpoolRename(m_spoolNumber, SPOOL_OPEN, SPOOL_SEALED);
+    ZLog_SpoolScan(false);
+    (void)ZLog_SpoolSyncDir();
+}
+
+/**
+ * Go through the directory: number new segments after the highest there, delete shipped ones,
+ * and with recover, seal .open segments that no live process has locked.
+ *
+ * An empty .open segment may be one another process has just created and not yet locked, so
+ * it is left alone.
+ */
+static void ZLog_SpoolScan(const bool recover) {
+    DIR * const dir = opendir(Z_CHECK_SPOOL_DIR);
+    const struct dirent *entry;
+
+    if (NULL == dir) {
+        return;
+    }
+    while (NULL != (entry = readdir(dir))) {
+        unsigned long long number = 0;
+        const int kind = ZLog_SpoolName(entry->d_name, &number);
+
+        if ((SPOOL_OTHER != kind) && (number > m_spoolNumber)) {
+            m_spoolNumber = number;
+        }
+        if (SPOOL_SHIPPED == kind) {
+            char path[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+                /* Warning: Statically-sized array
+                   "Ignore" justification: ZLog_SpoolPath() is bounded by SPOOL_PATH_MAX. */
+
+            ZLog_SpoolPath(path, number, SPOOL_SHIPPED);
+            (void)unlink(path);
+        }
+        else if (recover && (SPOOL_OPEN == kind)) {
+            ZLog_SpoolRecover(number);
+        }
+    }
+    (void)closedir(dir);
+}
+
+/* Seal a leftover .open segment if no process holds its lock and it has something in it */
+static void ZLog_SpoolRecover(const unsigned long long number) {
+    char path[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_SpoolPath() is bounded by SPOOL_PATH_MAX. */
+    struct flock lock;
+    struct stat info;
+    int fd;
+
+    ZLog_SpoolPath(path, number, SPOOL_OPEN);
+    fd = open(path, O_WRONLY);
+    if (-1 == fd) {
+        return;
+    }
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if ((0 == fcntl(fd, F_SETLK, &lock)) && (0 == fstat(fd, &info)) && (0 < info.st_size)) {
+        ZLog_SpoolRename(number, SPOOL_OPEN, SPOOL_SEALED);
+    }
+    (void)close(fd);
+}
+
+static void ZLog_SpoolRename(const unsigned long long number, const int from, const int to) {
+    char fromPath[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+    char toPath[SPOOL_PATH_MAX]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_SpoolPath() is bounded by SPOOL_PATH_MAX. */
+
+    ZLog_SpoolPath(fromPath, number, from);
+    ZLog_SpoolPath(toPath, number, to);
+    (void)rename(fromPath, toPath);
+}
+
+/* Sync the directory, so the names of new and renamed segments last */
+static bool ZLog_SpoolSyncDir(void) {
+    const int fd = open(Z_CHECK_SPOOL_DIR, O_RDONLY);
+    bool ok;
+
+    if (-1 == fd) {
+        return false;
+    }
+    ok = (0 == fsync(fd));
+    (void)close(fd);
+    return ok;
+}
+
+/* What a directory entry is: 16 digits and one of the suffixes, or something else */
+static int ZLog_SpoolName(const char * const name, unsigned long long * const number) {
+    unsigned long long value = 0;
+    int kind;
+    unsigned i;
+
+    for (i = 0; i < SPOOL_DIGITS; i++) {
+        if (('0' > name[i]) || ('9' < name[i])) {
+            return SPOOL_OTHER;
+        }
+        value = (value * 10u) + (unsigned)(name[i] - '0');
+    }
+    for (kind = SPOOL_OPEN; kind <= SPOOL_SHIPPED; kind++) {
+        if (0 == strcmp(&name[SPOOL_DIGITS], m_spoolSuffix[kind])) {
+            *number = value;
+            return kind;
+        }
+    }
+    return SPOOL_OTHER;
+}
+
+static void ZLog_SpoolPath(char * const path, const unsigned long long number, const int kind) {
+    (void)snprintf(path, SPOOL_PATH_MAX, "%s/%0*llu%s", Z_CHECK_SPOOL_DIR, SPOOL_DIGITS, number,
+                   m_spoolSuffix[kind]);
+}
+
+/* Commit what is left and seal the segment; lines logged after this commit only when waited on */
+static void ZLog_SpoolExit(void) {
+    bool running;
+
+    (void)pthread_mutex_lock(&m_spoolLock);
+    m_spoolStop = true;
+    running = m_spoolRunning;
+    (void)pthread_cond_signal(&m_spoolWake);
+    (void)pthread_mutex_unlock(&m_spoolLock);
+    if (running) {
+        (void)pthread_join(m_spoolThread, NULL);
+    }
+
+    (void)pthread_mutex_lock(&m_spoolLock);
+    m_spoolRunning = false;
+    ZLog_SpoolSync(m_spoolSeq);
+    if (!m_spoolBusy) {
+        ZLog_SpoolSeal();
+    }
+    (void)pthread_mutex_unlock(&m_spoolLock);
+}
+
+/* The lock is held across fork(), as ZLog_ForkPrepare() holds the others */
+static void ZLog_SpoolForkPrepare(void) {
+    (void)pthread_mutex_lock(&m_spoolLock);
+}
+
+static void ZLog_SpoolForkParent(void) {
+    (void)pthread_mutex_unlock(&m_spoolLock);
+}
+
+/* What has gathered is the parent's to commit, and its segment the parent's to write. The
+ * child numbers its tickets from 1 and opens segments of its own, with a commit thread of its
+ * own, when it first logs. */
+static void ZLog_SpoolForkChild(void) {
+    if (-1 != m_spoolFd) {
+        (void)close(m_spoolFd);
+        m_spoolFd = -1;
+    }
+    m_spoolLen = 0;
+    m_spoolBusy = false;
+    m_spoolStarted = false;
+    m_spoolRunning = false;
+    m_spoolWaiting = 0;
+    m_spoolSeq = 0;
+    m_spoolSynced = 0;
+    m_spoolFailCount = 0;
+    m_spoolTicket = 0;
+    m_spoolSegmentLen = 0;
+    m_spoolScanned = false;
+    memset(&m_spoolStats, 0, sizeof(m_spoolStats));
+    __atomic_store_n(&m_spoolSegments, 0, __ATOMIC_RELAXED);
+    (void)pthread_cond_init(&m_spoolWake, NULL);
+    (void)pthread_cond_init(&m_spoolDone, NULL);
+    (void)pthread_mutex_unlock(&m_spoolLock);
+}
+#endif /* SPOOL_SINK */
+
+
+/******************************************************************************
+ *                                                           Direct file sink */
+#ifdef DIRECT_SINK
+    #define DIRECT_BLOCK ((size_t)Z_CHECK_FILE_DIRECT_BLOCK)
+    #define DIRECT_LINGER_NS ((unsigned long long)Z_CHECK_FILE_DIRECT_LINGER_MS * 1000000ull)
+    #define DIRECT_PATH_MAX (sizeof(Z_CHECK_LOG_FILE_PATH) + 24)    /* with '.' and a pid */
+
+#ifndef O_DIRECT
+    #error "Z_CHECK_FILE_DIRECT needs O_DIRECT, which <fcntl.h> declares on Linux with _GNU_SOURCE"
+#endif
+    Z_CT_ASSERT_DECL((Z_CHECK_FILE_DIRECT_BLOCK >= 512) &&
+                     (0 == (Z_CHECK_FILE_DIRECT_BLOCK & (Z_CHECK_FILE_DIRECT_BLOCK - 1))));
+    Z_CT_ASSERT_DECL((Z_CHECK_FILE_DIRECT_BUFFER >= Z_CHECK_FILE_DIRECT_BLOCK) &&
+                     (0 == (Z_CHECK_FILE_DIRECT_BUFFER % Z_CHECK_FILE_DIRECT_BLOCK)));
+
+static void ZLog_DirectLinger(const unsigned long long now);
+static void ZLog_DirectTail(void);
+static bool ZLog_DirectPut(const size_t size);
+static void ZLog_DirectStart(void);
+
+    /* Everything below is under m_directLock. The buffer holds the file from m_directOff, a
+     * block boundary, on; all but lines that came since m_directAt are on disk. */
+    static pthread_mutex_t m_directLock = PTHREAD_MUTEX_INITIALIZER;
+    static char m_directBuf[Z_CHECK_FILE_DIRECT_BUFFER] /* Flawfinder: ignore */
+        __attribute__((aligned(Z_CHECK_FILE_DIRECT_BLOCK)));
+        /* Warning: Statically-sized array
+           "Ignore" justification: ZLog_DirectWrite() writes out the buffer as it fills. */
+    static size_t m_directLen = 0;
+    static off_t m_directOff = 0;
+    static unsigned long long m_directAt = 0;   /* when the oldest line not written came; 0: none */
+    static int m_directFd = -1;
+    static bool m_directStarted = false;
+    static bool m_directChild = false;          /* forked: the file name takes the pid */
+    static ZLogFileDirectStats_t m_directStats = {0};
+
+void ZLog_FileDirectStatsGet(ZLogFileDirectStats_t * const stats) {
+    (void)pthread_mutex_lock(&m_directLock);
+    *stats = m_directStats;
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+
+/* Lines fill the buffer, which goes out whole when full; what is left waits out the linger */
+static void ZLog_DirectWrite(const char * const buf, const size_t len) {
+    unsigned long long now;
+    size_t done = 0;
+
+    (void)pthread_mutex_lock(&m_directLock);
+    if (!m_directStarted) {
+        ZLog_DirectStart();
+    }
+    now = ZLog_TimeNow();
+    m_directStats.lines++;
+    m_directStats.bytes += len;
+    if (0 == m_directAt) {
+        m_directAt = now;
+    }
+    while (done < len) {
+        const size_t room = Z_CHECK_FILE_DIRECT_BUFFER - m_directLen;
+        const size_t take = ((len - done) < room) ? (len - done) : room;
+
+        memcpy(&m_directBuf[m_directLen], &buf[done], take);
+        m_directLen += take;
+        done += take;
+        if (Z_CHECK_FILE_DIRECT_BUFFER == m_directLen) {
+            (void)ZLog_DirectPut(Z_CHECK_FILE_DIRECT_BUFFER);
+            m_directOff += (off_t)Z_CHECK_FILE_DIRECT_BUFFER;
+            m_directLen = 0;
+            m_directAt = now;
+        }
+    }
+    if (0 == m_directLen) {
+        m_directAt = 0;
+    }
+    ZLog_DirectLinger(now);
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+
+/* Write everything gathered, the last block padded */
+static void ZLog_DirectFlush(void) {
+    (void)pthread_mutex_lock(&m_directLock);
+    if (0 != m_directAt) {
+        ZLog_DirectTail();
+    }
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+
+#ifdef Z_CHECK_HAS_ASYNC
+static void ZLog_DirectIdle(void) {
+    (void)pthread_mutex_lock(&m_directLock);
+    ZLog_DirectLinger(ZLog_TimeNow());
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+#endif
+
+static void ZLog_DirectLinger(const unsigned long long now) {
+    if ((0 != m_directAt) && ((now - m_directAt) >= DIRECT_LINGER_NS)) {
+        ZLog_DirectTail();
+    }
+}
+
+/**
+ * Pad the last, partial block with newlines and write it after the whole blocks before it,
+ * then cut the file back to the end of the lines.
+ *
+ * The whole blocks leave the buffer; the partial one stays at its start, to be written again
+ * when more lines have joined it.
+ */
+static void ZLog_DirectTail(void) {
+    const size_t whole = m_directLen - (m_directLen % DIRECT_BLOCK);
+    const size_t padded = (whole == m_directLen) ? whole : (whole + DIRECT_BLOCK);
+
+    memset(&m_directBuf[m_directLen], '\n', padded - m_directLen);
+    if (ZLog_DirectPut(padded) && (padded != m_directLen)) {
+        m_directStats.tails++;
+        (void)ftruncate(m_directFd, m_directOff + (off_t)m_directLen);
+    }
+    memmove(m_directBuf, &m_directBuf[whole], m_directLen - whole);
+    m_directOff += (off_t)whole;
+    m_directLen -= whole;
+    m_directAt = 0;
+}
+
+/* Write the first size bytes of the buffer, whole blocks, at m_directOff. A file system that
+ * takes O_DIRECT at open() but not the writes (EINVAL) gets them through the page cache. */
+static bool ZLog_DirectPut(const size_t size) {
+    ssize_t wrote = -1;
+    bool retry = true;
+
+    if (-1 == m_directFd) {
+        m_directStats.failures++;
+        return false;
+    }
+    m_directStats.writes++;
+    while (retry) {
+        wrote = pwrite(m_directFd, m_directBuf, size, m_directOff);
+        retry = (0 > wrote) && (EINTR == errno);
+        if ((0 > wrote) && (EINVAL == errno) && (0 == m_directStats.buffered)) {
+            (void)fcntl(m_directFd, F_SETFL, fcntl(m_directFd, F_GETFL) & ~O_DIRECT);
+            m_directStats.buffered = 1;
+            retry = true;
+        }
+    }
+    if ((size_t)wrote != size) {
+        m_directStats.failures++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Open the file on the first line in each process, and carry on from its end: its last,
+ * partial block is read into the buffer to be written again with the lines that follow.
+ */
+static void ZLog_DirectStart(void) {
+    char path[DIRECT_PATH_MAX]; /* Flawfinder: ignore */
+        /* Warning: Statically-sized array
+           "Ignore" justification: snprintf() is bounded by its size. */
+    struct stat info;
+
+    m_directStarted = true;
+    (void)pthread_once(&m_forkOnce, ZLog_ForkInit);
+#ifndef Z_CHECK_HAS_ASYNC
+    if (!m_directChild) {
+        (void)atexit(ZLog_DirectFlush);     /* a child inherits it */
+    }
+#endif
+    if (m_directChild) {
+        (void)snprintf(path, sizeof(path), "%s.%lu", Z_CHECK_LOG_FILE_PATH,
+                       (unsigned long)getpid());
+    }
+    else {
+        (void)snprintf(path, sizeof(path), "%s", Z_CHECK_LOG_FILE_PATH);
+    }
+    m_directFd = open(path, O_RDWR | O_CREAT | O_DIRECT, 0644); /* Flawfinder: ignore */
+        /* Warning: check when opening files
+           "Ignore" justification: the path comes from the build configuration. */
+    if ((-1 == m_directFd) && (EINVAL == errno)) {
+        m_directFd = open(path, O_RDWR | O_CREAT, 0644); /* Flawfinder: ignore */
+        m_directStats.buffered = 1;
+    }
+    if (-1 == m_directFd) {
+        /* don't have Z_LOG setup yet to use */
+        fprintf(stderr, "Warning: Cannot open log file %s; dropping lines\n", path);
+        return;
+    }
+    (void)fcntl(m_directFd, F_SETFD, FD_CLOEXEC);
+    if (0 == fstat(m_directFd, &info)) {
+        m_directLen = (size_t)(info.st_size % (off_t)DIRECT_BLOCK);
+        m_directOff = info.st_size - (off_t)m_directLen;
+        if ((0 != m_directLen) &&
+            (pread(m_directFd, m_directBuf, DIRECT_BLOCK, m_directOff) < (ssize_t)m_directLen)) {
+            /* leave the partial block as it is, and start on the next one */
+            m_directOff += (off_t)DIRECT_BLOCK;
+            m_directLen = 0;
+        }
+    }
+}
+
+/* The lock is held across fork(), as ZLog_ForkPrepare() holds the others */
+static void ZLog_DirectForkPrepare(void) {
+    (void)pthread_mutex_lock(&m_directLock);
+}
+
+static void ZLog_DirectForkParent(void) {
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+
+/* What has gathered is the parent's to write. The child opens a file of its own when it first
+ * logs. */
+static void ZLog_DirectForkChild(void) {
+    if (-1 != m_directFd) {
+        (void)close(m_directFd);
+        m_directFd = -1;
+    }
+    m_directLen = 0;
+    m_directOff = 0;
+    m_directAt = 0;
+    m_directStarted = false;
+    m_directChild = true;
+    memset(&m_directStats, 0, sizeof(m_directStats));
+    (void)pthread_mutex_unlock(&m_directLock);
+}
+#endif /* DIRECT_SINK */
+
+
+/******************************************************************************
+ *                                                             File writeback */
+#ifdef FILE_WRITEBACK
+    #define WRITEBACK_NS ((unsigned long long)Z_CHECK_FILE_WRITEBACK_MS * 1000000ull)
+    #define WRITEBACK_WINDOW ((off_t)Z_CHECK_FILE_WRITEBACK_WINDOW)
+
+#ifndef Z_CHECK_HAS_ASYNC
+    #error "Z_CHECK_FILE_WRITEBACK is done by the writer thread; define Z_CHECK_HAS_ASYNC"
+#endif
+#ifndef SYNC_FILE_RANGE_WRITE
+    #error "Z_CHECK_FILE_WRITEBACK needs sync_file_range(), declared on Linux with _GNU_SOURCE"
+#endif
+    Z_CT_ASSERT_DECL((Z_CHECK_FILE_WRITEBACK_WINDOW >= 4096) &&
+                     (0 == (Z_CHECK_FILE_WRITEBACK_WINDOW % 4096)));
+
+    /* The writer thread's alone. Of the file m_writebackIno, the windows before
+     * m_writebackStarted have been sent to writeback, and those before m_writebackDropped
+     * dropped from the page cache as well. */
+    static unsigned long long m_writebackAt = 0;    /* last pass; 0: the next line starts one */
+    static dev_t m_writebackDev = 0;
+    static ino_t m_writebackIno = 0;
+    static off_t m_writebackStarted = 0;
+    static off_t m_writebackDropped = 0;
+    static ZLogFileWritebackStats_t m_writebackStats = {0};
+
+void ZLog_FileWritebackStatsGet(ZLogFileWritebackStats_t * const stats) {
+    stats->passes = __atomic_load_n(&m_writebackStats.passes, __ATOMIC_RELAXED);
+    stats->started = __atomic_load_n(&m_writebackStats.started, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&m_writebackStats.dropped, __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&m_writebackStats.failures, __ATOMIC_RELAXED);
+}
+
+/**
+ * A pass every WRITEBACK_NS, from the writer thread: wait for the windows sent to writeback on
+ * the last pass to reach the disk and drop them from the page cache, then send the windows
+ * filled since. The window being filled is left for the next pass.
+ */
+static void ZLog_FileWriteback(void) {
+    FILE * const stream = __atomic_load_n(&m_logFile, __ATOMIC_ACQUIRE);
+    const unsigned long long now = ZLog_TimeNow();
+    struct stat info;
+    off_t end;
+    int fd;
+
+#ifndef Z_CHECK_STATIC_CONFIG
+    if (ZLog_File != m_ZLogFunc) {
+        return;
+    }
+#endif
+    if ((NULL == stream) || (stderr == stream) || ((now - m_writebackAt) < WRITEBACK_NS)) {
+        return;
+    }
+    m_writebackAt = now;
+    fd = fileno(stream);
+    if (0 != fstat(fd, &info)) {
+        (void)__atomic_fetch_add(&m_writebackStats.failures, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    end = info.st_size - (info.st_size % WRITEBACK_WINDOW);
+    if ((info.st_dev != m_writebackDev) || (info.st_ino != m_writebackIno) ||
+        (end < m_writebackStarted)) {
+        /* a file new to the sink, or cut short: what it holds already is not the sink's */
+        m_writebackDev = info.st_dev;
+        m_writebackIno = info.st_ino;
+        m_writebackStarted = end;
+        m_writebackDropped = end;
+        return;
+    }
+    (void)__atomic_fetch_add(&m_writebackStats.passes, 1, __ATOMIC_RELAXED);
+
+    if (m_writebackDropped < m_writebackStarted) {
+        const off_t len = m_writebackStarted - m_writebackDropped;
+
+        if ((0 == sync_file_range(fd, m_writebackDropped, len, SYNC_FILE_RANGE_WAIT_BEFORE |
+                                  SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER)) &&
+            (0 == posix_fadvise(fd, m_writebackDropped, len, POSIX_FADV_DONTNEED))) {
+            (void)__atomic_fetch_add(&m_writebackStats.dropped, (unsigned long)len,
+                                     __ATOMIC_RELAXED);
+        }
+        else {
+            (void)__atomic_fetch_add(&m_writebackStats.failures, 1, __ATOMIC_RELAXED);
+        }
+        m_writebackDropped = m_writebackStarted;
+    }
+    if (m_writebackStarted < end) {
+        if (0 == sync_file_range(fd, m_writebackStarted, end - m_writebackStarted,
+                                 SYNC_FILE_RANGE_WRITE)) {
+            (void)__atomic_fetch_add(&m_writebackStats.started,
+                                     (unsigned long)(end - m_writebackStarted), __ATOMIC_RELAXED);
+        }
+        else {
+            (void)__atomic_fetch_add(&m_writebackStats.failures, 1, __ATOMIC_RELAXED);
+        }
+        m_writebackStarted = end;
+    }
+}
+
+#ifndef Z_CHECK_STATIC_CONFIG
+/* ZLog_Close() ends the file; the next one is taken on from its first line */
+static void ZLog_FileWritebackReset(void) {
+    m_writebackAt = 0;
+}
+#endif
+#endif /* FILE_WRITEBACK */
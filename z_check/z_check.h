@@ -31,9 +31,38 @@ extern "C"
  * LOGS
  *      Z_LOG(level, message...)
  *      Z_LOG_IF(condition, level, message...)
+ *      Z_LOG_ERRNO(level, message...)          appends errno, e.g. ": ENOENT (errno 2)"
+ *      Z_LOGB(level, message...)               if configured; C11 callers only
+ *      Z_LOGB_IF(condition, level, message...) if configured; C11 callers only
+ *
+ * BINARY LOGS: Z_CHECK_HAS_LOGB has Z_LOGB() defer formatting its arguments; see Z_LOGB().
+ *
+ * SITE IDS: Z_CHECK_LOGB_IDS writes Z_LOGB() records as call site IDs; see ZLog_BinarySite().
+ *
+ * CALLSITES: Z_CHECK_HAS_CALLSITES registers sites as they first run; see ZLog_CallsiteSet().
+ *
+ * LOG COST: Z_CHECK_HAS_LOG_COST keeps a cycle histogram per site; see ZLog_CostReport().
+ *
+ * TIMERS
+ *      Z_TIME_SCOPE(level, threshold_us, name) if configured; a declaration
+ *
+ * TIMING: Z_CHECK_HAS_TIMING times blocks with per-site histograms; see Z_TIME_SCOPE().
+ *
+ * TRACE SPANS
+ *      Z_TRACE_BEGIN(name)                     if configured
+ *      Z_TRACE_END(name)                       if configured
+ *
+ * TRACING: Z_CHECK_HAS_TRACE writes span frames for Chrome traces; see Z_TRACE_BEGIN().
+ *
+ * HEADER-ONLY MODE: Z_CHECK_HEADER_ONLY checks levels inline; see Integration in README.md.
  *
  * CHECKS
  *      Z_CHECK(condition, new_status, level, message...)
+ *      Z_CHECK_ERRNO(condition, new_status, level, message...)     logs as Z_LOG_ERRNO()
+ *
+ * STATUS NAMES: Z_CHECK_HAS_STATUS_NAMES names Z_CHECK() statuses; see ZLog_StatusDomainAdd().
+ *
+ * ERRNO: Z_LOG_ERRNO() and Z_CHECK_ERRNO() append errno by name; see Z_LOG_ERRNO().
  *
  * DEBUG MACROS: for the above, replace "Z_" with "ZD_" for -DDEBUG only behavior
  *
@@ -55,12 +84,71 @@ extern "C"
  *      Z_STDOUT    same as printf()
  *      Z_STDERR
  *      Z_SYSLOG    if configured
+ *      Z_FILE      appends to Z_CHECK_LOG_FILE_PATH, or the path given to ZLog_OpenFile()
+ *      Z_WRITE     static config only; lines go to Z_CHECK_WRITE_FUNC(buf, len)
+ *      Z_CAPTURE   static config only; lines are kept in memory, see CAPTURE
+ *      Z_NET       static config only; lines go to a collector over TCP or UDP, see NET
+ *      Z_JOURNAL   static config only; entries go to the systemd journal, see JOURNAL
+ *      Z_SPOOL     static config only; lines go to synced segment files, see SPOOL
+ *
+ * In static config the target and formatter are fixed at build time; the others are left out.
+ *
+ * CAPTURE: Z_CAPTURE keeps lines in memory for tests to read back; see ZLog_CaptureGet().
+ *
+ * NET: Z_NET batches lines into numbered frames for a collector; see ZLog_NetStatsGet().
+ *
+ * JOURNAL: Z_JOURNAL sends entries to journald natively; see ZLog_JournalStatsGet().
+ *
+ * DIRECT FILE: Z_CHECK_FILE_DIRECT writes Z_FILE with O_DIRECT; see ZLog_FileDirectStatsGet().
+ *
+ * FILE WRITEBACK: Z_CHECK_FILE_WRITEBACK drops Z_FILE from the cache; ZLog_FileWritebackStatsGet().
+ *
+ * SPOOL: Z_SPOOL commits lines to segment files with shared syncs; see ZLog_SpoolWait().
+ *
+ * THREAD INFO: Z_CHECK_HAS_THREAD_INFO names the thread in each line; see ZLog_ThreadNameSet().
+ *
+ * ARENAS: Z_CHECK_HAS_ARENA gives each logging thread an arena; see ZLog_ArenaStatsGet().
+ *
+ * ASYNC: Z_CHECK_HAS_ASYNC writes records on a thread of its own; see ZLog_AsyncStatsGet().
+ *
+ * SHARED RING: Z_CHECK_HAS_SHARED_RING, one ring for forked processes; see ZLog_SharedRingCreate().
  *
  * METHODS
  *      void ZLog_Open(ZLogType_t logType, ZLogLevel_t logLevel, const char *moduleName)
+ *      void ZLog_OpenFile(const char *path, ZLogLevel_t logLevel, const char *moduleName)
  *      void ZLog_Close(void)
+ *      void ZLog_Flush(void)
  *      void ZLog_LevelSet(ZLogLevel_t logLevel)
  *      void ZLog_LevelReset(void)
+ *      void ZLog_Msg(ZLogLevel_t level, const char *file, int line, const char *func,
+ *                    const char *message)
+ *      void ZLog_Errno(ZLogLevel_t level, const char *file, int line, const char *func,
+ *                      int errnum, const char *format, ...)
+ *      const char * ZLog_ErrnoName(int errnum)
+ *      void ZLog_StatusDomainAdd(ZLogStatusDomain_t *domain)             if configured
+ *      const char * ZLog_StatusName(long status)                         if configured
+ *      void ZLog_ArenaStatsGet(ZLogArenaStats_t *stats)                  if configured
+ *      void ZLog_AsyncStatsGet(ZLogAsyncStats_t *stats)                  if configured
+ *      int ZLog_SharedRingCreate(void)                                   if configured
+ *      unsigned long ZLog_SharedRingDrain(void)                          if configured
+ *      void ZLog_SharedRingStatsGet(ZLogSharedRingStats_t *stats)        if configured
+ *      const char * ZLog_CaptureGet(size_t *len)                         if configured
+ *      void ZLog_CaptureClear(void)                                      if configured
+ *      void ZLog_CaptureStatsGet(ZLogCaptureStats_t *stats)              if configured
+ *      void ZLog_NetStatsGet(ZLogNetStats_t *stats)                      if configured
+ *      void ZLog_JournalStatsGet(ZLogJournalStats_t *stats)              if configured
+ *      unsigned long long ZLog_SpoolTicket(void)                         if configured
+ *      int ZLog_SpoolWait(unsigned long long ticket)                     if configured
+ *      void ZLog_SpoolStatsGet(ZLogSpoolStats_t *stats)                  if configured
+ *      void ZLog_FileDirectStatsGet(ZLogFileDirectStats_t *stats)        if configured
+ *      void ZLog_FileWritebackStatsGet(ZLogFileWritebackStats_t *stats)  if configured
+ *      void ZLog_ThreadNameSet(const char *name)                         if configured
+ *      size_t ZLog_BinaryFormat(char *buf, size_t size, const char *format, const void *args,
+ *                               size_t len)                              if configured
+ *      size_t ZLog_CallsiteSet(const char *file, int line, int enabled)  if configured
+ *      void ZLog_CallsiteForEach(ZLogCallsiteFn_t fn, void *context)     if configured
+ *      void ZLog_CostReport(unsigned top)                                if configured
+ *      void ZLog_TimeForEach(ZLogTimeSiteFn_t fn, void *context)         if configured
  */
 
 /******************************************************************************
@@ -80,21 +168,251 @@ extern "C"
 
 /**
  * Configuration instructions: Only change lines that contain the "SET" comment.
+ *
+ * Alternatively, define Z_CHECK_CONFIG_FILE (e.g. -DZ_CHECK_CONFIG_FILE='"my_config.h"') to
+ * take the first block of SET lines from that file instead. Tunables further down keep their
+ * defaults unless the file sets them too.
  */
 
+#ifdef Z_CHECK_CONFIG_FILE
+    #include Z_CHECK_CONFIG_FILE
+#else
 #define Z_CHECK_HAS_SYSLOG      /* SET -- comment out if syslog not supported */
 #define Z_CHECK_STATIC_CONFIG   /* SET -- comment out if using dynamic config */
+/* #define Z_CHECK_HAS_ARENA        SET -- define for per-thread record arenas (needs pthreads) */
+/* #define Z_CHECK_HAS_ASYNC        SET -- define to write from a writer thread (needs arenas) */
+/* #define Z_CHECK_FREESTANDING     SET -- define to build without stdio (needs static config) */
+/* #define Z_CHECK_LOW_STACK        SET -- define to format in per-thread static buffers */
+/* #define Z_CHECK_HEADER_ONLY      SET -- define to check levels inline (see REFERENCE) */
+/* #define Z_CHECK_HAS_LOGB         SET -- define for Z_LOGB binary logging (see REFERENCE) */
+/* #define Z_CHECK_LOGB_IDS         SET -- define to write Z_LOGB records as site IDs */
+/* #define Z_CHECK_HAS_CALLSITES    SET -- define for per-site switches */
+/* #define Z_CHECK_HAS_CALLSITE_HITS SET -- define to count each site's runs (needs callsites) */
+/* #define Z_CHECK_HAS_LOG_COST     SET -- define to time each site's calls (needs callsites) */
+/* #define Z_CHECK_HAS_TIMING       SET -- define for Z_TIME_SCOPE() timers */
+/* #define Z_CHECK_HAS_TRACE        SET -- define for Z_TRACE_BEGIN()/END() (needs site IDs) */
+/* #define Z_CHECK_HAS_STATUS_NAMES SET -- define to name Z_CHECK() statuses in its message */
+/* #define Z_CHECK_HAS_THREAD_INFO  SET -- define to put thread ID and name in each line */
+/* #define Z_CHECK_HAS_SHARED_RING  SET -- define for a ring forked processes log through */
+/* #define Z_CHECK_FILE_DIRECT      SET -- define for static Z_FILE to skip the page cache */
+/* #define Z_CHECK_FILE_WRITEBACK   SET -- define to drop Z_FILE's lines from the cache */
+
+#ifdef Z_CHECK_STATIC_CONFIG
+    #define Z_CHECK_MODULE_NAME     "main"      /* SET */
+    #define Z_CHECK_LOG_FUNC        Z_STDOUT    /* SET -- any LOG TARGET */
+    #define Z_CHECK_INIT_LOG_LEVEL  Z_INFO      /* SET */
+    #define Z_CHECK_WRITE_FUNC      z_check_write   /* SET -- hook for Z_WRITE */
+#endif
+#endif /* Z_CHECK_CONFIG_FILE */
 
 #ifdef Z_CHECK_STATIC_CONFIG
     #undef Z_CHECK_HAS_SYSLOG
     #define Z_STDOUT    0   /* same as printf() */
     #define Z_STDERR    1
-
-    #define Z_CHECK_MODULE_NAME     "main"      /* SET */
-    #define Z_CHECK_LOG_FUNC        Z_STDOUT    /* SET */
-    #define Z_CHECK_INIT_LOG_LEVEL  Z_INFO      /* SET */
+    #define Z_WRITE     2   /* whole lines to Z_CHECK_WRITE_FUNC(buf, len) */
+    #define Z_SYSLOG    3
+    #define Z_FILE      4
+    #define Z_CAPTURE   5   /* whole lines to a buffer in memory, see ZLog_CaptureGet() */
+    #define Z_NET       6   /* whole lines, batched into frames, to a collector over TCP or UDP */
+    #define Z_JOURNAL   7   /* structured entries to journald over its native protocol */
+    #define Z_SPOOL     8   /* whole lines to segment files, group-committed with fdatasync() */
 #else
+    #ifndef Z_CHECK_MODULE_NAME_MAX_LEN
     #define Z_CHECK_MODULE_NAME_MAX_LEN 16      /* SET */
+    #endif
+#endif
+
+#ifndef Z_CHECK_LOG_FILE_PATH
+#define Z_CHECK_LOG_FILE_PATH   "z_check.log"   /* SET -- for Z_FILE */
+#endif
+
+#define Z_FMT_LIBC      0   /* vsnprintf() */
+#define Z_FMT_COMPACT   1   /* built-in printf() subset, see Z_CHECK_FMT_HAS_* */
+#ifndef Z_CHECK_FORMATTER
+    #ifdef Z_CHECK_FREESTANDING
+    #define Z_CHECK_FORMATTER   Z_FMT_COMPACT
+    #else
+    #define Z_CHECK_FORMATTER   Z_FMT_LIBC  /* SET */
+    #endif
+#endif
+
+#if defined(Z_CHECK_HAS_ARENA) || defined(Z_CHECK_LOW_STACK) || defined(Z_CHECK_HAS_TRACE) || \
+    defined(Z_CHECK_HAS_THREAD_INFO) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SPOOL))
+    #ifndef Z_CHECK_THREAD_LOCAL
+    #define Z_CHECK_THREAD_LOCAL    __thread    /* SET -- empty if single-threaded without TLS */
+    #endif
+#endif
+
+#if Z_CHECK_FORMATTER == Z_FMT_COMPACT
+    /* The built-in formatter always handles %d %i %u %c %s and %%. Extras cost flash. */
+    #ifndef Z_CHECK_FMT_HAS_LONG
+    #define Z_CHECK_FMT_HAS_LONG    0   /* SET -- 1 for l, ll and z length modifiers */
+    #endif
+    #ifndef Z_CHECK_FMT_HAS_HEX
+    #define Z_CHECK_FMT_HAS_HEX     1   /* SET -- 1 for %x, %X and %p */
+    #endif
+    #ifndef Z_CHECK_FMT_HAS_WIDTH
+    #define Z_CHECK_FMT_HAS_WIDTH   0   /* SET -- 1 for '-' and '0' flags, width and precision */
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_ARENA
+    #ifndef Z_CHECK_ARENA_MAX_THREADS
+    #define Z_CHECK_ARENA_MAX_THREADS   16      /* SET -- arenas; threads beyond this get none */
+    #endif
+    #ifndef Z_CHECK_ARENA_BLOCKS_256
+    #define Z_CHECK_ARENA_BLOCKS_256    32      /* SET -- 256 byte blocks per arena */
+    #endif
+    #ifndef Z_CHECK_ARENA_BLOCKS_1K
+    #define Z_CHECK_ARENA_BLOCKS_1K     8       /* SET -- 1 KiB blocks per arena */
+    #endif
+    #ifndef Z_CHECK_ARENA_BLOCKS_4K
+    #define Z_CHECK_ARENA_BLOCKS_4K     2       /* SET -- 4 KiB blocks per arena */
+    #endif
+    #ifndef Z_CHECK_ARENA_GROW_STEPS
+    #define Z_CHECK_ARENA_GROW_STEPS    4       /* SET -- steps to carve a class's blocks in */
+    #endif
+    #ifndef Z_CHECK_ARENA_BUDGET
+    #define Z_CHECK_ARENA_BUDGET        0       /* SET -- bytes of blocks, all arenas; 0: no cap */
+    #endif
+    #define Z_CHECK_ARENA_CLASSES       3       /* number of size classes above */
+#endif
+
+#ifdef Z_CHECK_HAS_SHARED_RING
+    #ifndef Z_CHECK_SHARED_RING_SLOTS
+    #define Z_CHECK_SHARED_RING_SLOTS   1024    /* SET -- lines the ring holds */
+    #endif
+    #ifndef Z_CHECK_SHARED_RING_DATA
+    #define Z_CHECK_SHARED_RING_DATA    768     /* SET -- bytes per slot for file, func, message */
+    #endif
+    #ifndef Z_CHECK_SHARED_RING_STALL_MS
+    #define Z_CHECK_SHARED_RING_STALL_MS 1000   /* SET -- wait on a claim that named no process */
+    #endif
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_CAPTURE)
+    #ifndef Z_CHECK_CAPTURE_SIZE
+    #define Z_CHECK_CAPTURE_SIZE    65536   /* SET -- bytes kept; 0 for a null sink that counts */
+    #endif
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)
+    #ifndef Z_CHECK_NET_ADDR
+    #define Z_CHECK_NET_ADDR        "127.0.0.1" /* SET -- the collector's IPv4 address */
+    #endif
+    #ifndef Z_CHECK_NET_PORT
+    #define Z_CHECK_NET_PORT        5140        /* SET */
+    #endif
+    #ifndef Z_CHECK_NET_UDP
+    #define Z_CHECK_NET_UDP         0           /* SET -- 1 for datagrams instead of TCP */
+    #endif
+    #ifndef Z_CHECK_NET_BATCH
+    #define Z_CHECK_NET_BATCH       1400        /* SET -- line bytes per frame */
+    #endif
+    #ifndef Z_CHECK_NET_LINGER_MS
+    #define Z_CHECK_NET_LINGER_MS   20          /* SET -- longest a line waits for its frame */
+    #endif
+    #ifndef Z_CHECK_NET_SPOOL
+    #define Z_CHECK_NET_SPOOL       262144      /* SET -- frame bytes kept while not sent */
+    #endif
+    #ifndef Z_CHECK_NET_RETRY_MS
+    #define Z_CHECK_NET_RETRY_MS    100         /* SET -- first reconnect delay, doubling */
+    #endif
+    #ifndef Z_CHECK_NET_RETRY_MAX_MS
+    #define Z_CHECK_NET_RETRY_MAX_MS 5000       /* SET */
+    #endif
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_JOURNAL)
+    #ifndef Z_CHECK_JOURNAL_SOCKET
+    #define Z_CHECK_JOURNAL_SOCKET  "/run/systemd/journal/socket"   /* SET */
+    #endif
+    #ifndef Z_CHECK_JOURNAL_MEMFD_OVER
+    #define Z_CHECK_JOURNAL_MEMFD_OVER  0   /* SET -- bytes; 0: only what the socket refuses */
+    #endif
+    #ifndef Z_CHECK_JOURNAL_BATCH
+    #define Z_CHECK_JOURNAL_BATCH   16      /* SET -- entries per send from the writer thread */
+    #endif
+    #ifndef Z_CHECK_JOURNAL_BATCH_BYTES
+    #define Z_CHECK_JOURNAL_BATCH_BYTES 32768   /* SET */
+    #endif
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT)
+    #ifndef Z_CHECK_FILE_DIRECT_BLOCK
+    #define Z_CHECK_FILE_DIRECT_BLOCK   4096    /* SET -- write alignment, the device's or more */
+    #endif
+    #ifndef Z_CHECK_FILE_DIRECT_BUFFER
+    #define Z_CHECK_FILE_DIRECT_BUFFER  1048576 /* SET -- bytes per write, in whole blocks */
+    #endif
+    #ifndef Z_CHECK_FILE_DIRECT_LINGER_MS
+    #define Z_CHECK_FILE_DIRECT_LINGER_MS 200   /* SET -- longest a line waits to reach the file */
+    #endif
+#endif
+
+#if defined(Z_CHECK_FILE_WRITEBACK) && \
+    (!defined(Z_CHECK_STATIC_CONFIG) || (Z_CHECK_LOG_FUNC == Z_FILE))
+    #ifndef Z_CHECK_FILE_WRITEBACK_MS
+    #define Z_CHECK_FILE_WRITEBACK_MS     1000    /* SET -- time between writer thread passes */
+    #endif
+    #ifndef Z_CHECK_FILE_WRITEBACK_WINDOW
+    #define Z_CHECK_FILE_WRITEBACK_WINDOW 8388608 /* SET -- bytes, in whole pages */
+    #endif
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SPOOL)
+    #ifndef Z_CHECK_SPOOL_DIR
+    #define Z_CHECK_SPOOL_DIR       "z_check.spool" /* SET -- created if missing */
+    #endif
+    #ifndef Z_CHECK_SPOOL_SEGMENT
+    #define Z_CHECK_SPOOL_SEGMENT   16777216    /* SET -- bytes in a segment before the next */
+    #endif
+    #ifndef Z_CHECK_SPOOL_BUFFER
+    #define Z_CHECK_SPOOL_BUFFER    262144      /* SET -- bytes gathering, and again committing */
+    #endif
+    #ifndef Z_CHECK_SPOOL_COMMIT_MS
+    #define Z_CHECK_SPOOL_COMMIT_MS 100         /* SET -- longest a line nobody waits for waits */
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_CALLSITES
+    #ifndef Z_CHECK_CALLSITE_RULES
+    #define Z_CHECK_CALLSITE_RULES  16      /* SET -- ZLog_CallsiteSet() calls kept for new sites */
+    #endif
+#endif
+
+#if defined(Z_CHECK_HAS_CALLSITE_HITS) && !defined(Z_CHECK_HAS_CALLSITES)
+    #error "Z_CHECK_HAS_CALLSITE_HITS counts in callsites; define Z_CHECK_HAS_CALLSITES"
+#endif
+
+#ifdef Z_CHECK_HAS_LOG_COST
+    #ifndef Z_CHECK_LOG_COST_BUCKETS
+    #define Z_CHECK_LOG_COST_BUCKETS    96  /* SET -- 4 per power of two; 96 reach 2^24 cycles */
+    #endif
+    #if !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__)
+    #error "Z_CHECK_HAS_LOG_COST reads the cycle counter of x86 or AArch64"
+    #endif
+    #ifndef Z_CHECK_HAS_CALLSITES
+    #error "Z_CHECK_HAS_LOG_COST keeps its histograms in callsites; define Z_CHECK_HAS_CALLSITES"
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+    #ifndef Z_CHECK_TIME_BUCKETS
+    #define Z_CHECK_TIME_BUCKETS    24      /* SET -- histogram buckets; the last one is open */
+    #endif
+#endif
+
+#ifdef Z_CHECK_HAS_LOGB
+    #ifndef Z_CHECK_LOGB_STR_MAX
+    #define Z_CHECK_LOGB_STR_MAX    64      /* SET -- bytes kept of each Z_LOGB() string */
+    #endif
+#endif
+
+
+#if defined(Z_CHECK_HEADER_ONLY) && !defined(Z_CHECK_FREESTANDING)
+#include <stdio.h>  /* for the inline sink */
 #endif
 
 
@@ -114,6 +432,111 @@ extern "C"
 #define Z_CT_ASSERT_GUTS_LINE(cond,line) Z_CT_ASSERT_GUTS_DETOKENIZE(cond,line)
 #define Z_CT_ASSERT_GUTS(cond) Z_CT_ASSERT_GUTS_LINE(cond, __LINE__)
 
+/**
+ * \brief Level names, indexed by ZLogLevel_t, and the layout of a log line
+ */
+#define Z_CHECK_LEVEL_NAMES \
+    "EMERGENCY", "ALERT", "CRITICAL", "ERROR", "WARNING", "NOTICE", "INFO", "DEBUG"
+#ifdef Z_CHECK_HAS_THREAD_INFO
+/* module, level, thread ID, thread name, file, line, func, msg */
+#define Z_CHECK_LINE_FORMAT "%s: [%s] [%lu %s] %s:%d:%s: %s\n"
+#else
+#define Z_CHECK_LINE_FORMAT "%s: [%s] %s:%d:%s: %s\n" /* module, level, file, line, func, msg */
+#endif
+
+/**
+ * \brief Header-only dispatch: constant messages without conversions skip formatting
+ *
+ * \details
+ * Z_LOG_FIRST() picks out the format; the extra argument keeps a lone format legal in C99.
+ * Without optimization __builtin_constant_p() is false, and everything goes through ZLog().
+ */
+#define Z_LOG_FIRST(first, ...) first
+#define Z_LOG_IS_CONST_MSG(format) \
+    (__builtin_constant_p(NULL == __builtin_strchr(format, '%')) && \
+     (NULL == __builtin_strchr(format, '%')))
+#define Z_LOG_DISPATCH(level, file, line, func, ...) \
+    (Z_LOG_IS_CONST_MSG(Z_LOG_FIRST(__VA_ARGS__, 0)) \
+        ? Z_LOG_MSG(level, file, line, func, Z_LOG_FIRST(__VA_ARGS__, 0)) \
+        : ZLog(level, file, line, func, __VA_ARGS__))
+
+/**
+ * \brief Callsite descriptor for the enclosing Z_LOG()/Z_LOGB(), and its run-time switch
+ *
+ * \details
+ * The descriptor is plain static data, so it costs nothing until the site runs.
+ */
+#ifdef Z_CHECK_HAS_CALLSITE_HITS
+#define Z_CALLSITE_HITS , 0
+#else
+#define Z_CALLSITE_HITS
+#endif
+#if defined(Z_CHECK_HAS_CALLSITES) && defined(Z_CHECK_HAS_LOG_COST)
+/* the histogram is zeroed, so it goes apart from the descriptor into .bss */
+#define Z_CALLSITE(name) \
+    static ZLogCost_t name##Cost; \
+    static ZLogCallsite_t name = \
+        { NULL, __FILE__, __func__, __LINE__, 0, 1 Z_CALLSITE_HITS, &name##Cost }
+#elif defined(Z_CHECK_HAS_CALLSITES)
+#define Z_CALLSITE(name) \
+    static ZLogCallsite_t name = { NULL, __FILE__, __func__, __LINE__, 0, 1 Z_CALLSITE_HITS }
+#else
+#define Z_CALLSITE(name)
+#endif
+#ifdef Z_CHECK_HAS_CALLSITES
+#define Z_CALLSITE_ENABLED(name) ZLog_CallsiteEnabled(&(name))
+#else
+#define Z_CALLSITE_ENABLED(name) 1
+#endif
+
+/**
+ * \brief Read the cycle counter around a site's call into the library; one read each side
+ *
+ * \details
+ * Z_LOG_COST_BEGIN() is a declaration, so it opens the block it is in. It brings its own
+ * semicolon, so that with the option off no empty statement comes before the block's other
+ * declarations.
+ */
+#ifdef Z_CHECK_HAS_LOG_COST
+#define Z_LOG_COST_BEGIN(name) const unsigned long long name##Start = ZLog_Cycles();
+#define Z_LOG_COST_END(name) ZLog_CostAdd(&(name), ZLog_Cycles() - name##Start)
+#else
+#define Z_LOG_COST_BEGIN(name)
+#define Z_LOG_COST_END(name)
+#endif
+
+/**
+ * \brief Call site laid down in the z_check_sites section, where its index is its ID
+ *
+ * \details
+ * The aligned attribute keeps the compiler from padding sites apart, so the section is an array.
+ */
+#ifdef Z_CHECK_LOGB_IDS
+#define Z_LOG_SITE(name, format) \
+    static const ZLogSite_t name \
+        __attribute__((section("z_check_sites"), used, aligned(sizeof(void *)))) = \
+        { format, __FILE__, __func__, __LINE__ }
+#endif
+
+/**
+ * \brief Timer site for the enclosing Z_TIME_SCOPE(), named apart from others in the function
+ */
+#ifdef Z_CHECK_HAS_TIMING
+#define Z_TIME_CAT_(a, b) a##b
+#define Z_TIME_CAT(a, b) Z_TIME_CAT_(a, b)
+#define Z_TIME_NAME(name) Z_TIME_CAT(name, __LINE__)
+#if defined(Z_CHECK_HAS_CALLSITES) && defined(Z_CHECK_HAS_LOG_COST)
+#define Z_TIME_SITE_CALLSITE , { NULL, __FILE__, __func__, __LINE__, 0, 1 Z_CALLSITE_HITS, NULL }
+#elif defined(Z_CHECK_HAS_CALLSITES)
+#define Z_TIME_SITE_CALLSITE , { NULL, __FILE__, __func__, __LINE__, 0, 1 Z_CALLSITE_HITS }
+#else
+#define Z_TIME_SITE_CALLSITE
+#endif
+#define Z_TIME_SITE(name, scopeName) \
+    static ZLogTimeSite_t name = \
+        { NULL, __FILE__, __func__, scopeName, __LINE__, 0, 0, 0, 0, { 0 } Z_TIME_SITE_CALLSITE }
+#endif
+
 /**
  * \brief Instead of getting the full path, get just the filename
  */
@@ -143,8 +566,61 @@ extern "C"
 /**
  * \brief Log a message
  */
-#define Z_LOG(level, ...) \
+#ifdef Z_CHECK_HEADER_ONLY
+#define Z_LOG_CALL(level, ...) \
+    (ZLog_LevelEnabled(level) \
+        ? Z_LOG_DISPATCH(level, __FILENAME__, __LINE__, __func__, __VA_ARGS__) \
+        : (void)0)
+#define Z_LOG_ERRNO_CALL(level, errnum, ...) \
+    (ZLog_LevelEnabled(level) \
+        ? ZLog_Errno(level, __FILENAME__, __LINE__, __func__, errnum, __VA_ARGS__) \
+        : (void)0)
+#define Z_LOG_CHECK_CALL(level, status, errnum, ...) \
+    (ZLog_LevelEnabled(level) \
+        ? ZLog_Check(level, __FILENAME__, __LINE__, __func__, status, errnum, __VA_ARGS__) \
+        : (void)0)
+#else
+#define Z_LOG_CALL(level, ...) \
     ZLog(level, __FILENAME__, __LINE__, __func__, __VA_ARGS__)
+#define Z_LOG_ERRNO_CALL(level, errnum, ...) \
+    ZLog_Errno(level, __FILENAME__, __LINE__, __func__, errnum, __VA_ARGS__)
+#define Z_LOG_CHECK_CALL(level, status, errnum, ...) \
+    ZLog_Check(level, __FILENAME__, __LINE__, __func__, status, errnum, __VA_ARGS__)
+#endif
+
+/* A call into the library, through the enclosing site's descriptor when there are callsites.
+ * Either way it is a void expression, so Z_LOG() also fits in `c ? Z_LOG(...) : (void)0` and
+ * `(Z_LOG(...), x)`; the descriptor needs a block, hence the statement expression. */
+#ifdef Z_CHECK_HAS_CALLSITES
+#define Z_LOG_AT_SITE(call) \
+    __extension__ ({ \
+        Z_CALLSITE(zLogSite_); \
+        if (Z_CALLSITE_ENABLED(zLogSite_)) { \
+            Z_LOG_COST_BEGIN(zLogSite_) \
+            (void)(call); \
+            Z_LOG_COST_END(zLogSite_); \
+        } \
+        (void)0; \
+    })
+#define Z_LOG(level, ...) Z_LOG_AT_SITE(Z_LOG_CALL(level, __VA_ARGS__))
+#else
+#define Z_LOG_AT_SITE(call) (void)(call)
+#define Z_LOG Z_LOG_CALL
+#endif
+
+/**
+ * \brief Log a message followed by errno, read before anything else can change it
+ *
+ * \details
+ * The number is handed to the library, which names it from a table once the level has passed,
+ * and puts errno back after. Callers no longer need strerror(), which is not thread-safe and ran
+ * even for filtered levels. Z_CHECK_ERRNO() does the same.
+ */
+#define Z_LOG_ERRNO(level, ...) \
+    do { \
+        const int zErrno_ = errno; \
+        Z_LOG_AT_SITE(Z_LOG_ERRNO_CALL(level, zErrno_, __VA_ARGS__)); \
+    } while(0)
 
 /**
  * \brief Conditionally log a message
@@ -169,6 +645,17 @@ extern "C"
  * \param[IN]   ZLogLevel_t level: the importance level of the error
  * \param[IN]   __VA_ARGS__: the formatted error message
  */
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+#define Z_CHECK(condition, new_status, level, ...) \
+    do { \
+        if (condition) { \
+            const __typeof__(new_status) zStatus_ = (new_status); \
+            Z_LOG_AT_SITE(Z_LOG_CHECK_CALL(level, (long)zStatus_, -1, __VA_ARGS__)); \
+            status = zStatus_; \
+            goto cleanup; \
+        } \
+    } while(0)
+#else
 #define Z_CHECK(condition, new_status, level, ...) \
     do { \
         if (condition) { \
@@ -177,6 +664,109 @@ extern "C"
             goto cleanup; \
         } \
     } while(0)
+#endif
+
+/**
+ * \brief Z_CHECK() for a failed call that set errno, which is appended to the message
+ *
+ * \details
+ * errno is read once condition is true, and is still set at the cleanup label.
+ */
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+#define Z_CHECK_ERRNO(condition, new_status, level, ...) \
+    do { \
+        if (condition) { \
+            const int zErrno_ = errno; \
+            const __typeof__(new_status) zStatus_ = (new_status); \
+            Z_LOG_AT_SITE(Z_LOG_CHECK_CALL(level, (long)zStatus_, zErrno_, __VA_ARGS__)); \
+            status = zStatus_; \
+            goto cleanup; \
+        } \
+    } while(0)
+#else
+#define Z_CHECK_ERRNO(condition, new_status, level, ...) \
+    do { \
+        if (condition) { \
+            Z_LOG_ERRNO(level, __VA_ARGS__); \
+            status = new_status; \
+            goto cleanup; \
+        } \
+    } while(0)
+#endif
+
+/**
+ * \brief Define a domain of status codes and their names, for ZLog_StatusDomainAdd()
+ *
+ * \details
+ * Defines a static ZLogStatusDomain_t called name, covering first and the codes after it, one per
+ * name given. Gaps can be left NULL, or named with designated initializers counted from first.
+ *
+ * \param[IN]   name: the domain's variable name
+ * \param[IN]   long first: the lowest code in the domain
+ * \param[IN]   __VA_ARGS__: names of first, first + 1, ..., as string literals
+ */
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+#define Z_STATUS_DOMAIN(name, first, ...) \
+    static const char * const name##Names_[] = { __VA_ARGS__ }; \
+    static ZLogStatusDomain_t name = \
+        { NULL, first, sizeof(name##Names_) / sizeof(name##Names_[0]), name##Names_, 0 }
+#endif
+
+/**
+ * \brief Time the rest of the enclosing block, logging when it runs over a threshold
+ *
+ * \details
+ * With Z_CHECK_HAS_TIMING, reads a monotonic clock where it is declared and again where the block
+ * is left, however that happens (a cleanup handler in C, a destructor in C++). Every run goes
+ * into the site's histogram; runs over threshold_us are also logged at level, through the site's
+ * own callsite when Z_CHECK_HAS_CALLSITES is defined. The site registers itself the first time it
+ * ends.
+ *
+ * A declaration, so it goes with the block's other declarations; one per line. The cost on
+ * each run is two clock reads and a few relaxed atomic adds.
+ *
+ * \param[IN]   ZLogLevel_t level: the importance level of the slow-run message
+ * \param[IN]   unsigned long threshold_us: runs longer than this many microseconds are logged
+ * \param[IN]   char * name: what is being timed, a string literal
+ */
+#ifdef Z_CHECK_HAS_TIMING
+#ifdef __cplusplus
+#define Z_TIME_SCOPE(level, threshold_us, name) \
+    Z_TIME_SITE(Z_TIME_NAME(zTimeSite_), name); \
+    const ZLogTimeGuard_s Z_TIME_NAME(zTimeScope_)(&Z_TIME_NAME(zTimeSite_), level, threshold_us)
+#else
+#define Z_TIME_SCOPE(level, threshold_us, name) \
+    Z_TIME_SITE(Z_TIME_NAME(zTimeSite_), name); \
+    ZLogTimeScope_t Z_TIME_NAME(zTimeScope_) __attribute__((cleanup(ZLog_TimeScopeEnd))) = \
+        { &Z_TIME_NAME(zTimeSite_), level, threshold_us, ZLog_TimeNow() }
+#endif
+#endif /* Z_CHECK_HAS_TIMING */
+
+/**
+ * \brief Mark where a span of work begins or ends on this thread
+ *
+ * \details
+ * With Z_CHECK_HAS_TRACE as well as Z_CHECK_LOGB_IDS, span begin and end points are sites in the
+ * z_check_sites section too, written as small frames of site ID, thread and timestamp. They take
+ * the same path as records, through the caller's arena when async. Each text line and record
+ * frame is stamped with its thread and time as well, so `tools/zlogb.py trace` can turn a log
+ * into Chrome trace-event JSON for Perfetto, with spans as slices and log records, Z_CHECK()
+ * failures included, as instant events.
+ *
+ * Spans nest per thread; each Z_TRACE_END() closes the latest open span, and its name is only
+ * for the reader.
+ *
+ * \param[IN]   char * name: what the span covers, a string literal
+ */
+#ifdef Z_CHECK_HAS_TRACE
+#define Z_TRACE_BEGIN(name) Z_TRACE_SPAN('B', name)
+#define Z_TRACE_END(name) Z_TRACE_SPAN('E', name)
+#define Z_TRACE_SPAN(kind, name) \
+    do { \
+        Z_LOG_SITE(zTraceSite_, name); \
+        ZLog_TraceSpan(kind, &zTraceSite_); \
+    } while(0)
+#endif
 
 /**
  * \brief Prevent warnings when compiling with -Wunused-label
@@ -205,13 +795,24 @@ static inline void _macro_unused(const int dummy, ...) {UNUSED_VARIABLE(dummy);}
 #define ZD_LOG(...)             _macro_unused(__VA_ARGS__)
 #define ZD_LOG_IF(...)          _macro_unused(__VA_ARGS__)
 #define ZD_CHECK(...)           _macro_unused(__VA_ARGS__)
+#define ZD_LOG_ERRNO(...)       _macro_unused(__VA_ARGS__)
+#define ZD_CHECK_ERRNO(...)     _macro_unused(__VA_ARGS__)
+#ifdef Z_CHECK_HAS_TIMING
+/* still a declaration, so blocks keep their shape */
+#define ZD_TIME_SCOPE(...)      typedef int Z_TIME_NAME(zTimeScopeOff_) __attribute__((unused))
+#endif
 #else
 #define ZD_CT_ASSERT_DECL   Z_CT_ASSERT_DECL
 #define ZD_CT_ASSERT_CODE   Z_CT_ASSERT_CODE
 #define ZD_RT_ASSERT        Z_RT_ASSERT
 #define ZD_CHECK            Z_CHECK
+#define ZD_CHECK_ERRNO      Z_CHECK_ERRNO
+#define ZD_LOG_ERRNO        Z_LOG_ERRNO
 #define ZD_LOG              Z_LOG
 #define ZD_LOG_IF           Z_LOG_IF
+#ifdef Z_CHECK_HAS_TIMING
+#define ZD_TIME_SCOPE       Z_TIME_SCOPE
+#endif
 #endif
 
 /******************************************************************************
@@ -238,9 +839,225 @@ typedef enum ZLogType_e
 #ifdef Z_CHECK_HAS_SYSLOG
     Z_SYSLOG,
 #endif
+    Z_FILE,
 } ZLogType_t;
 #endif /* Z_CHECK_STATIC_CONFIG */
 
+#ifdef Z_CHECK_HAS_ARENA
+/* Arena counters, summed over all arenas. Per-class arrays go 256 B, 1 KiB, 4 KiB. */
+typedef struct ZLogArenaStats_s
+{
+    unsigned long arenasInUse;                          /* arenas owned by a live thread */
+    unsigned long arenasTouched;                        /* arenas ever owned; the rest untouched */
+    unsigned long bytesCarved;                          /* arena storage split into blocks */
+    unsigned long overBudget;                           /* growths refused by the budget */
+    unsigned long allocs[Z_CHECK_ARENA_CLASSES];        /* blocks handed out */
+    unsigned long frees[Z_CHECK_ARENA_CLASSES];         /* blocks given back, including remote */
+    unsigned long remoteFrees[Z_CHECK_ARENA_CLASSES];   /* given back by a non-owning thread */
+    unsigned long inUse[Z_CHECK_ARENA_CLASSES];         /* blocks currently handed out */
+    unsigned long highWater[Z_CHECK_ARENA_CLASSES];     /* most blocks out at once, any arena */
+    unsigned long failures;                             /* no free block of a fitting class */
+    unsigned long noArena;                              /* all arenas were owned by others */
+} ZLogArenaStats_t;
+#endif /* Z_CHECK_HAS_ARENA */
+
+#ifdef Z_CHECK_HAS_ASYNC
+/* Writer thread counters */
+typedef struct ZLogAsyncStats_s
+{
+    unsigned long queued;       /* records handed to the writer */
+    unsigned long written;      /* records the writer has passed to the sink */
+    unsigned long dropped;      /* records lost because the caller's arena was exhausted */
+} ZLogAsyncStats_t;
+#endif /* Z_CHECK_HAS_ASYNC */
+
+#ifdef Z_CHECK_HAS_SHARED_RING
+/* Shared ring counters, over all the processes sharing it */
+typedef struct ZLogSharedRingStats_s
+{
+    unsigned long claimed;      /* slots taken by writers, published or not */
+    unsigned long appended;     /* lines published to the ring */
+    unsigned long drained;      /* lines handed to the sink */
+    unsigned long dropped;      /* lines not written because the ring was full */
+    unsigned long recovered;    /* slots freed after their writer died or stalled */
+    unsigned long lost;         /* lines whose slot was freed before they were published */
+} ZLogSharedRingStats_t;
+#endif /* Z_CHECK_HAS_SHARED_RING */
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_CAPTURE)
+/* Capture sink counters, since the start of the process */
+typedef struct ZLogCaptureStats_s
+{
+    unsigned long lines;        /* handed to the sink, kept or not */
+    unsigned long bytes;        /* in those lines */
+    unsigned long dropped;      /* lines that did not fit in the buffer */
+} ZLogCaptureStats_t;
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)
+/* Network sink counters, since the start of the process */
+typedef struct ZLogNetStats_s
+{
+    unsigned long lines;        /* lines taken in */
+    unsigned long frames;       /* frames sealed; the next one's sequence number */
+    unsigned long sent;         /* frames handed whole to the socket */
+    unsigned long dropped;      /* frames lost to a full spool; gaps in the numbers */
+    unsigned long connects;     /* connections made, the first included */
+    unsigned long failures;     /* connections that failed or broke */
+    unsigned long spooled;      /* bytes waiting to be sent */
+} ZLogNetStats_t;
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_JOURNAL)
+/* Journal sink counters, since the start of the process */
+typedef struct ZLogJournalStats_s
+{
+    unsigned long entries;      /* entries taken in */
+    unsigned long sent;         /* entries journald's socket took */
+    unsigned long memfds;       /* of those, passed as memory files */
+    unsigned long batches;      /* sends of gathered entries from the writer thread */
+    unsigned long dropped;      /* entries nobody took, e.g. with no journald running */
+} ZLogJournalStats_t;
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT)
+/* Direct file sink counters, since the start of the process */
+typedef struct ZLogFileDirectStats_s
+{
+    unsigned long lines;        /* lines taken in */
+    unsigned long bytes;        /* in those lines */
+    unsigned long writes;       /* writes of whole blocks */
+    unsigned long tails;        /* of those, writes ending in a padded block, written again */
+    unsigned long failures;     /* writes that failed, and lines that found no file open */
+    unsigned long buffered;     /* 1 if the file system refused O_DIRECT */
+} ZLogFileDirectStats_t;
+#endif
+
+#if defined(Z_CHECK_FILE_WRITEBACK) && \
+    (!defined(Z_CHECK_STATIC_CONFIG) || (Z_CHECK_LOG_FUNC == Z_FILE))
+/* File writeback counters, since the start of the process */
+typedef struct ZLogFileWritebackStats_s
+{
+    unsigned long passes;       /* writer thread passes over the file */
+    unsigned long started;      /* bytes sent to writeback */
+    unsigned long dropped;      /* bytes written back and dropped from the page cache */
+    unsigned long failures;     /* calls the kernel refused */
+} ZLogFileWritebackStats_t;
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SPOOL)
+/* Spool sink counters, since the start of the process */
+typedef struct ZLogSpoolStats_s
+{
+    unsigned long lines;        /* lines taken in; the last ticket handed out */
+    unsigned long bytes;        /* in those lines */
+    unsigned long commits;      /* batches written and synced, one fdatasync() each */
+    unsigned long failures;     /* of those, the ones whose write or sync failed */
+    unsigned long segments;     /* segments opened */
+    unsigned long stalls;       /* times a line waited for room in the buffer */
+} ZLogSpoolStats_t;
+#endif
+
+#ifdef Z_CHECK_HAS_LOG_COST
+/* Cycles a site has spent in its calls into the library */
+typedef struct ZLogCost_s
+{
+    unsigned long calls;
+    unsigned long long cycles;                      /* total */
+    unsigned long long maxCycles;
+    unsigned buckets[Z_CHECK_LOG_COST_BUCKETS];     /* [n] for n < 4, then 4 per power of two */
+} ZLogCost_t;
+#endif /* Z_CHECK_HAS_LOG_COST */
+
+#ifdef Z_CHECK_HAS_CALLSITES
+/* A Z_LOG(), Z_CHECK() or Z_LOGB() call site; see Z_CALLSITE() */
+typedef struct ZLogCallsite_s
+{
+    struct ZLogCallsite_s *next;    /* registry link, set when the site first runs */
+    const char *file;               /* __FILE__ */
+    const char *func;
+    int line;
+    int state;                      /* 0 new, 1 registering, 2 registered */
+    int enabled;                    /* switched by ZLog_CallsiteSet() */
+#ifdef Z_CHECK_HAS_CALLSITE_HITS
+    unsigned long hits;             /* times run, logged or not */
+#endif
+#ifdef Z_CHECK_HAS_LOG_COST
+    ZLogCost_t *cost;               /* NULL for sites that are not timed */
+#endif
+} ZLogCallsite_t;
+
+typedef void (*ZLogCallsiteFn_t)(const ZLogCallsite_t *site, void *context);
+#endif /* Z_CHECK_HAS_CALLSITES */
+
+#ifdef Z_CHECK_HAS_TIMING
+/* A Z_TIME_SCOPE() site and the durations seen there; see Z_TIME_SITE() */
+typedef struct ZLogTimeSite_s
+{
+    struct ZLogTimeSite_s *next;    /* registry link, set when the scope first ends */
+    const char *file;               /* __FILE__ */
+    const char *func;
+    const char *name;
+    int line;
+    int state;                      /* 0 new, 1 registering, 2 registered */
+    unsigned long runs;
+    unsigned long slowRuns;         /* over the threshold */
+    unsigned long maxUs;
+    unsigned long buckets[Z_CHECK_TIME_BUCKETS];    /* [0] under 1 us, [i] from 2^(i-1) us */
+#ifdef Z_CHECK_HAS_CALLSITES
+    ZLogCallsite_t callsite;        /* switches and counts the slow-run messages */
+#endif
+} ZLogTimeSite_t;
+
+/* A Z_TIME_SCOPE() in progress */
+typedef struct ZLogTimeScope_s
+{
+    ZLogTimeSite_t *site;
+    ZLogLevel_t level;
+    unsigned long thresholdUs;
+    unsigned long long startNs;
+} ZLogTimeScope_t;
+
+typedef void (*ZLogTimeSiteFn_t)(const ZLogTimeSite_t *site, void *context);
+#endif /* Z_CHECK_HAS_TIMING */
+
+#ifdef Z_CHECK_HAS_LOGB
+/* Type tag in front of each Z_LOGB() argument */
+typedef enum ZLogArgType_e
+{
+    Z_ARG_INT = 1,  /* int, and anything narrower */
+    Z_ARG_UINT,     /* unsigned int */
+    Z_ARG_LLONG,    /* long, long long */
+    Z_ARG_ULLONG,   /* unsigned long, unsigned long long */
+    Z_ARG_DOUBLE,   /* float, double, long double */
+    Z_ARG_PTR,      /* any other pointer */
+    Z_ARG_STR,      /* char *: unsigned short length, then the bytes; 0xFFFF for NULL */
+} ZLogArgType_t;
+#endif /* Z_CHECK_HAS_LOGB */
+
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+/* Names of a range of status codes; see Z_STATUS_DOMAIN() */
+typedef struct ZLogStatusDomain_s
+{
+    struct ZLogStatusDomain_s *next;    /* registry link, set by ZLog_StatusDomainAdd() */
+    long first;                         /* code of names[0] */
+    size_t count;
+    const char * const *names;          /* NULL for codes without a name */
+    int added;
+} ZLogStatusDomain_t;
+#endif /* Z_CHECK_HAS_STATUS_NAMES */
+
+#ifdef Z_CHECK_LOGB_IDS
+/* A Z_LOGB() call site in the z_check_sites section; its index there is its ID */
+typedef struct ZLogSite_s
+{
+    const char *format;
+    const char *file;       /* __FILE__ */
+    const char *func;
+    int line;
+} ZLogSite_t;
+#endif /* Z_CHECK_LOGB_IDS */
+
 
 /******************************************************************************
  *                                                      Function declarations */
@@ -257,6 +1074,22 @@ typedef enum ZLogType_e
  */
 void ZLog_Open(const ZLogType_t logType, const ZLogLevel_t logLevel, const char * const moduleName);
 
+/**
+ * \brief Opens the logger on a log file
+ *
+ * \details
+ * Same as ZLog_Open(Z_FILE, ...), but appends to path instead of Z_CHECK_LOG_FILE_PATH.
+ * Falls back to stderr if the file cannot be opened.
+ *
+ * \post Logging is available
+ *
+ * \param[IN]   char * path: File to append to
+ * \param[IN]   ZLogLevel_t logLevel: Desired log level (inclusive)
+ * \param[IN]   char * moduleName: Name of module
+ */
+void ZLog_OpenFile(const char * const path, const ZLogLevel_t logLevel,
+                   const char * const moduleName);
+
 /**
  * \brief Closes and deconstructs the logger
  *
@@ -266,6 +1099,14 @@ void ZLog_Open(const ZLogType_t logType, const ZLogLevel_t logLevel, const char
 void ZLog_Close(void);
 #endif /* Z_CHECK_STATIC_CONFIG */
 
+/**
+ * \brief Push everything logged so far to the sink
+ *
+ * \details
+ * Waits for the writer thread to catch up when async, then flushes the sink's stream.
+ */
+void ZLog_Flush(void);
+
 /**
  * \brief Set the log level
  *
@@ -278,22 +1119,814 @@ void ZLog_LevelSet(const ZLogLevel_t logLevel);
  */
 void ZLog_LevelReset(void);
 
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_WRITE)
 /**
- * \brief Write to the log
+ * \brief Output hook for the Z_WRITE target, supplied by the application
  *
- * \pre Logger must be intialized with ZLog_Open
+ * \details
+ * Called once per record with the whole line, newline included. The buffer is not
+ * NUL-terminated and is only valid for the duration of the call.
  *
- * \param[IN]   ZLogLevel_t level: Error level of message
- * \param[IN]   char * file: File where log is called
- * \param[IN]   int line: Line where log is called
- * \param[IN]   char * func: Function where log is called
- * \param[IN]   char * format: Error message
+ * \param[IN]   char * buf: Line to write
+ * \param[IN]   size_t len: Length of line
  */
-void ZLog(const ZLogLevel_t level, const char * const file, const int line, const char * const func,
-          const char * const format, ...) __attribute__((format(printf, 5, 6))); /* Flawfinder: ignore */
-    /* Warning: use of "printf"
-       "Ignore" justification: seems like a misapplication of the rule. 'printf' is not a function
-       call here, but a function argument attribute. */
+void Z_CHECK_WRITE_FUNC(const char * const buf, const size_t len);
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_CAPTURE)
+/**
+ * \brief Get the lines captured since the start or the last ZLog_CaptureClear()
+ *
+ * \details
+ * The Z_CAPTURE target appends each whole line to a static buffer of Z_CHECK_CAPTURE_SIZE bytes,
+ * so tests can check what was logged without redirecting a descriptor. Lines that do not fit
+ * are counted and dropped. With a size of 0 nothing is kept and lines are only counted: a null
+ * sink, for timing formatting apart from I/O.
+ *
+ * Waits for the writer thread to catch up when async. The text is NUL-terminated and stays
+ * valid, and unchanged, until the next record or ZLog_CaptureClear(); read it while no other
+ * thread logs. Empty with a Z_CHECK_CAPTURE_SIZE of 0.
+ *
+ * \param[OUT]  size_t * len: Set to the length of the text, if not NULL
+ *
+ * \return The captured lines, one after another
+ */
+const char * ZLog_CaptureGet(size_t * const len);
+
+/**
+ * \brief Empty the capture buffer
+ *
+ * \details
+ * Waits for the writer thread to catch up when async, so lines logged before the call are not
+ * captured after it. The counters carry on.
+ */
+void ZLog_CaptureClear(void);
+
+/**
+ * \brief Get the capture sink counters
+ *
+ * \param[OUT]  ZLogCaptureStats_t * stats: Filled with the counters
+ */
+void ZLog_CaptureStatsGet(ZLogCaptureStats_t * const stats);
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)
+/**
+ * \brief Get the network sink counters
+ *
+ * \details
+ * Whole lines are batched into frames of up to Z_CHECK_NET_BATCH bytes for a collector at
+ * Z_CHECK_NET_ADDR:Z_CHECK_NET_PORT, over TCP, or one frame per datagram with Z_CHECK_NET_UDP.
+ * A frame is a 16-byte header, big-endian: the length of what follows the length, the sender's
+ * pid and a sequence number counting frames from 0, then the lines. A frame goes out when the
+ * next line won't fit, when its first line is Z_CHECK_NET_LINGER_MS old, on ZLog_Flush(), and
+ * when the writer thread goes idle.
+ *
+ * The socket never blocks: sealed frames wait in a spool of Z_CHECK_NET_SPOOL bytes while the
+ * collector is slow or down, and connecting is retried, with the delay doubling from
+ * Z_CHECK_NET_RETRY_MS up to Z_CHECK_NET_RETRY_MAX_MS, the next time a line or flush comes
+ * along. After a reconnect, a frame that was partly sent goes again whole, so receivers drop
+ * numbers they have seen; frames lost to a full spool show as gaps. Without acknowledgements,
+ * what the collector's kernel took just before the collector died, or datagrams sent while
+ * nothing listened, are lost too. `tools/zlog_listen.py` is a stand-in collector.
+ *
+ * \param[OUT]  ZLogNetStats_t * stats: Filled with the counters
+ */
+void ZLog_NetStatsGet(ZLogNetStats_t * const stats);
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_JOURNAL)
+/**
+ * \brief Get the journal sink counters
+ *
+ * \details
+ * Entries go to Z_CHECK_JOURNAL_SOCKET in journald's native protocol, one datagram each,
+ * carrying MESSAGE, PRIORITY (the level), SYSLOG_IDENTIFIER (the module), CODE_FILE, CODE_LINE
+ * and CODE_FUNC, and with Z_CHECK_HAS_THREAD_INFO, TID and THREAD_NAME. An entry the socket
+ * won't take as a datagram, or longer than Z_CHECK_JOURNAL_MEMFD_OVER if that is set, goes in
+ * a memory file whose descriptor is passed instead. With Z_CHECK_HAS_ASYNC the writer thread
+ * gathers up to Z_CHECK_JOURNAL_BATCH entries and sends them together when the queue runs dry,
+ * with one sendmmsg() where the C library declares it (_GNU_SOURCE). Entries nobody receives
+ * are counted and dropped. `tools/zlog_journal.py` is a stand-in for journald.
+ *
+ * \param[OUT]  ZLogJournalStats_t * stats: Filled with the counters
+ */
+void ZLog_JournalStatsGet(ZLogJournalStats_t * const stats);
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && defined(Z_CHECK_FILE_DIRECT)
+/**
+ * \brief Get the direct file sink counters
+ *
+ * \details
+ * With Z_CHECK_FILE_DIRECT, lines bypass the page cache, so a busy log does not push the
+ * application's own file data out of it. They gather in a buffer of Z_CHECK_FILE_DIRECT_BUFFER
+ * bytes, aligned to Z_CHECK_FILE_DIRECT_BLOCK, which goes out whole when it fills. When the
+ * oldest line waiting is Z_CHECK_FILE_DIRECT_LINGER_MS old, on ZLog_Flush() and at exit, the
+ * last, partial block is padded with newlines and written too, and the file cut back to its
+ * length; the block is written again once more lines follow, and a crash between the write
+ * and the cut leaves a few blank lines. Logging to an existing file carries on from its end.
+ *
+ * The writer thread does the writing with Z_CHECK_HAS_ASYNC, or else the caller that fills the
+ * buffer. Where the file system refuses O_DIRECT, the same writes go through the page cache,
+ * and the counters say so. A fork()ed child logs to Z_CHECK_LOG_FILE_PATH with '.' and its pid
+ * appended, or the two would write over each other's last block. Linux only, built with
+ * _GNU_SOURCE, under which <fcntl.h> declares O_DIRECT.
+ *
+ * \param[OUT]  ZLogFileDirectStats_t * stats: Filled with the counters
+ */
+void ZLog_FileDirectStatsGet(ZLogFileDirectStats_t * const stats);
+#endif
+
+#if defined(Z_CHECK_FILE_WRITEBACK) && \
+    (!defined(Z_CHECK_STATIC_CONFIG) || (Z_CHECK_LOG_FUNC == Z_FILE))
+/**
+ * \brief Get the file writeback counters
+ *
+ * \details
+ * With Z_CHECK_FILE_WRITEBACK and Z_CHECK_HAS_ASYNC, the buffered Z_FILE sink keeps written
+ * lines from piling up in the page cache, for a lighter touch than Z_CHECK_FILE_DIRECT. The file
+ * is cut into windows of Z_CHECK_FILE_WRITEBACK_WINDOW bytes. Every Z_CHECK_FILE_WRITEBACK_MS,
+ * the writer thread starts writeback of the windows filled since its last pass with
+ * sync_file_range(), then, a pass later, waits for them and drops them with
+ * posix_fadvise(POSIX_FADV_DONTNEED). The window being filled stays in the cache, for readers
+ * following the file, and so does whatever the file held before the sink opened it. A forked
+ * child has no writer thread and leaves its lines to the kernel. Linux only, built with
+ * _GNU_SOURCE, under which <fcntl.h> declares sync_file_range().
+ *
+ * \param[OUT]  ZLogFileWritebackStats_t * stats: Filled with the counters
+ */
+void ZLog_FileWritebackStatsGet(ZLogFileWritebackStats_t * const stats);
+#endif
+
+#if defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_SPOOL)
+/**
+ * \brief Get the ticket of the last line the calling thread logged
+ *
+ * \return unsigned long long: The ticket, for ZLog_SpoolWait(); 0 if the thread has logged
+ *                              nothing, which ZLog_SpoolWait() returns on at once
+ */
+unsigned long long ZLog_SpoolTicket(void) __attribute__((pure));
+
+/**
+ * \brief Wait until the line with a ticket is on stable storage
+ *
+ * \details
+ * The Z_SPOOL target is for lines that must be on disk before the program acts on them. Lines
+ * gather in memory, and a commit thread of the sink's own appends them to the current segment
+ * in Z_CHECK_SPOOL_DIR and calls fdatasync() once for everything that gathered while the last
+ * commit ran. Waiters share commits: each fdatasync() releases every waiter whose line it
+ * covered. Lines before the ticket's are committed by then too, though one of them may have
+ * failed; a failure may be reported for a line that made it, never the other way round.
+ *
+ * Lines nobody waits for are committed within Z_CHECK_SPOOL_COMMIT_MS, or once half of the
+ * Z_CHECK_SPOOL_BUFFER bytes fill up; with the buffer full while the last commit runs, callers
+ * wait rather than drop. ZLog_Flush() waits for everything logged so far. A fork()ed child
+ * commits to segments of its own. Not with Z_CHECK_HAS_ASYNC or the shared ring, which would
+ * take lines away from the thread that waits.
+ *
+ * \param[IN]   unsigned long long ticket: From ZLog_SpoolTicket()
+ *
+ * \return int: 0 once the line is synced, -1 with errno set if its write or sync failed, or
+ *              EINVAL for a ticket not handed out
+ */
+int ZLog_SpoolWait(const unsigned long long ticket);
+
+/**
+ * \brief Get the spool sink counters
+ *
+ * \details
+ * A segment is named by a 16-digit number, NNN.open while written. Once it reaches
+ * Z_CHECK_SPOOL_SEGMENT bytes, at exit, or after a failed write or sync (the next commit goes
+ * to a new one), it is renamed NNN.log and the directory synced. An .open segment no live
+ * process holds is renamed at the next start. A shipper reads .log segments in order and
+ * renames each it has delivered to NNN.shipped; the sink deletes those when it next rolls.
+ * `tools/zlog_ship.py` is such a shipper.
+ *
+ * \param[OUT]  ZLogSpoolStats_t * stats: Filled with the counters
+ */
+void ZLog_SpoolStatsGet(ZLogSpoolStats_t * const stats);
+#endif
+
+#ifdef Z_CHECK_HAS_ARENA
+/**
+ * \brief Get the record arena counters
+ *
+ * \details
+ * With Z_CHECK_HAS_ARENA, a thread claims an arena the first time it needs a block and gives it
+ * back when it exits, through a pthread key destructor, onto a free list that the next new
+ * thread takes from before any untouched arena. Blocks are carved from an arena's static storage
+ * Z_CHECK_ARENA_GROW_STEPS at a time, when its thread runs out, so a thread that logs little
+ * touches a page or two and a busy one grows to the full arena. Z_CHECK_ARENA_BUDGET caps the
+ * bytes carved over all arenas. Memory follows the threads logging at the same time, not every
+ * thread the process ever created.
+ *
+ * Counters are read without stopping other threads, so a snapshot taken while
+ * others log is close but not exact.
+ *
+ * \param[OUT]  ZLogArenaStats_t * stats: Filled with the summed counters
+ */
+void ZLog_ArenaStatsGet(ZLogArenaStats_t * const stats);
+#endif /* Z_CHECK_HAS_ARENA */
+
+#ifdef Z_CHECK_HAS_THREAD_INFO
+/**
+ * \brief Rename the calling thread, for the kernel and in its log lines
+ *
+ * \details
+ * With Z_CHECK_HAS_THREAD_INFO, each line carries the kernel's ID and the name of the thread
+ * that logged it, as "main: [INFO] [4242 worker] file.c:12:func: ...". Both are read once per
+ * thread, on its first record, and kept in thread-local storage; after that a record costs a
+ * TLS load. Async records carry a copy to the writer thread. With Z_CHECK_LOGB_IDS, the name
+ * goes out in a frame ahead of the thread's first record, and trace stamps carry the kernel's
+ * ID, so `tools/zlogb.py` prefixes decoded records the same way and names the threads of a
+ * trace. Linux only; elsewhere the ID is 0 and the name empty.
+ *
+ * Threads renamed some other way (pthread_setname_np(), prctl()) keep the name they had when
+ * they first logged until this is called with NULL.
+ *
+ * \param[IN]   char * name: New name, cut at 15 bytes as the kernel does; NULL to read the
+ *                          current name back from the kernel
+ */
+void ZLog_ThreadNameSet(const char * const name);
+#endif /* Z_CHECK_HAS_THREAD_INFO */
+
+#ifdef Z_CHECK_HAS_ASYNC
+/**
+ * \brief Get the writer thread counters
+ *
+ * \details
+ * With Z_CHECK_HAS_ASYNC, records are formatted into the caller's arena and written by a writer
+ * thread. ZLog_Flush() waits until everything logged so far has been written. After fork(), the
+ * child has no writer thread and writes its records synchronously.
+ *
+ * \param[OUT]  ZLogAsyncStats_t * stats: Filled with the counters
+ */
+void ZLog_AsyncStatsGet(ZLogAsyncStats_t * const stats);
+#endif /* Z_CHECK_HAS_ASYNC */
+
+#ifdef Z_CHECK_HAS_SHARED_RING
+/**
+ * \brief Create the shared ring, before forking the processes that will log through it
+ *
+ * \details
+ * The ring of Z_CHECK_SHARED_RING_SLOTS slots is shared with every child forked after. From
+ * then on, a line in any of them is copied into a slot instead of going to the sink, and one
+ * of them drains the ring with ZLog_SharedRingDrain(). Slots are claimed and published with
+ * atomics, so no process ever waits for another; with the ring full, lines are dropped and
+ * counted. The file, function and message share Z_CHECK_SHARED_RING_DATA bytes; with
+ * Z_CHECK_HAS_THREAD_INFO lines keep the thread that logged them. The ring is an anonymous
+ * shared mapping, so it needs _DEFAULT_SOURCE (or _GNU_SOURCE) for MAP_ANONYMOUS on glibc.
+ * `make prefork` runs forked workers through a ring, killing some.
+ *
+ * \return int: 0 on success (or if the ring already exists), -1 with errno set
+ */
+int ZLog_SharedRingCreate(void);
+
+/**
+ * \brief Hand the lines published to the ring to the sink, and free slots whose writers died
+ *
+ * \details
+ * Call from one process only, every few milliseconds; it never blocks on the writers. Lines go
+ * out in the order their slots were claimed; ZLog_Flush() in that process drains too.
+ *
+ * A process that dies between claiming a slot and publishing it does not wedge the ring: the
+ * slot is freed once the pid recorded in it is gone or a zombie, or, if the claim never got as
+ * far as naming its process, after Z_CHECK_SHARED_RING_STALL_MS. A writer whose claim was taken
+ * that way finds out before it writes to the slot, and counts its line as lost.
+ *
+ * \return unsigned long: Lines handed to the sink
+ */
+unsigned long ZLog_SharedRingDrain(void);
+
+/**
+ * \brief Get the shared ring counters
+ *
+ * \param[OUT]  ZLogSharedRingStats_t * stats: Filled with the counters; zeros without a ring
+ */
+void ZLog_SharedRingStatsGet(ZLogSharedRingStats_t * const stats);
+#endif /* Z_CHECK_HAS_SHARED_RING */
+
+/**
+ * \brief Write to the log
+ *
+ * \pre Logger must be intialized with ZLog_Open
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   char * file: File where log is called
+ * \param[IN]   int line: Line where log is called
+ * \param[IN]   char * func: Function where log is called
+ * \param[IN]   char * format: Error message
+ */
+void ZLog(const ZLogLevel_t level, const char * const file, const int line, const char * const func,
+          const char * const format, ...) __attribute__((format(printf, 5, 6))); /* Flawfinder: ignore */
+    /* Warning: use of "printf"
+       "Ignore" justification: seems like a misapplication of the rule. 'printf' is not a function
+       call here, but a function argument attribute. */
+
+
+/**
+ * \brief Write a message that is already formatted to the log
+ *
+ * \pre Logger must be intialized with ZLog_Open
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   char * file: File where log is called
+ * \param[IN]   int line: Line where log is called
+ * \param[IN]   char * func: Function where log is called
+ * \param[IN]   char * message: Message, written as is
+ */
+void ZLog_Msg(const ZLogLevel_t level, const char * const file, const int line,
+              const char * const func, const char * const message);
+
+/**
+ * \brief Write to the log, followed by ": NAME (errno N)" for errnum
+ *
+ * \details
+ * Called by Z_LOG_ERRNO(). The name comes from ZLog_ErrnoName(), or is left out for numbers it
+ * does not know. errno is set to errnum on return, whatever the sink did to it. Messages are cut
+ * at 511 bytes, suffix included.
+ *
+ * \pre Logger must be intialized with ZLog_Open
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   char * file: File where log is called
+ * \param[IN]   int line: Line where log is called
+ * \param[IN]   char * func: Function where log is called
+ * \param[IN]   int errnum: errno as it was when the call failed
+ * \param[IN]   char * format: Error message
+ */
+void ZLog_Errno(const ZLogLevel_t level, const char * const file, const int line,
+                const char * const func, const int errnum, const char * const format, ...)
+    __attribute__((format(printf, 6, 7))); /* Flawfinder: ignore */
+    /* Warning: use of "printf"
+       "Ignore" justification: an attribute, as on ZLog(). */
+
+/**
+ * \brief Name an errno value
+ *
+ * \param[IN]   int errnum: errno value
+ *
+ * \return The macro's name ("ENOENT"), from a table of the POSIX values; NULL if not there
+ */
+const char * ZLog_ErrnoName(const int errnum) __attribute__((const));
+
+#ifdef Z_CHECK_HAS_STATUS_NAMES
+/**
+ * \brief Write a Z_CHECK() failure: the message, errno if given, and the status with its name
+ *
+ * \details
+ * Called by Z_CHECK() and Z_CHECK_ERRNO(). Appends ": NAME (errno N)" as ZLog_Errno() does when
+ * errnum is not negative, then " [status=N (NAME)]", naming status through ZLog_StatusName().
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   char * file: File where log is called
+ * \param[IN]   int line: Line where log is called
+ * \param[IN]   char * func: Function where log is called
+ * \param[IN]   long status: new_status of the check
+ * \param[IN]   int errnum: errno as it was when the call failed, or -1 for none
+ * \param[IN]   char * format: Error message
+ */
+void ZLog_Check(const ZLogLevel_t level, const char * const file, const int line,
+                const char * const func, const long status, const int errnum,
+                const char * const format, ...)
+    __attribute__((format(printf, 7, 8))); /* Flawfinder: ignore */
+    /* Warning: use of "printf"
+       "Ignore" justification: an attribute, as on ZLog(). */
+
+/**
+ * \brief Register a domain of status names
+ *
+ * \details
+ * With Z_CHECK_HAS_STATUS_NAMES, Z_CHECK() hands new_status to the library too, which adds
+ * " [status=-1 (E_TIMEOUT)]" to the message. Names come from dense tables of codes defined with
+ * Z_STATUS_DOMAIN() and registered here, and are only looked up once the level has passed;
+ * codes in no domain print as " [status=-1]".
+ *
+ * Where domains overlap, the one added last names the code. Adding a domain again does nothing.
+ *
+ * \param[IN]   ZLogStatusDomain_t * domain: Domain from Z_STATUS_DOMAIN(); must stay valid
+ */
+void ZLog_StatusDomainAdd(ZLogStatusDomain_t * const domain);
+
+/**
+ * \brief Name a status code
+ *
+ * \param[IN]   long status: Status code
+ *
+ * \return The code's name in the domains added so far, NULL if none has one
+ */
+const char * ZLog_StatusName(const long status);
+#endif /* Z_CHECK_HAS_STATUS_NAMES */
+
+#ifdef Z_CHECK_HAS_LOGB
+/**
+ * \brief Write a record of serialized arguments to the log
+ *
+ * \details
+ * Called by Z_LOGB(). format must outlive the call (a string literal does); args is copied.
+ *
+ * \pre Logger must be intialized with ZLog_Open
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   char * file: File where log is called
+ * \param[IN]   int line: Line where log is called
+ * \param[IN]   char * func: Function where log is called
+ * \param[IN]   char * format: printf() format for the arguments
+ * \param[IN]   void * args: Tagged arguments, see ZLogArgType_t
+ * \param[IN]   size_t len: Length of args
+ */
+void ZLog_Binary(const ZLogLevel_t level, const char * const file, const int line,
+                 const char * const func, const char * const format, const void * const args,
+                 const size_t len);
+
+/**
+ * \brief Format serialized arguments the way printf() would have
+ *
+ * \param[OUT]  char * buf: Output, always NUL-terminated if size is not 0
+ * \param[IN]   size_t size: Size of buf
+ * \param[IN]   char * format: printf() format for the arguments
+ * \param[IN]   void * args: Tagged arguments, see ZLogArgType_t
+ * \param[IN]   size_t len: Length of args
+ *
+ * \return Length of the full output, as snprintf() would return
+ */
+size_t ZLog_BinaryFormat(char * const buf, const size_t size, const char * const format,
+                         const void * const args, const size_t len);
+#endif /* Z_CHECK_HAS_LOGB */
+
+#ifdef Z_CHECK_LOGB_IDS
+/**
+ * \brief Write a record of serialized arguments as its call site's ID
+ *
+ * \details
+ * With Z_CHECK_LOGB_IDS (static config, Z_WRITE target), each Z_LOGB() call site is laid down in
+ * the z_check_sites section of the binary, and records are written as the site's index there
+ * plus the raw arguments, unformatted. tools/zlogb.py reads the table back from the binary,
+ * keyed by its build-ID, and decodes the log. Formats must be string literals.
+ *
+ * Called by Z_LOGB(). Hands Z_CHECK_WRITE_FUNC one frame per record: 0x1E 'R', the level, the
+ * ID (4 bytes, little-endian), the length of args (2 bytes, little-endian), then args. The first
+ * frame of the process is preceded by 0x1E 'H', the build-ID length and bytes, and the module
+ * name length and bytes. Text lines from Z_LOG() go to the same hook and never start with 0x1E.
+ *
+ * \param[IN]   ZLogLevel_t level: Error level of message
+ * \param[IN]   ZLogSite_t * site: Call site, in the z_check_sites section
+ * \param[IN]   void * args: Tagged arguments, see ZLogArgType_t
+ * \param[IN]   size_t len: Length of args
+ */
+void ZLog_BinarySite(const ZLogLevel_t level, const ZLogSite_t * const site,
+                     const void * const args, const size_t len);
+#endif /* Z_CHECK_LOGB_IDS */
+
+#ifdef Z_CHECK_HAS_TRACE
+/**
+ * \brief Write a span begin or end point
+ *
+ * \details
+ * Called by Z_TRACE_BEGIN() and Z_TRACE_END(). Hands Z_CHECK_WRITE_FUNC a stamp frame, 0x1E 'T',
+ * the thread (4 bytes) and monotonic nanoseconds (8 bytes), followed in the same call by 0x1E,
+ * kind and the site's ID (4 bytes), all little-endian. Text lines and record frames get the
+ * same stamp in front. Threads are numbered from 1 in the order they first write.
+ *
+ * \param[IN]   char kind: 'B' for a begin point, 'E' for an end point
+ * \param[IN]   ZLogSite_t * site: Call site, in the z_check_sites section
+ */
+void ZLog_TraceSpan(const char kind, const ZLogSite_t * const site);
+#endif /* Z_CHECK_HAS_TRACE */
+
+#ifdef Z_CHECK_HAS_CALLSITES
+/**
+ * \brief Switch call sites on or off
+ *
+ * \details
+ * With Z_CHECK_HAS_CALLSITES, each Z_LOG(), Z_CHECK() and Z_LOGB() site carries a static
+ * descriptor with an on/off switch. A site joins the registry the first time it runs, through a
+ * once-flag in the descriptor; nothing runs at startup, however many sites a program or its
+ * shared objects hold. Z_CHECK_HAS_CALLSITE_HITS adds a run counter, an atomic add on every run
+ * that threads logging from one site contend on.
+ *
+ * Applies to the sites that have run so far, and is kept (up to Z_CHECK_CALLSITE_RULES calls)
+ * for sites that run later. The last matching call wins.
+ *
+ * \param[IN]   char * file: Path as in __FILE__, or its last components ("example.c"), NULL
+ *                      for any; must outlive the program's logging (a string literal does)
+ * \param[IN]   int line: Line of the site, 0 for any
+ * \param[IN]   int enabled: 0 to silence the sites, 1 to let them log
+ *
+ * \return Number of sites that have run so far and matched
+ */
+size_t ZLog_CallsiteSet(const char * const file, const int line, const int enabled);
+
+/**
+ * \brief Call fn on each site that has run so far, most recent first
+ *
+ * \param[IN]   ZLogCallsiteFn_t fn: Called with each site and context
+ * \param[IN]   void * context: Passed through to fn
+ */
+void ZLog_CallsiteForEach(const ZLogCallsiteFn_t fn, void * const context);
+
+/* Slow path of ZLog_CallsiteEnabled(): link a site into the registry the first time it runs */
+void ZLog_CallsiteRegister(ZLogCallsite_t * const site);
+
+static inline int ZLog_CallsiteEnabled(ZLogCallsite_t * const site) {
+    if (2 != __atomic_load_n(&site->state, __ATOMIC_ACQUIRE)) {
+        ZLog_CallsiteRegister(site);
+    }
+#ifdef Z_CHECK_HAS_CALLSITE_HITS
+    (void)__atomic_fetch_add(&site->hits, 1, __ATOMIC_RELAXED);
+#endif
+    return __atomic_load_n(&site->enabled, __ATOMIC_RELAXED);
+}
+#endif /* Z_CHECK_HAS_CALLSITES */
+
+#ifdef Z_CHECK_HAS_LOG_COST
+/**
+ * \brief Log the sites that have spent the most cycles in the library, most expensive first
+ *
+ * \details
+ * With Z_CHECK_HAS_LOG_COST as well as Z_CHECK_HAS_CALLSITES, each site reads the CPU's cycle
+ * counter around its call into the library (rdtsc on x86, cntvct_el0 on AArch64) and keeps a
+ * log-bucketed histogram of the difference, four buckets per power of two. Without the option
+ * none of it is compiled.
+ *
+ * One Z_NOTICE line per site: calls, total and mean cycles, and the 50th and 99th percentiles
+ * and maximum. Percentiles are the lower bounds of their histogram buckets, so within 25%.
+ *
+ * \param[IN]   unsigned top: Most sites to list
+ */
+void ZLog_CostReport(const unsigned top);
+
+/* Record one call of a site; called by Z_LOG_COST_END() outside the measured span */
+void ZLog_CostAdd(ZLogCallsite_t * const site, const unsigned long long cycles);
+
+static inline unsigned long long ZLog_Cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    unsigned long long cycles;
+
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(cycles));
+    return cycles;
+#endif
+}
+#endif /* Z_CHECK_HAS_LOG_COST */
+
+
+#if defined(Z_CHECK_HAS_TIMING) || defined(Z_CHECK_HAS_TRACE) || \
+    defined(Z_CHECK_HAS_SHARED_RING) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_NET)) || \
+    (defined(Z_CHECK_STATIC_CONFIG) && (Z_CHECK_LOG_FUNC == Z_FILE) && \
+     (defined(Z_CHECK_FILE_DIRECT) || defined(Z_CHECK_FILE_WRITEBACK))) || \
+    (defined(Z_CHECK_FILE_WRITEBACK) && !defined(Z_CHECK_STATIC_CONFIG))
+/* Monotonic clock behind Z_TIME_SCOPE(), trace stamps and the timers of the ring, Z_NET and
+ * Z_FILE's direct writes and writeback, in ns */
+unsigned long long ZLog_TimeNow(void);
+#endif
+
+#ifdef Z_CHECK_HAS_TIMING
+/**
+ * \brief Call fn on each Z_TIME_SCOPE() site that has run so far, most recent first
+ *
+ * \details
+ * Counters are read without stopping other threads, as for ZLog_ArenaStatsGet().
+ *
+ * \param[IN]   ZLogTimeSiteFn_t fn: Called with each site and context
+ * \param[IN]   void * context: Passed through to fn
+ */
+void ZLog_TimeForEach(const ZLogTimeSiteFn_t fn, void * const context);
+
+/* End of a Z_TIME_SCOPE(): record the run, log it if slow, register the site the first time */
+void ZLog_TimeScopeEnd(ZLogTimeScope_t * const scope);
+
+#ifdef __cplusplus
+/* Z_TIME_SCOPE() for C++, where the destructor ends the scope */
+struct ZLogTimeGuard_s
+{
+    ZLogTimeScope_t scope;
+
+    ZLogTimeGuard_s(ZLogTimeSite_t * const site, const ZLogLevel_t level,
+                    const unsigned long thresholdUs) {
+        scope.site = site;
+        scope.level = level;
+        scope.thresholdUs = thresholdUs;
+        scope.startNs = ZLog_TimeNow();
+    }
+    ~ZLogTimeGuard_s() { ZLog_TimeScopeEnd(&scope); }
+
+private:
+    ZLogTimeGuard_s(const ZLogTimeGuard_s &);               /* one end per scope */
+    ZLogTimeGuard_s &operator=(const ZLogTimeGuard_s &);
+};
+#endif
+#endif /* Z_CHECK_HAS_TIMING */
+
+
+/******************************************************************************
+ *                                                           Header-only mode */
+#ifdef Z_CHECK_HEADER_ONLY
+/* Current level; owned by z_check.c, read here so the check inlines into each call site */
+extern ZLogLevel_t ZLog_currentLevel;
+
+static inline int ZLog_LevelEnabled(const ZLogLevel_t level) {
+    return ((unsigned)level <= (unsigned)ZLog_currentLevel);
+}
+
+#if defined(Z_CHECK_STATIC_CONFIG) && !defined(Z_CHECK_FREESTANDING) && \
+    !defined(Z_CHECK_HAS_ASYNC) && !defined(Z_CHECK_HAS_THREAD_INFO) && \
+    !defined(Z_CHECK_HAS_SHARED_RING) && \
+    ((Z_CHECK_LOG_FUNC == Z_STDOUT) || (Z_CHECK_LOG_FUNC == Z_STDERR))
+/* The sink is known at build time, so constant messages go straight to it; the thread's ID and
+ * name live in the library, so with them lines go through ZLog_Msg(), as with the shared ring */
+static inline void ZLog_MsgInline(const ZLogLevel_t level, const char * const file,
+                                  const int line, const char * const func,
+                                  const char * const message) {
+    static const char * const levelNames[] = { Z_CHECK_LEVEL_NAMES };
+    (void)fprintf((Z_CHECK_LOG_FUNC == Z_STDOUT) ? stdout : stderr, Z_CHECK_LINE_FORMAT,
+                  Z_CHECK_MODULE_NAME, levelNames[level], file, line, func, message);
+}
+#define Z_LOG_MSG ZLog_MsgInline
+#else
+#define Z_LOG_MSG ZLog_Msg
+#endif
+#endif /* Z_CHECK_HEADER_ONLY */
+
+
+/******************************************************************************
+ *                                                             Binary logging */
+#if defined(Z_CHECK_HAS_LOGB) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+/**
+ * \brief Log a message, deferring formatting of its arguments
+ *
+ * \details
+ * Each argument is stored with its type tag, picked by _Generic, into a buffer on the caller's
+ * stack whose size is known at compile time; no formatting happens at the call site. The format
+ * is still checked against the arguments as for printf(). The library formats them where the
+ * record is written, on the writer thread when async. Up to 8 arguments; strings are cut at
+ * Z_CHECK_LOGB_STR_MAX bytes.
+ */
+#define Z_LOGB(level, ...) \
+    do { \
+        Z_CALLSITE(zLogSite_); \
+        if (Z_CALLSITE_ENABLED(zLogSite_) && Z_LOGB_ENABLED(level)) { \
+            Z_LOG_COST_BEGIN(zLogSite_) \
+            unsigned char zLogbArgs_[Z_LOGB_SIZE(__VA_ARGS__)]; \
+            size_t zLogbLen_ = 0; \
+            zLogbArgs_[0] = 0;  /* never read when there are no arguments, but seen as read */ \
+            if (0) { \
+                ZLog_BinaryCheck(__VA_ARGS__); \
+            } \
+            Z_LOGB_EACH(Z_LOGB_PUT_ONE, __VA_ARGS__) \
+            Z_LOGB_WRITE(level, Z_LOG_FIRST(__VA_ARGS__, 0), zLogbArgs_, zLogbLen_); \
+            Z_LOG_COST_END(zLogSite_); \
+        } \
+    } while(0)
+
+#define Z_LOGB_IF(condition, level, ...) \
+    do { \
+        if (condition) { \
+            Z_LOGB(level, __VA_ARGS__); \
+        } \
+    } while(0)
+
+#ifdef NDEBUG
+#define ZD_LOGB(...)            _macro_unused(__VA_ARGS__)
+#define ZD_LOGB_IF(...)         _macro_unused(__VA_ARGS__)
+#else
+#define ZD_LOGB             Z_LOGB
+#define ZD_LOGB_IF          Z_LOGB_IF
+#endif
+
+#ifdef Z_CHECK_LOGB_IDS
+#define Z_LOGB_WRITE(level, format, args, len) \
+    do { \
+        Z_LOG_SITE(zLogbSite_, format); \
+        ZLog_BinarySite(level, &zLogbSite_, args, len); \
+    } while(0)
+#else
+#define Z_LOGB_WRITE(level, format, args, len) \
+    ZLog_Binary(level, __FILENAME__, __LINE__, __func__, format, args, len)
+#endif
+
+#ifdef Z_CHECK_HEADER_ONLY
+#define Z_LOGB_ENABLED(level) ZLog_LevelEnabled(level)
+#else
+#define Z_LOGB_ENABLED(level) 1    /* ZLog_Binary() checks */
+#endif
+
+/* Count the arguments after the format (up to 8; more fails to compile, naming the problem)
+ * and apply a macro to each */
+#define Z_LOGB_CAT_(a, b) a##b
+#define Z_LOGB_CAT(a, b) Z_LOGB_CAT_(a, b)
+#define Z_LOGB_NARGS(...) Z_LOGB_NARGS_(__VA_ARGS__, \
+    TOO_MANY_ARGS, TOO_MANY_ARGS, TOO_MANY_ARGS, TOO_MANY_ARGS, \
+    TOO_MANY_ARGS, TOO_MANY_ARGS, TOO_MANY_ARGS, TOO_MANY_ARGS, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define Z_LOGB_NARGS_(f, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+                      n, ...) n
+#define Z_LOGB_EACH(m, ...) Z_LOGB_CAT(Z_LOGB_EACH_, Z_LOGB_NARGS(__VA_ARGS__))(m, __VA_ARGS__)
+#define Z_LOGB_EACH_0(m, f)
+#define Z_LOGB_EACH_1(m, f, a) m(a)
+#define Z_LOGB_EACH_2(m, f, a, b) m(a) m(b)
+#define Z_LOGB_EACH_3(m, f, a, b, c) m(a) m(b) m(c)
+#define Z_LOGB_EACH_4(m, f, a, b, c, d) m(a) m(b) m(c) m(d)
+#define Z_LOGB_EACH_5(m, f, a, b, c, d, e) m(a) m(b) m(c) m(d) m(e)
+#define Z_LOGB_EACH_6(m, f, a, b, c, d, e, g) m(a) m(b) m(c) m(d) m(e) m(g)
+#define Z_LOGB_EACH_7(m, f, a, b, c, d, e, g, h) m(a) m(b) m(c) m(d) m(e) m(g) m(h)
+#define Z_LOGB_EACH_8(m, f, a, b, c, d, e, g, h, i) m(a) m(b) m(c) m(d) m(e) m(g) m(h) m(i)
+
+/* Bytes each argument takes; the leading 1 is the tag, and keeps an empty buffer legal */
+#define Z_LOGB_STR_SIZE (1 + sizeof(unsigned short) + Z_CHECK_LOGB_STR_MAX)
+#define Z_LOGB_ARG_SIZE(arg) _Generic((arg), \
+    _Bool: 1 + sizeof(int), char: 1 + sizeof(int), signed char: 1 + sizeof(int), \
+    unsigned char: 1 + sizeof(int), short: 1 + sizeof(int), unsigned short: 1 + sizeof(int), \
+    int: 1 + sizeof(int), unsigned: 1 + sizeof(unsigned), \
+    long: 1 + sizeof(long long), unsigned long: 1 + sizeof(long long), \
+    long long: 1 + sizeof(long long), unsigned long long: 1 + sizeof(long long), \
+    float: 1 + sizeof(double), double: 1 + sizeof(double), long double: 1 + sizeof(double), \
+    char *: Z_LOGB_STR_SIZE, const char *: Z_LOGB_STR_SIZE, \
+    default: 1 + sizeof(void *))
+#define Z_LOGB_SIZE_ONE(arg) + Z_LOGB_ARG_SIZE(arg)
+#define Z_LOGB_SIZE(...) (1 Z_LOGB_EACH(Z_LOGB_SIZE_ONE, __VA_ARGS__))
+
+#define Z_LOGB_PUT(buf, off, arg) _Generic((arg), \
+    _Bool: ZLogB_PutInt, char: ZLogB_PutInt, signed char: ZLogB_PutInt, \
+    unsigned char: ZLogB_PutInt, short: ZLogB_PutInt, unsigned short: ZLogB_PutInt, \
+    int: ZLogB_PutInt, unsigned: ZLogB_PutUInt, \
+    long: ZLogB_PutLLong, unsigned long: ZLogB_PutULLong, \
+    long long: ZLogB_PutLLong, unsigned long long: ZLogB_PutULLong, \
+    float: ZLogB_PutDouble, double: ZLogB_PutDouble, long double: ZLogB_PutDouble, \
+    char *: ZLogB_PutStr, const char *: ZLogB_PutStr, \
+    default: ZLogB_PutPtr)((buf), (off), (arg))
+#define Z_LOGB_PUT_ONE(arg) zLogbLen_ = Z_LOGB_PUT(zLogbArgs_, zLogbLen_, (arg));
+
+static inline void ZLog_BinaryCheck(const char * const format, ...)
+    __attribute__((format(printf, 1, 2))); /* Flawfinder: ignore */
+    /* Warning: use of "printf"
+       "Ignore" justification: an attribute, as on ZLog(). */
+static inline void ZLog_BinaryCheck(const char * const format, ...) {
+    UNUSED_VARIABLE(format);
+}
+
+static inline size_t ZLogB_PutInt(unsigned char * const buf, const size_t off, const int value) {
+    buf[off] = (unsigned char)Z_ARG_INT;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutUInt(unsigned char * const buf, const size_t off,
+                                   const unsigned value) {
+    buf[off] = (unsigned char)Z_ARG_UINT;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutLLong(unsigned char * const buf, const size_t off,
+                                    const long long value) {
+    buf[off] = (unsigned char)Z_ARG_LLONG;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutULLong(unsigned char * const buf, const size_t off,
+                                     const unsigned long long value) {
+    buf[off] = (unsigned char)Z_ARG_ULLONG;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutDouble(unsigned char * const buf, const size_t off,
+                                     const double value) {
+    buf[off] = (unsigned char)Z_ARG_DOUBLE;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutPtr(unsigned char * const buf, const size_t off,
+                                  const void * const value) {
+    buf[off] = (unsigned char)Z_ARG_PTR;
+    memcpy(&buf[off + 1], &value, sizeof(value));
+    return off + 1 + sizeof(value);
+}
+
+static inline size_t ZLogB_PutStr(unsigned char * const buf, const size_t off,
+                                  const char * const value) {
+    unsigned short len = 0;
+    unsigned short stored = 0xFFFFu;
+
+    if (NULL != value) {
+        while ((len < Z_CHECK_LOGB_STR_MAX) && ('\0' != value[len])) {
+            len++;
+        }
+        stored = len;
+    }
+    buf[off] = (unsigned char)Z_ARG_STR;
+    memcpy(&buf[off + 1], &stored, sizeof(stored));
+    if (0 < len) {
+        memcpy(&buf[off + 1 + sizeof(stored)], value, len);
+    }
+    return off + 1 + sizeof(stored) + len;
+}
+#endif /* Z_CHECK_HAS_LOGB && C11 */
 
 
 /******************************************************************************
@@ -301,5 +1934,9 @@ void ZLog(const ZLogLevel_t level, const char * const file, const int line, cons
 #ifdef __cplusplus
 }
 #endif
+
+#if defined(Z_CHECK_HEADER_ONLY) && defined(Z_CHECK_IMPLEMENTATION)
+#include "z_check.c"
+#endif
 #endif /* header guard */
 